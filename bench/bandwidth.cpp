@@ -0,0 +1,414 @@
+/**
+ * @file bandwidth.cpp
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief End-to-end read/write bandwidth benchmark for \ref pio::netcdf::file.
+ *
+ * Run under `mpirun`. For every combination of active rank count, variable size, dimensionality, type,
+ * decomposition strategy and wait mode the benchmark writes a fresh file and reads it back, timing the
+ * planning (decomposition), metadata (open/define/inquire) and data (post + wait) phases on every rank.
+ * Results are printed by rank 0 as a JSON array.
+ *
+ * \verbatim
+ * mpirun -n 64 pio-bandwidth --dir /scratch/bench --elements 1048576,16777216 --dims 1,3 --types double,float \
+ *     --strategies distributor,slab --modes independent,collective --output bandwidth.json
+ * \endverbatim
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#include "pio/pio.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+using namespace pio;
+
+namespace
+{
+
+struct options
+{
+    std::string directory = ".";
+    std::string output;
+    std::vector<int> ranks;
+    std::vector<std::size_t> elements = { 1 << 20, 1 << 24 };
+    std::vector<uint32_t> dims = { 1, 2, 3 };
+    std::vector<std::string> types = { "double", "float", "int" };
+    std::vector<std::string> strategies = { "distributor", "slab" };
+    std::vector<std::string> modes = { "independent", "collective" };
+    uint32_t variables = 4;
+    uint32_t repeat = 3;
+};
+
+template<typename T>
+std::vector<T> parse_list(const std::string& arg)
+{
+    std::vector<T> r;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        std::stringstream is(item);
+        T value;
+        is >> value;
+        r.push_back(value);
+    }
+    return r;
+}
+
+options parse(int argc, char** argv, int world)
+{
+    options opt;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string key = argv[i], value = argv[i + 1];
+        if      (key == "--dir")        opt.directory  = value;
+        else if (key == "--output")     opt.output     = value;
+        else if (key == "--ranks")      opt.ranks      = parse_list<int>(value);
+        else if (key == "--elements")   opt.elements   = parse_list<std::size_t>(value);
+        else if (key == "--dims")       opt.dims       = parse_list<uint32_t>(value);
+        else if (key == "--types")      opt.types      = parse_list<std::string>(value);
+        else if (key == "--strategies") opt.strategies = parse_list<std::string>(value);
+        else if (key == "--modes")      opt.modes      = parse_list<std::string>(value);
+        else if (key == "--variables")  opt.variables  = std::stoul(value);
+        else if (key == "--repeat")     opt.repeat     = std::stoul(value);
+    }
+
+    // By default sweep powers of two up to (and including) the full job
+    if (opt.ranks.empty())
+    {
+        for (int r = 1; r < world; r *= 2) opt.ranks.push_back(r);
+        opt.ranks.push_back(world);
+    }
+    return opt;
+}
+
+/// Stop every process when a step fails, timings of a run that carried on would mean nothing
+void fail(const std::string& what)
+{
+    std::cerr << "pio-bandwidth: " << what << std::endl;
+    MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+/// Roughly cubic global shape with the given amount of cells
+std::vector<std::size_t> shape(std::size_t elements, uint32_t dims)
+{
+    std::vector<std::size_t> r(dims);
+    std::size_t remaining = elements;
+    for (uint32_t i = 0; i < dims; i++)
+    {
+        const auto left = dims - i;
+        r[i] = std::max<std::size_t>(1, std::llround(std::pow((double)remaining, 1.0 / left)));
+        if (i == dims - 1) r[i] = std::max<std::size_t>(1, remaining);
+        remaining = std::max<std::size_t>(1, remaining / r[i]);
+    }
+    return r;
+}
+
+/// Timings and byte count of one rank for one phase sequence
+struct sample
+{
+    double planning = 0, metadata = 0, data = 0, bytes = 0;
+};
+
+struct statistics
+{
+    double min, max, mean;
+};
+
+statistics reduce(double value, MPI_Comm comm)
+{
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    statistics s;
+    MPI_Allreduce(&value, &s.min,  1, MPI_DOUBLE, MPI_MIN, comm);
+    MPI_Allreduce(&value, &s.max,  1, MPI_DOUBLE, MPI_MAX, comm);
+    MPI_Allreduce(&value, &s.mean, 1, MPI_DOUBLE, MPI_SUM, comm);
+    s.mean /= size;
+    return s;
+}
+
+std::string to_json(const statistics& s)
+{
+    std::stringstream ss;
+    ss << "{\"min\": " << s.min << ", \"max\": " << s.max << ", \"mean\": " << s.mean << "}";
+    return ss.str();
+}
+
+/// Offsets and counts of the region one rank is responsible for
+struct task
+{
+    uint32_t variable;
+    std::vector<MPI_Offset> offsets, counts;
+};
+
+template<typename _Type>
+std::vector<task>
+plan(const std::string& strategy, const std::vector<std::size_t>& dims, uint32_t variables, MPI_Comm active, bool is_active)
+{
+    std::vector<task> tasks;
+    if (!is_active) return tasks;
+
+    if (strategy == "distributor")
+    {
+        io::distributor dist(active);
+        for (uint32_t i = 0; i < variables; i++)
+        {
+            io::distributor::volume vol;
+            vol.data_index = i;
+            vol.data_type  = _Type::nc;
+            vol.dimensions = dims;
+            dist.data_volumes.push_back(vol);
+        }
+
+        const auto res = dist.get_tasks();
+        if (!res) fail("distributing the variables failed with error " + std::to_string(res.error()));
+        for (const auto& sub : res.value())
+            tasks.push_back(task{ dist.data_volumes[sub.volume_index].data_index, sub.offsets, sub.counts });
+    }
+    else
+    {
+        // Slab decomposition, every variable is split evenly along its slowest dimension
+        int rank, size;
+        MPI_Comm_rank(active, &rank);
+        MPI_Comm_size(active, &size);
+
+        const auto rows = dims[0];
+        const auto begin = rows * rank / size, end = rows * (rank + 1) / size;
+        if (begin == end) return tasks;
+
+        for (uint32_t i = 0; i < variables; i++)
+        {
+            task t;
+            t.variable = i;
+            t.offsets.assign(dims.size(), 0);
+            t.counts.assign(dims.begin(), dims.end());
+            t.offsets[0] = begin;
+            t.counts[0]  = end - begin;
+            tasks.push_back(std::move(t));
+        }
+    }
+    return tasks;
+}
+
+std::size_t cells(const task& t)
+{
+    return std::accumulate(t.counts.begin(), t.counts.end(), std::size_t(1), std::multiplies<std::size_t>());
+}
+
+/// Complete every request, either independently per promise or with one collective wait over all of them
+template<typename _Promise>
+void complete(io::backend& storage, int handle, std::vector<_Promise>& promises, bool collective)
+{
+    if (!collective)
+    {
+        for (const auto& p : promises) p.wait();
+        return;
+    }
+
+    std::vector<int> requests;
+    for (auto& p : promises) requests.push_back(*p.requests());
+    std::vector<int> statuses(requests.size());
+    storage.end_indep_data(handle);
+    const auto err = storage.wait_all(handle, requests.size(), requests.data(), statuses.data());
+    if (err != NC_NOERR) fail(std::string("waiting for the requests failed: ") + ncmpi_strerror(err));
+    for (const auto status : statuses)
+        if (status != NC_NOERR) fail(std::string("a request failed: ") + ncmpi_strerror(status));
+    for (const auto& p : promises) p.completed();
+}
+
+template<typename _Type>
+std::pair<sample, sample>
+run(const std::string& path, const std::vector<std::size_t>& dims, uint32_t variables, const std::string& strategy, bool collective, MPI_Comm active, bool is_active)
+{
+    using T = typename _Type::integral_type;
+    sample write, read;
+
+    const auto name = [](uint32_t i) { return "var" + std::to_string(i); };
+
+    /* WRITE */
+    auto start = MPI_Wtime();
+    const auto tasks = plan<_Type>(strategy, dims, variables, active, is_active);
+    write.planning = read.planning = MPI_Wtime() - start;
+
+    std::vector<std::vector<T>> buffers;
+    for (const auto& t : tasks)
+        buffers.emplace_back(cells(t), static_cast<T>(t.variable + 1));
+
+    std::remove(path.c_str());
+    MPI_Barrier(MPI_COMM_WORLD);
+    {
+        start = MPI_Wtime();
+        netcdf::file<io::access::rw> file(path);
+        if (!file) fail("couldn't create " + path);
+        const auto def = file.define([&]() -> netcdf::result<void>
+        {
+            std::vector<std::string> dim_names;
+            for (uint32_t d = 0; d < dims.size(); d++)
+            {
+                dim_names.push_back("dim" + std::to_string(d));
+                const auto res = file.define_dimension(dim_names.back(), dims[d]);
+                if (!res) return { res.error() };
+            }
+
+            for (uint32_t i = 0; i < variables; i++)
+            {
+                const auto res = file.define_variable<_Type>(name(i), dim_names);
+                if (!res) return { res.error() };
+            }
+            return { };
+        });
+        if (!def) fail("defining " + path + " failed: " + def.error().message());
+        write.metadata = MPI_Wtime() - start;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        start = MPI_Wtime();
+        file.storage().begin_indep_data(file.get_handle());
+
+        std::vector<netcdf::promise<io::access::wo, _Type>> promises;
+        for (uint32_t i = 0; i < tasks.size(); i++)
+        {
+            const auto& t = tasks[i];
+            promises.push_back(file.template write_variable<_Type>(name(t.variable), buffers[i].data(), buffers[i].size(), t.offsets, t.counts));
+            if (!promises.back()) fail("writing " + name(t.variable) + " failed: " + promises.back().error().message());
+            write.bytes += buffers[i].size() * sizeof(T);
+        }
+        complete(file.storage(), file.get_handle(), promises, collective);
+        write.data = MPI_Wtime() - start;
+    }
+
+    /* READ */
+    MPI_Barrier(MPI_COMM_WORLD);
+    {
+        start = MPI_Wtime();
+        netcdf::file<io::access::ro> file(path);
+        if (!file) fail("couldn't open " + path);
+        for (const auto& t : tasks)
+        {
+            const auto info = file.get_variable_info(name(t.variable));
+            if (!info) fail("inquiring " + name(t.variable) + " failed: " + info.error().message());
+        }
+        read.metadata = MPI_Wtime() - start;
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        start = MPI_Wtime();
+        file.storage().begin_indep_data(file.get_handle());
+
+        std::vector<netcdf::promise<io::access::ro, _Type>> promises;
+        for (const auto& t : tasks)
+        {
+            promises.push_back(file.template get_variable_values<_Type>(name(t.variable), t.offsets, t.counts));
+            if (!promises.back()) fail("reading " + name(t.variable) + " failed: " + promises.back().error().message());
+            read.bytes += cells(t) * sizeof(T);
+        }
+        complete(file.storage(), file.get_handle(), promises, collective);
+        read.data = MPI_Wtime() - start;
+    }
+
+    return { write, read };
+}
+
+std::string report(
+    const std::string& operation, const sample& s, const std::string& type, const std::vector<std::size_t>& dims,
+    std::size_t elements, uint32_t variables, const std::string& strategy, const std::string& mode, int ranks, int world)
+{
+    const auto bytes    = reduce(s.bytes, MPI_COMM_WORLD);
+    const auto planning = reduce(s.planning, MPI_COMM_WORLD);
+    const auto metadata = reduce(s.metadata, MPI_COMM_WORLD);
+    const auto data     = reduce(s.data, MPI_COMM_WORLD);
+
+    // Idle ranks would skew the imbalance, so it is measured over the ranks doing I/O
+    const auto total = bytes.mean * world;
+    const auto active_mean = total / ranks;
+
+    std::stringstream ss;
+    ss << "{\"operation\": \"" << operation << "\", \"ranks\": " << ranks << ", \"world\": " << world
+       << ", \"type\": \"" << type << "\", \"dimensions\": " << dims.size() << ", \"shape\": [";
+    for (uint32_t i = 0; i < dims.size(); i++) ss << (i ? ", " : "") << dims[i];
+    ss << "], \"elements\": " << elements << ", \"variables\": " << variables
+       << ", \"strategy\": \"" << strategy << "\", \"mode\": \"" << mode << "\""
+       << ", \"bytes\": " << std::llround(total)
+       << ", \"bandwidth_gbs\": " << (data.max > 0 ? total / data.max / 1e9 : 0.0)
+       << ", \"imbalance\": {\"bytes\": " << (active_mean > 0 ? bytes.max / active_mean : 0.0)
+       << ", \"time\": " << (data.mean > 0 ? data.max / (data.mean * world / ranks) : 0.0) << "}"
+       << ", \"phases\": {\"planning\": " << to_json(planning)
+       << ", \"metadata\": " << to_json(metadata)
+       << ", \"data\": " << to_json(data) << "}}";
+    return ss.str();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+
+    int rank, world;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &world);
+
+    const auto opt = parse(argc, argv, world);
+    const auto path = opt.directory + "/pio-bandwidth.nc";
+
+    std::vector<std::string> records;
+    for (const auto ranks : opt.ranks)
+    {
+        if (ranks > world || ranks < 1) continue;
+
+        // Only the first `ranks` processes do I/O, the rest still take part in the collective calls
+        const bool is_active = rank < ranks;
+        MPI_Comm active;
+        MPI_Comm_split(MPI_COMM_WORLD, is_active, rank, &active);
+
+        for (const auto elements : opt.elements)
+        for (const auto dim_count : opt.dims)
+        for (const auto& type : opt.types)
+        for (const auto& strategy : opt.strategies)
+        for (const auto& mode : opt.modes)
+        {
+            const auto dims = shape(elements, dim_count);
+            const bool collective = (mode == "collective");
+
+            for (uint32_t i = 0; i < opt.repeat; i++)
+            {
+                const auto [write, read] = [&]()
+                {
+                    if (type == "float") return run<types::Float>(path, dims, opt.variables, strategy, collective, active, is_active);
+                    if (type == "int")   return run<types::Int>(path, dims, opt.variables, strategy, collective, active, is_active);
+                    return run<types::Double>(path, dims, opt.variables, strategy, collective, active, is_active);
+                }();
+
+                records.push_back(report("write", write, type, dims, elements, opt.variables, strategy, mode, ranks, world));
+                records.push_back(report("read",  read,  type, dims, elements, opt.variables, strategy, mode, ranks, world));
+            }
+        }
+
+        MPI_Comm_free(&active);
+    }
+
+    if (!rank)
+    {
+        std::remove(path.c_str());
+
+        std::stringstream json;
+        json << "[\n";
+        for (uint32_t i = 0; i < records.size(); i++)
+            json << "  " << records[i] << (i + 1 < records.size() ? ",\n" : "\n");
+        json << "]\n";
+
+        if (opt.output.size()) std::ofstream(opt.output) << json.str();
+        else std::cout << json.str();
+    }
+
+    MPI_Finalize();
+    return 0;
+}
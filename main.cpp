@@ -2,38 +2,23 @@
 
 #include <iostream>
 #include <cassert>
+#include <limits>
 
 #define ASSERT(expr, msg) if (!(expr)) { std::cout << msg << "\n"; assert(expr); }
 using namespace pio;
 using word_t = unsigned long;
 
-void check(const exodus::result<void>& res)
-{
-    ASSERT((bool)res, "Error writing to exodus file: " << res.error().message());
-}
-
 template<typename W>
 void
 write_coloring(
-    const std::string& name,
-    const std::string& input,
-    const uint32_t& dim,
+    netcdf::file<io::access::wo>& file,
     const std::vector<exodus::block<W>>& blocks,
-    const std::vector<std::size_t>& colors)
+    const std::vector<long long>& colors)
 {
     // Calculate the total amount of elements in all the blocks (this should be the same size as colors)
     const auto total_elem = std::accumulate(blocks.begin(), blocks.end(), 0, [](std::size_t a, const exodus::block<W>& block) { return a + block.info.elements; });
     assert(colors.size() == total_elem);
 
-    // Convert from std::size_t to real<W>
-    const auto colorings = [&]() -> std::vector<exodus::real<W>>
-    {
-        std::vector<exodus::real<W>> r(colors.size());
-        for (std::size_t i = 0; i < colors.size(); i++)
-            r[i] = static_cast<exodus::real<W>>(colors[i]) + 1;
-        return r;
-    }();
-
     constexpr nc_type TYPE = (sizeof(W) == 8 ? types::Double::nc : types::Float::nc);
 
     // then we write the block info
@@ -53,74 +38,23 @@ write_coloring(
 
     const auto vols = [&]()
     {
-        const auto res = dist.get_tasks();
+        auto res = dist.get_tasks();
         assert(res);
-        return std::move(res.value());
+        return std::move(res).value();
     }();
 
-    netcdf::file<io::access::rw> file(name);
-    assert(file);
-
-    const auto var_res = file.exodus.get_variables();
-    if (!var_res)
-    {
-        std::cout << "error getting variables: " << var_res.error().message() << "\n";
-        assert(var_res);
-    }
-
-    const auto& names = var_res.value();
-    const auto it = std::find(names.begin(), names.end(), "color");
-    assert(it != names.end());
-    const auto var_index = std::distance(names.begin(), it) + 1;
-
-    // Define the color variable
-    const auto res = file.define([&]() -> netcdf::result<void>
-    {
-        for (const auto& block : blocks)
-        {
-            const auto res = file.define_variable<io::type<TYPE>>("vals_elem_var" + std::to_string(var_index) + "eb" + std::to_string(block.info.id), { "time_step", "num_el_in_blk" + std::to_string(block.info.id) });
-            if (!res) return { res.error() };
-        }
-        return { };
-    });
-
-    if (!res)
-    {
-        std::cout << "error creating var: " << res.error().message() << "\n";
-        assert(res);
-    }
-    
-    // here's where we read/write coordinate information !!!
+    // Look every block's variable up once, instead of by name for every write
+    // Variables are named after the position of the block in the file, not its id
+    std::vector<netcdf::variable_handle> variables;
+    for (std::size_t i = 0; i < blocks.size(); i++)
     {
-        netcdf::file<io::access::ro> in(input);
-        const auto coords = in.exodus.get_node_coordinates();
-        if (!coords)
-        {
-            std::cout << "error reading coords: " << coords.error().message() << "\n";
-            assert(coords);
-        }
-
-        const auto res = file.exodus.write_node_coordinates(MPI_COMM_WORLD, *coords);
-        if (!res)
-        {
-            std::cout << "error writing coords: " << res.error().message() << "\n";
-            assert(res);
-        }
-        else
-        {
-            for (const auto& p : *res) 
-            {
-                p->wait();
-                if (!p->good())
-                {
-                    std::cout << "promise error: " << p->error().message() << "\n";
-                    assert(p->good());
-                }
-            }
-        }
+        auto variable = file.open_variable("vals_elem_var1eb" + std::to_string(i + 1));
+        assert(variable);
+        variables.push_back(std::move(variable).value());
     }
 
-    using promise = netcdf::promise<io::access::wo, io::type<TYPE>>;
+    // The colors are converted to real<W> as they are written
+    using promise = netcdf::promise<io::access::wo, types::Int64>;
     std::vector<promise> promises;
     for (const auto& vol : vols)
     {
@@ -130,7 +64,10 @@ write_coloring(
         for (uint32_t i = 0; i < vol.volume_index; i++)
             index += blocks[i].info.elements;
 
-        const auto p = file.write_variable<io::type<TYPE>>("vals_elem_var1eb" + std::to_string(block.info.id), &colorings[index + vol.offsets[1]], vol.counts[1], vol.offsets, vol.counts);
+        // The colors of this block, shaped like its variable (time_step, num_el_in_blk)
+        const util::view<const long long> block_colors(&colors[index], { 1, (MPI_Offset)block.info.elements });
+
+        const auto p = file.write_variable<types::Int64>(variables[vol.volume_index], block_colors.slice(vol.offsets, vol.counts));
         if (!p)
         {
             std::cout << "error making promise: " << p.error().message() << "\n";
@@ -144,32 +81,32 @@ write_coloring(
         const auto vals = promise.wait();
 }
 
-template<typename W, io::access Access>
+template<typename P>
 void
-write_block(
-    exodus::file<W, Access>& file,
-    typename exodus::block<W>::header block,
-    const std::vector<int>& entity_nodes,
-    const std::vector<int>& entity_node_counts)
+wait_all(const std::vector<P>& promises)
 {
-    block.name = "cell-block-" + std::to_string(block.id);
-    check(file.create_block(block));
-    check(file.set_block_connectivity(block, entity_nodes.data(), entity_nodes.size()));
-    if (block.type == "nsided")
-        check(file.set_entity_count_per_node(block, entity_node_counts.data(), entity_node_counts.size()));
+    for (const auto& p : promises)
+    {
+        p->wait();
+        if (!p->good())
+        {
+            std::cout << "promise error: " << p->error().message() << "\n";
+            assert(p->good());
+        }
+    }
 }
 
 int run()
 {
-    std::vector<std::size_t> colors;
+    std::vector<long long> colors;
 
     const std::string mesh_file = "../box-hex.exo";
     exodus::file<word_t, io::access::ro> md(mesh_file);
     const auto md_info = [&]()
     {
-        const auto res = md.get_info();
+        auto res = md.get_info();
         assert(res);
-        return std::move(res.value());
+        return std::move(res).value();
     }();
 
     const std::string output = [&]()
@@ -179,54 +116,92 @@ int run()
         return mesh_file.substr(0, pos) + "-colors.exo";
     }();
 
-    io::distributor dist(MPI_COMM_WORLD);
-    if (!dist.rank())
+    const auto blocks = [&]()
     {
-        exodus::file<word_t, io::access::wo> file(output, true);
-        if (!file) { std::cout << "Error creating file: \"" << file.error().message() << "\"\n"; return -1; }
-        const auto res = file.set_init_params(md_info);
-        if (!res) { std::cout << "Error setting init: " << res.error().message() << "\n"; return -1; }
-
-        const auto block_res = md.get_blocks();
+        auto block_res = md.get_blocks();
         assert(block_res);
-        const auto& blocks = block_res.value();
+        return std::move(block_res).value();
+    }();
+
+    // Every process lays out the output the same way, so it can be defined collectively
+    netcdf::exodus_schema schema;
+    schema.title = md_info.title;
+    schema.num_nodes = md_info.num_nodes;
+    schema.element_variables = { "color" };
+    schema.double_precision = (sizeof(word_t) == 8);
+
+    const auto coord_res = md.get_coordinate_names();
+    assert(coord_res);
+    schema.coordinates = coord_res.value();
 
-        check(file.set_variable_count(exodus::scope::element, 1));
-        check(file.set_variable_name(exodus::scope::element, "color")); // variable index 1
-        check(file.write_time_step(0));
+    std::vector<std::vector<long long>> connectivity, entity_counts;
+    for (const auto& block : blocks)
+    {
+        const auto conn_res = md.get_block_connectivity(block.info);
+        assert(conn_res);
+        connectivity.emplace_back(conn_res->begin(), conn_res->end());
+
+        // Node numbers that don't fit an int need a 64-bit (CDF-5) output
+        for (const auto node : connectivity.back())
+            if (node > std::numeric_limits<int>::max()) schema.int64 = true;
+
+        const auto poly = md.get_entity_count_per_node(block.info);
+        entity_counts.emplace_back();
+        if (poly) entity_counts.back().assign(poly->begin(), poly->end());
+
+        netcdf::element_block eb;
+        eb.id = block.info.id;
+        eb.type = block.info.type;
+        eb.name = "cell-block-" + std::to_string(block.info.id);
+        eb.elements = block.info.elements;
+        eb.nodes_per_elem = block.info.nodes_per_elem;
+        eb.attributes = 0;
+        schema.blocks.push_back(eb);
+    }
 
-        const auto coord_res = md.get_coordinate_names();
-        assert(coord_res);
-        file.set_coordinate_names(coord_res.value());
+    netcdf::file<io::access::wo> file(output, netcdf::staging(), (schema.int64 ? netcdf::file_format::cdf5 : netcdf::file_format::cdf2));
+    if (!file) { std::cout << "Error creating file: \"" << output << "\"\n"; return -1; }
 
-        // set the block information
-        for (const auto& block : blocks)
+    const auto def_res = file.exodus.define(MPI_COMM_WORLD, schema);
+    if (!def_res) { std::cout << "Error defining file: " << def_res.error().message() << "\n"; return -1; }
+
+    {
+        const auto res = file.exodus.write_block_connectivity(MPI_COMM_WORLD, schema.blocks, connectivity, entity_counts);
+        if (!res) { std::cout << "Error writing connectivity: " << res.error().message() << "\n"; return -1; }
+        for (const auto& p : *res) p.wait();
+    }
+
+    // here's where we read/write coordinate information !!!
+    {
+        netcdf::file<io::access::ro> in(mesh_file);
+        const auto coords = in.exodus.get_node_coordinates();
+        if (!coords)
         {
-            const auto conn_res = md.get_block_connectivity(block.info);
-            assert(conn_res);
-            const auto& conn = conn_res.value();
-            
-            const auto poly = md.get_entity_count_per_node(block.info);
+            std::cout << "error reading coords: " << coords.error().message() << "\n";
+            assert(coords);
+        }
 
-            write_block(file, block.info, conn, ( poly ? poly.value() : std::vector<int>() ));
+        const auto res = file.exodus.write_node_coordinates(MPI_COMM_WORLD, *coords);
+        if (!res)
+        {
+            std::cout << "error writing coords: " << res.error().message() << "\n";
+            assert(res);
         }
+        else wait_all(*res);
     }
 
-    MPI_Barrier(MPI_COMM_WORLD);
-
-    const auto blocks = [&]()
-    { 
-        exodus::file<word_t, io::access::ro> file(output);
-        const auto block_res = file.get_blocks();
-        assert(block_res);
-        return std::move(block_res.value());
-    }();
+    // The single time step
+    {
+        const auto res = file.exodus.write_time_value<types::Double>(MPI_COMM_WORLD, 0, 0.0);
+        assert(res);
+        for (const auto& p : *res) p.wait();
+    }
 
     for (const auto& block : blocks)
         for (uint32_t i = 0; i < block.info.elements; i++)
-            colors.push_back(colors.size());
+            colors.push_back(colors.size() + 1);
 
-    write_coloring<word_t>(output, mesh_file, md_info.num_dim, blocks, colors);
+    write_coloring<word_t>(file, blocks, colors);
 
     return 0;
 }
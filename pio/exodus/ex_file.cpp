@@ -2,6 +2,9 @@
 
 #include "../external.hh"
 
+#include <cctype>
+#include <cstring>
+
 #define FWD_DEC_WRITE_O(word, ret, name, acc, ...) template ret file<word, io::access::acc>::name(__VA_ARGS__)
 #define FWD_DEC_READ_O(word, ret, name, access, ...) FWD_DEC_WRITE_O(word, ret, name, access, __VA_ARGS__) const
 
@@ -14,6 +17,18 @@
 namespace pio::exodus
 {
 
+/// Whether `type` is `name` ignoring case \note `name` is lower case
+static bool type_is(const std::string& type, const char* name)
+{
+    if (type.size() != std::strlen(name)) return false;
+    for (std::size_t i = 0; i < type.size(); i++)
+        if (std::tolower((unsigned char)type[i]) != name[i]) return false;
+    return true;
+}
+
+bool nsided(const std::string& type) { return type_is(type, "nsided"); }
+bool nfaced(const std::string& type) { return type_is(type, "nfaced"); }
+
 error_code::error_code(code c) :
     _code(c),
     _exodus_error(false)
@@ -49,12 +64,13 @@ error_code::_to_string(code c)
     case code::TimeStepIndexOutOfBounds:    return "time step indices start at 1";
     case code::VariableIndexOutOfBounds:    return "variable indices start at 1";
     case code::WrongConnectivityDimensions: return "connectivity should be num_elems_this_blk x num_nodes_per_elem";
-    case code::WrongNodeSize:               return "entity counts should be num_elems_this_blk x num_nodes_per_elem";
+    case code::WrongNodeSize:               return "entity counts should have one entry per element";
     case code::WrongBlockType:              return "block type needs to be \"nsided\"";
     case code::VariableCountNotSet:         return "variable count not set for this scope";
     case code::VariableCountAlreadySet:     return "variable count for this scope has already been assigned";
     case code::ScopeNotSupported:           return "given scope type not supported";
     case code::DimensionSizeMismatch:       return "dimension size mismatch";
+    case code::BlockNotPresent:             return "requested block id not present";
     default: return "Error error";
     }
 }
@@ -67,27 +83,25 @@ file<_Word, _Access>::file(const std::string& filename, bool overwrite) :
     int io_ws = sizeof(_Word);
     float version;
 
-    int flags = 0;
-    //if constexpr (Is64)
-        //flags |= EX_LARGE_MODEL;
+    // 64-bit words pass 64-bit integers through the API, and files created with them store 64-bit integers
+    const int flags = (Is64 ? EX_ALL_INT64_API : 0);
+    const int create_flags = (Is64 ? EX_ALL_INT64_DB | EX_LARGE_MODEL : 0);
 
     if constexpr (_Access == io::access::ro)
         _handle = ex_open(filename.c_str(), flags | EX_READ, &comp_ws, &io_ws, &version); 
     else
     {
-        _handle = ex_create(filename.c_str(), (overwrite ? EX_CLOBBER : EX_NOCLOBBER), &comp_ws, &io_ws);
+        _handle = ex_create(filename.c_str(), flags | create_flags | (overwrite ? EX_CLOBBER : EX_NOCLOBBER), &comp_ws, &io_ws);
         if (_handle < 0)
             _handle = ex_open(filename.c_str(), flags | EX_WRITE, &comp_ws, &io_ws, &version);
     }
 
     _good = (_handle < 0?false:true);
     if (!_good) _err = _handle;
-    //else
-        //if constexpr (Is64)
-            //ex_set_int64_status(_handle, EX_ALL_INT64_DB);
 
 }
 FWD_DEC_ALL(unsigned long, , file, const std::string&, bool);
+FWD_DEC_ALL(unsigned int, , file, const std::string&, bool);
 
 template<typename _Word, io::access _Access>
 file<_Word, _Access>::file(file&& f) :
@@ -96,6 +110,7 @@ file<_Word, _Access>::file(file&& f) :
     f._handle = 0;
 }
 FWD_DEC_ALL(unsigned long, , file, file&&);
+FWD_DEC_ALL(unsigned int, , file, file&&);
 
 template<typename _Word, io::access _Access>
 file<_Word, _Access>::~file()
@@ -103,6 +118,7 @@ file<_Word, _Access>::~file()
     close();
 }
 FWD_DEC_ALL(unsigned long, , ~file);
+FWD_DEC_ALL(unsigned int, , ~file);
 
 template<typename _Word, io::access _Access>
 void file<_Word, _Access>::close()
@@ -114,6 +130,7 @@ void file<_Word, _Access>::close()
     }
 }
 FWD_DEC_ALL(unsigned long, void, close);
+FWD_DEC_ALL(unsigned int, void, close);
 
 #pragma region WRITE
 
@@ -122,8 +139,10 @@ template<typename>
 result<void> 
 file<_Word, _Access>::set_init_params(const info<_Word>& info)
 {
+    PIO_STATS_TIME(metadata);
     if (!good()) return { error_code::FileNotGood };
 
+    _invalidate();
     EXO_CHECK(ex_put_init(
         _handle, 
         info.title.c_str(), 
@@ -137,13 +156,27 @@ file<_Word, _Access>::set_init_params(const info<_Word>& info)
     return { };
 }
 FWD_DEC_WRITE(unsigned long, result<void>, set_init_params, const info<unsigned long>&);
+FWD_DEC_WRITE(unsigned int, result<void>, set_init_params, const info<unsigned int>&);
 
 template<typename _Word, io::access _Access>
 template<typename>
 result<void>
 file<_Word, _Access>::write_time_step(real<_Word> value)
 {
-    if (!good()) return { error_code::FileNotGood };
+    const auto res = write_time_steps(&value, 1);
+    if (!res) return { res.error() };
+    return { };
+}
+FWD_DEC_WRITE(unsigned long, result<void>, write_time_step, double);
+FWD_DEC_WRITE(unsigned int, result<void>, write_time_step, float);
+
+template<typename _Word, io::access _Access>
+template<typename>
+result<integer<_Word>>
+file<_Word, _Access>::write_time_steps(const real<_Word>* values, std::size_t count)
+{
+    // A bare error code would convert to a time step, so the error_code is spelled out
+    if (!good()) return { error_code(error_code::FileNotGood) };
     if (_time_steps < 0)
     {
         if constexpr (_Access == io::access::wo)
@@ -156,10 +189,16 @@ file<_Word, _Access>::write_time_step(real<_Word> value)
         }
     }
 
-    EXO_CHECK(ex_put_time(_handle, _time_steps++, &value));
-    return { };
+    // There is no multi-step ex_put_time, but each call only stores a single value
+    _cache.times.reset();
+    const auto first = _time_steps;
+    for (std::size_t i = 0; i < count; i++)
+        EXO_CHECK(ex_put_time(_handle, _time_steps++, values + i));
+    PIO_STATS_WRITE("time_whole", count * sizeof(real<_Word>));
+    return { integer<_Word>(first) };
 }
-FWD_DEC_WRITE(unsigned long, result<void>, write_time_step, double);
+FWD_DEC_WRITE(unsigned long, result<int64_t>, write_time_steps, const double*, std::size_t);
+FWD_DEC_WRITE(unsigned int, result<int32_t>, write_time_steps, const float*, std::size_t);
 
 template<typename _Word, io::access _Access>
 template<typename>
@@ -167,6 +206,7 @@ result<void>
 file<_Word, _Access>::create_block(
     const typename block<_Word>::header& block)
 {
+    _invalidate();
     EXO_CHECK(ex_put_block(
         _handle, 
         EX_ELEM_BLOCK,
@@ -185,6 +225,7 @@ file<_Word, _Access>::create_block(
     return { };
 }
 FWD_DEC_WRITE(unsigned long, result<void>, create_block, const typename block<unsigned long>::header&);
+FWD_DEC_WRITE(unsigned int, result<void>, create_block, const typename block<unsigned int>::header&);
 
 static std::optional<ex_entity_type> from_scope(scope s)
 {
@@ -220,11 +261,13 @@ file<_Word, _Access>::set_variable_count(
     if (variable_counts.count(s))
         return { error_code::VariableCountAlreadySet };
 
+    _invalidate();
     EXO_CHECK(ex_put_variable_param(_handle, *ex_s, count));
     variable_counts.insert(std::pair(s, count));
     return { };
 }
 FWD_DEC_WRITE(unsigned long, result<void>, set_variable_count, scope, uint32_t);
+FWD_DEC_WRITE(unsigned int, result<void>, set_variable_count, scope, uint32_t);
 
 template<typename _Word, io::access _Access>
 template<typename>
@@ -253,10 +296,12 @@ file<_Word, _Access>::set_variable_names(
     _names.reserve(names.size());
     for (const auto& name : names)
         _names.push_back(const_cast<char*>(name.c_str()));
+    _invalidate();
     EXO_CHECK(ex_put_variable_names(_handle, *ex_s, _names.size(), _names.data()));
     return { };
 }
 FWD_DEC_WRITE(unsigned long, result<void>, set_variable_names, scope, const std::vector<std::string>&);
+FWD_DEC_WRITE(unsigned int, result<void>, set_variable_names, scope, const std::vector<std::string>&);
 
 template<typename _Word, io::access _Access>
 template<typename>
@@ -269,16 +314,17 @@ file<_Word, _Access>::set_variable_name(
     return set_variable_names(s, names);
 }
 FWD_DEC_WRITE(unsigned long, result<void>, set_variable_name, scope, const std::string&);
+FWD_DEC_WRITE(unsigned int, result<void>, set_variable_name, scope, const std::string&);
 
 template<typename _Word, io::access _Access>
 template<typename>
 result<void>
 file<_Word, _Access>::set_block_connectivity(
     const typename block<_Word>::header& block, 
-    const int* connect,
+    const integer<_Word>* connect,
     std::optional<std::size_t> count)
 {
-    if (count && *count != block.nodes_per_elem * block.elements)
+    if (count && *count != (nsided(block.type) ? block.nodes_per_elem : block.nodes_per_elem * block.elements))
         return { error_code::WrongConnectivityDimensions };
     
     EXO_CHECK(ex_put_conn(
@@ -288,10 +334,12 @@ file<_Word, _Access>::set_block_connectivity(
         connect,
         nullptr, nullptr
     ));
+    PIO_STATS_WRITE("connect" + std::to_string(block.id), (nsided(block.type) ? 1 : block.elements) * block.nodes_per_elem * sizeof(integer<_Word>));
 
     return { };
 }
-FWD_DEC_WRITE(unsigned long, result<void>, set_block_connectivity, const typename block<unsigned long>::header&, const int*, std::optional<std::size_t>);
+FWD_DEC_WRITE(unsigned long, result<void>, set_block_connectivity, const typename block<unsigned long>::header&, const int64_t*, std::optional<std::size_t>);
+FWD_DEC_WRITE(unsigned int, result<void>, set_block_connectivity, const typename block<unsigned int>::header&, const int32_t*, std::optional<std::size_t>);
 
 template<typename _Word, io::access _Access>
 template<typename>
@@ -301,10 +349,10 @@ file<_Word, _Access>::set_entity_count_per_node(
     const int* connect,
     std::optional<std::size_t> count)
 {
-    if (block.type != "nsided")
+    if (!nsided(block.type))
         return { error_code::WrongBlockType };
 
-    if (count && *count != block.nodes_per_elem * block.elements)
+    if (count && *count != block.elements)
         return { error_code::WrongNodeSize };
     
     EXO_CHECK(ex_put_entity_count_per_polyhedra(
@@ -313,10 +361,42 @@ file<_Word, _Access>::set_entity_count_per_node(
         block.id,
         connect
     ));
+    PIO_STATS_WRITE("ebepecnt" + std::to_string(block.id), block.elements * sizeof(int));
 
     return { };
 }
 FWD_DEC_WRITE(unsigned long, result<void>, set_entity_count_per_node, const typename block<unsigned long>::header&, const int*, std::optional<std::size_t>);
+FWD_DEC_WRITE(unsigned int, result<void>, set_entity_count_per_node, const typename block<unsigned int>::header&, const int*, std::optional<std::size_t>);
+
+/// The Exodus map of element or node ids
+static std::optional<ex_entity_type> map_from_scope(scope s)
+{
+    switch (s)
+    {
+    case scope::element: return EX_ELEM_MAP;
+    case scope::node:    return EX_NODE_MAP;
+    default: return std::nullopt;
+    }
+}
+
+template<typename _Word, io::access _Access>
+template<typename>
+result<void>
+file<_Word, _Access>::set_id_map(
+    scope _scope, 
+    const std::vector<integer<_Word>>& ids)
+{
+    if (!good()) return { error_code::FileNotGood };
+
+    const auto map = map_from_scope(_scope);
+    if (!map) return { error_code::ScopeNotSupported };
+
+    EXO_CHECK(ex_put_id_map(_handle, *map, ids.data()));
+    PIO_STATS_WRITE((*map == EX_ELEM_MAP ? "elem_num_map" : "node_num_map"), ids.size() * sizeof(integer<_Word>));
+    return { };
+}
+FWD_DEC_WRITE(unsigned long, result<void>, set_id_map, scope, const std::vector<int64_t>&);
+FWD_DEC_WRITE(unsigned int, result<void>, set_id_map, scope, const std::vector<int32_t>&);
 
 template<typename _Word, io::access _Access>
 template<typename>
@@ -348,16 +428,96 @@ file<_Word, _Access>::set_coordinate_names(
     return { };
 }
 FWD_DEC_WRITE(unsigned long, result<void>, set_coordinate_names, const std::vector<std::string>&);
+FWD_DEC_WRITE(unsigned int, result<void>, set_coordinate_names, const std::vector<std::string>&);
+
+template<typename _Word, io::access _Access>
+template<typename>
+result<void>
+file<_Word, _Access>::set_node_coordinates(
+    const coordinates<_Word>& coords)
+{
+    if (!good()) return { error_code::FileNotGood };
+
+    const auto res = _load_info();
+    if (!res) return { res.error() };
+    const auto& [dim, nodes] = std::make_pair(_cache.global->num_dim, _cache.global->num_nodes);
+
+    const std::vector<const std::vector<real<_Word>>*> axes = { &coords.x, &coords.y, &coords.z };
+    for (integer<_Word> i = 0; i < dim && i < 3; i++)
+        if (axes[i]->size() != (std::size_t)nodes) return { error_code::DimensionSizeMismatch };
+
+    EXO_CHECK(ex_put_coord(_handle, coords.x.data(), (dim >= 2 ? coords.y.data() : nullptr), (dim == 3 ? coords.z.data() : nullptr)));
+    PIO_STATS_WRITE("coord", dim * nodes * sizeof(real<_Word>));
+    return { };
+}
+FWD_DEC_WRITE(unsigned long, result<void>, set_node_coordinates, const coordinates<unsigned long>&);
+FWD_DEC_WRITE(unsigned int, result<void>, set_node_coordinates, const coordinates<unsigned int>&);
+
+template<typename _Word, io::access _Access>
+template<typename>
+result<void>
+file<_Word, _Access>::set_block_data(
+    const std::string& name, 
+    integer<_Word> time_step, 
+    const block<_Word>& block)
+{
+    if (!good()) return { error_code::FileNotGood };
+    if (!block.data || !block.data->count(name)) return { error_code::VarNotPresent };
+
+    const auto index = get_variable_index(scope::element, name);
+    if (!index) return { index.error() };
+
+    const auto& values = block.data->at(name);
+    if (values.size() != (std::size_t)block.info.elements) return { error_code::DimensionSizeMismatch };
+
+    EXO_CHECK(ex_put_var(_handle, time_step, EX_ELEM_BLOCK, *index, block.info.id, block.info.elements, values.data()));
+    PIO_STATS_WRITE("vals_elem_var" + std::to_string(*index) + "eb" + std::to_string(block.info.id), values.size() * sizeof(real<_Word>));
+    return { };
+}
+FWD_DEC_WRITE(unsigned long, result<void>, set_block_data, const std::string&, int64_t, const block<unsigned long>&);
+FWD_DEC_WRITE(unsigned int, result<void>, set_block_data, const std::string&, int32_t, const block<unsigned int>&);
+
+template<typename _Word, io::access _Access>
+template<typename>
+result<void>
+file<_Word, _Access>::set_variable_values(
+    scope _scope,
+    integer<_Word> variable,
+    integer<_Word> id,
+    integer<_Word> first_step,
+    std::size_t steps,
+    std::size_t entities,
+    const real<_Word>* values)
+{
+    if (!good()) return { error_code::FileNotGood };
+    if (first_step < 1) return { error_code::TimeStepIndexOutOfBounds };
+    if (variable < 1) return { error_code::VariableIndexOutOfBounds };
+    if (!steps || !entities) return { };
+
+    auto ex_s = from_scope(_scope);
+    if (!ex_s) return { error_code::ScopeNotSupported };
+
+    EXO_CHECK(ex_put_var_multi_time(_handle, *ex_s, variable, (_scope == scope::element ? id : 1), entities, first_step, first_step + steps - 1, values));
+    PIO_STATS_WRITE(
+        (_scope == scope::element ? "vals_elem_var" + std::to_string(variable) + "eb" + std::to_string(id) :
+         _scope == scope::node    ? "vals_nod_var" + std::to_string(variable) : std::string("vals_glo_var")),
+        steps * entities * sizeof(real<_Word>));
+    return { };
+}
+FWD_DEC_WRITE(unsigned long, result<void>, set_variable_values, scope, int64_t, int64_t, int64_t, std::size_t, std::size_t, const double*);
+FWD_DEC_WRITE(unsigned int, result<void>, set_variable_values, scope, int32_t, int32_t, int32_t, std::size_t, std::size_t, const float*);
 
 #pragma endregion WRITE
 
 #pragma region READ
 
 template<typename _Word, io::access _Access>
-template<typename>
-result<info<_Word>>
-file<_Word, _Access>::get_info() const
+result<void>
+file<_Word, _Access>::_load_info() const
 {
+    if (_cache.global) return { };
+
+    PIO_STATS_TIME(metadata);
     info<_Word> i;
     char title[MAX_LINE_LENGTH];
     EXO_CHECK(ex_get_init(
@@ -372,21 +532,141 @@ file<_Word, _Access>::get_info() const
     ));
 
     i.title = std::string(title);
-    return { std::move(i) };
+    _cache.global = std::move(i);
+    return { };
+}
+
+template<typename _Word, io::access _Access>
+result<void>
+file<_Word, _Access>::_load_blocks() const
+{
+    if (_cache.blocks) return { };
+
+    const auto res = _load_info();
+    if (!res) return { res.error() };
+
+    PIO_STATS_TIME(metadata);
+    std::vector<integer<_Word>> ids(_cache.global->num_elem_blk);
+    if (ids.size()) EXO_CHECK(ex_get_ids(_handle, EX_ELEM_BLOCK, ids.data()));
+
+    std::vector<block<_Word>> blocks(ids.size());
+    std::unordered_map<integer<_Word>, std::size_t> index;
+    for (uint32_t i = 0; i < blocks.size(); i++)
+    {
+        char type[MAX_STR_LENGTH];
+        EXO_CHECK(ex_get_block(
+            _handle, 
+            EX_ELEM_BLOCK,
+            ids[i],
+            type,
+            &blocks[i].info.elements,
+            &blocks[i].info.nodes_per_elem,
+            &blocks[i].info.edges_per_entry,
+            &blocks[i].info.faces_per_entry,
+            &blocks[i].info.attributes
+        ));
+
+        blocks[i].info.id = ids[i];
+        blocks[i].info.type = std::string(type);
+
+        char name[MAX_STR_LENGTH];
+        EXO_CHECK(ex_get_name(_handle, EX_ELEM_BLOCK, ids[i], name));
+        if (strlen(name))
+            blocks[i].info.name = std::string(name);
+
+        index.insert(std::pair(ids[i], i));
+    }
+
+    _cache.blocks = std::move(blocks);
+    _cache.block_index = std::move(index);
+    return { };
+}
+
+template<typename _Word, io::access _Access>
+result<void>
+file<_Word, _Access>::_load_variable_names(const scope& _scope) const
+{
+    if (_cache.variable_names.count(_scope)) return { };
+
+    PIO_STATS_TIME(metadata);
+    const char* c = [&]()
+    {
+        switch (_scope)
+        {
+        case scope::element: return "e";
+        case scope::global:  return "g";
+        default: return "n";
+        }
+    }();
+
+    int num_vars;
+    EXO_CHECK(ex_get_var_param(_handle, c, &num_vars));
+
+    // Exodus fills in C strings, so each name gets its own buffer
+    std::vector<std::vector<char>> buffers(num_vars, std::vector<char>(MAX_STR_LENGTH + 1, '\0'));
+    std::vector<char*> pointers;
+    pointers.reserve(num_vars);
+    for (auto& buffer : buffers) pointers.push_back(buffer.data());
+
+    if (num_vars) EXO_CHECK(ex_get_var_names(_handle, c, num_vars, pointers.data()));
+
+    std::vector<std::string> names;
+    std::unordered_map<std::string, integer<_Word>> index;
+    names.reserve(num_vars);
+    for (int i = 0; i < num_vars; i++)
+    {
+        names.emplace_back(buffers[i].data());
+        index.insert(std::pair(names.back(), i + 1));
+    }
+
+    _cache.variable_names.insert(std::pair(_scope, std::move(names)));
+    _cache.variable_index.insert(std::pair(_scope, std::move(index)));
+    return { };
+}
+
+template<typename _Word, io::access _Access>
+result<void>
+file<_Word, _Access>::_load_times() const
+{
+    if (_cache.times) return { };
+
+    PIO_STATS_TIME(metadata);
+    const auto value_count = ex_inquire_int(_handle, EX_INQ_TIME);
+    if (value_count < 0) return { error_code::InquireError };
+
+    std::vector<real<_Word>> time_values(value_count);
+    if (value_count) EXO_CHECK(ex_get_all_times(_handle, &time_values[0]));
+
+    _cache.times = std::move(time_values);
+    return { };
+}
+
+template<typename _Word, io::access _Access>
+template<typename>
+result<info<_Word>>
+file<_Word, _Access>::get_info() const
+{
+    const auto res = _load_info();
+    if (!res) return { res.error() };
+    return { info<_Word>(*_cache.global) };
 }
 FWD_DEC_READ(unsigned long, result<info<unsigned long>>, get_info);
+FWD_DEC_READ(unsigned int, result<info<unsigned int>>, get_info);
 
 template<typename _Word, io::access _Access>
 template<typename>
-result<std::vector<int>>
+result<std::vector<integer<_Word>>>
 file<_Word, _Access>::get_block_connectivity(
     const typename block<_Word>::header& block) const
 {
-    std::vector<int> conn(block.elements * block.nodes_per_elem);
+    // The nodes_per_elem of an nsided block already counts the nodes of the whole block
+    std::vector<integer<_Word>> conn(nsided(block.type) ? block.nodes_per_elem : block.elements * block.nodes_per_elem);
     EXO_CHECK(ex_get_elem_conn(_handle, block.id, conn.data()));
+    PIO_STATS_READ("connect" + std::to_string(block.id), conn.size() * sizeof(integer<_Word>));
     return { std::move(conn) };
 }
-FWD_DEC_READ(unsigned long, result<std::vector<int>>, get_block_connectivity, const typename block<unsigned long>::header&);
+FWD_DEC_READ(unsigned long, result<std::vector<int64_t>>, get_block_connectivity, const typename block<unsigned long>::header&);
+FWD_DEC_READ(unsigned int, result<std::vector<int32_t>>, get_block_connectivity, const typename block<unsigned int>::header&);
 
 template<typename _Word, io::access _Access>
 template<typename>
@@ -394,14 +674,35 @@ result<std::vector<int>>
 file<_Word, _Access>::get_entity_count_per_node(
     const typename block<_Word>::header& block) const
 {
-    if (block.type != "nsided")
+    if (!nsided(block.type))
         return { error_code::WrongBlockType };
     
-    std::vector<int> count(block.nodes_per_elem * block.elements);
+    std::vector<int> count(block.elements);
     EXO_CHECK(ex_get_entity_count_per_polyhedra(_handle, EX_ELEM_BLOCK, block.id, count.data()));
+    PIO_STATS_READ("ebepecnt" + std::to_string(block.id), count.size() * sizeof(int));
     return { std::move(count) };
 }
 FWD_DEC_READ(unsigned long, result<std::vector<int>>, get_entity_count_per_node, const typename block<unsigned long>::header&);
+FWD_DEC_READ(unsigned int, result<std::vector<int>>, get_entity_count_per_node, const typename block<unsigned int>::header&);
+
+template<typename _Word, io::access _Access>
+template<typename>
+result<std::vector<integer<_Word>>>
+file<_Word, _Access>::get_id_map(const scope& _scope) const
+{
+    const auto map = map_from_scope(_scope);
+    if (!map) return { error_code::ScopeNotSupported };
+
+    const auto res = _load_info();
+    if (!res) return { res.error() };
+
+    std::vector<integer<_Word>> ids(*map == EX_ELEM_MAP ? _cache.global->num_elem : _cache.global->num_nodes);
+    if (ids.size()) EXO_CHECK(ex_get_id_map(_handle, *map, ids.data()));
+    PIO_STATS_READ((*map == EX_ELEM_MAP ? "elem_num_map" : "node_num_map"), ids.size() * sizeof(integer<_Word>));
+    return { std::move(ids) };
+}
+FWD_DEC_READ(unsigned long, result<std::vector<int64_t>>, get_id_map, const scope&);
+FWD_DEC_READ(unsigned int, result<std::vector<int32_t>>, get_id_map, const scope&);
 
 template<typename _Word, io::access _Access>
 template<typename>
@@ -419,11 +720,13 @@ file<_Word, _Access>::get_node_coordinates() const
     if (dim >= 2) c.y.resize(nodes);
     if (dim == 3) c.z.resize(nodes);
 
-    const auto err = ex_get_coord(_handle, &c.x[0], &c.y[0], &c.z[0]);
+    const auto err = ex_get_coord(_handle, c.x.data(), (dim >= 2 ? c.y.data() : nullptr), (dim == 3 ? c.z.data() : nullptr));
     if (err < 0) return { exodus_error(err) };
+    PIO_STATS_READ("coord", (c.x.size() + c.y.size() + c.z.size()) * sizeof(real<_Word>));
     return { std::move(c) };
 }
 FWD_DEC_READ(unsigned long, result<coordinates<unsigned long>>, get_node_coordinates);
+FWD_DEC_READ(unsigned int, result<coordinates<unsigned int>>, get_node_coordinates);
 
 
 template<typename _Word, io::access _Access>
@@ -467,102 +770,75 @@ file<_Word, _Access>::get_coordinate_names() const
     return { std::move(r) };
 }
 FWD_DEC_READ(unsigned long, result<std::vector<std::string>>, get_coordinate_names);
+FWD_DEC_READ(unsigned int, result<std::vector<std::string>>, get_coordinate_names);
 
 template<typename _Word, io::access _Access>
 template<typename>
-result<std::vector<_Word>>
+result<std::vector<real<_Word>>>
 file<_Word, _Access>::get_time_values() const
 {
-    const auto value_count = ex_inquire_int(_handle, EX_INQ_TIME);
-    if (value_count < 0) return { error_code::InquireError };
-    if (!value_count)    return { std::vector<_Word>() };
-
-    std::vector<_Word> time_values(value_count);
-    const auto err = ex_get_all_times(_handle, &time_values[0]);
-    if (err < 0) return { exodus_error(err) };
-
-    return { std::move(time_values) };
+    const auto res = _load_times();
+    if (!res) return { res.error() };
+    return { std::vector<real<_Word>>(*_cache.times) };
 }
-FWD_DEC_READ(unsigned long, result<std::vector<unsigned long>>, get_time_values);
+FWD_DEC_READ(unsigned long, result<std::vector<double>>, get_time_values);
+FWD_DEC_READ(unsigned int, result<std::vector<float>>, get_time_values);
 
 template<typename _Word, io::access _Access>
 template<typename>
 result<std::vector<std::string>>
 file<_Word, _Access>::get_variable_names(const scope& _scope) const
 {
-    const char* c = [&]()
-    {
-        switch (_scope)
-        {
-        case scope::element: return "e";
-        case scope::global:  return "g";
-        default: return "n";
-        }
-    }();
-
-    int num_vars;
-    {
-        const auto err = ex_get_var_param(
-            _handle, c, &num_vars
-        );
-        if (err < 0) return { exodus_error(err) };
-    }
-
-    if (!num_vars) return { std::vector<std::string>() };
-    std::vector<std::string> variable_names(num_vars);
-    for (auto& v : variable_names) v.resize(MAX_STR_LENGTH + 1);
+    const auto res = _load_variable_names(_scope);
+    if (!res) return { res.error() };
+    return { std::vector<std::string>(_cache.variable_names.at(_scope)) };
+}
+FWD_DEC_READ(unsigned long, result<std::vector<std::string>>, get_variable_names, const scope&);
+FWD_DEC_READ(unsigned int, result<std::vector<std::string>>, get_variable_names, const scope&);
 
-    const auto err = ex_get_var_names(
-        _handle, c, num_vars, (char**)&variable_names[0]
-    );
-    if (err < 0) return { exodus_error(err) };
+template<typename _Word, io::access _Access>
+template<typename>
+result<integer<_Word>>
+file<_Word, _Access>::get_variable_index(const scope& _scope, const std::string& name) const
+{
+    const auto res = _load_variable_names(_scope);
+    if (!res) return { res.error() };
 
-    // Possibly make variable names a char[][] and then construct the vector
-    // using the std::string constructor on each char[]
-    for (auto& v : variable_names) v.shrink_to_fit();
-    return { std::move(variable_names) };
+    const auto& index = _cache.variable_index.at(_scope);
+    // A bare error code would convert to an index, so the error_code is spelled out
+    const auto it = index.find(name);
+    if (it == index.end()) return { error_code(error_code::VarNotPresent) };
+    return { integer<_Word>(it->second) };
 }
-FWD_DEC_READ(unsigned long, result<std::vector<std::string>>, get_variable_names, const scope&);
+FWD_DEC_READ(unsigned long, result<int64_t>, get_variable_index, const scope&, const std::string&);
+FWD_DEC_READ(unsigned int, result<int32_t>, get_variable_index, const scope&, const std::string&);
 
 template<typename _Word, io::access _Access>
 template<typename>
 result<std::vector<block<_Word>>>
 file<_Word, _Access>::get_blocks() const
 {
-   const auto res = get_info();
-   if (!res) return { res.error() } ;
-
-    std::vector<int> ids(res.value().num_elem_blk);
-    EXO_CHECK(ex_get_ids(_handle, EX_ELEM_BLOCK, ids.data()));
-
-    std::vector<block<_Word>> blocks(ids.size());
-    for (uint32_t i = 0; i < blocks.size(); i++)
-    {
-        ex_block block{0};
-        char type[MAX_STR_LENGTH];
-        EXO_CHECK(ex_get_block(
-            _handle, 
-            EX_ELEM_BLOCK,
-            ids[i],
-            type,
-            &blocks[i].info.elements,
-            &blocks[i].info.nodes_per_elem,
-            &blocks[i].info.edges_per_entry,
-            &blocks[i].info.faces_per_entry,
-            &blocks[i].info.attributes
-        ));
+    const auto res = _load_blocks();
+    if (!res) return { res.error() };
+    return { std::vector<block<_Word>>(*_cache.blocks) };
+}
+FWD_DEC_READ(unsigned long, result<std::vector<block<unsigned long>>>, get_blocks);
+FWD_DEC_READ(unsigned int, result<std::vector<block<unsigned int>>>, get_blocks);
 
-        blocks[i].info.id = ids[i];
-        blocks[i].info.type = std::string(type);
+template<typename _Word, io::access _Access>
+template<typename>
+result<typename block<_Word>::header>
+file<_Word, _Access>::get_block_header(integer<_Word> id) const
+{
+    const auto res = _load_blocks();
+    if (!res) return { res.error() };
 
-        char name[MAX_STR_LENGTH];
-        EXO_CHECK(ex_get_name(_handle, EX_ELEM_BLOCK, ids[i], name));
-        if (strlen(name))
-            blocks[i].info.name = std::string(name);
-    }
-    return { std::move(blocks) };
+    const auto it = _cache.block_index.find(id);
+    if (it == _cache.block_index.end()) return { error_code::BlockNotPresent };
+    return { block_header((*_cache.blocks)[it->second].info) };
 }
-FWD_DEC_READ(unsigned long, result<std::vector<block<unsigned long>>>, get_blocks);
+FWD_DEC_READ(unsigned long, result<typename block<unsigned long>::header>, get_block_header, int64_t);
+FWD_DEC_READ(unsigned int, result<typename block<unsigned int>::header>, get_block_header, int32_t);
 
 template<typename _Word, io::access _Access>
 template<typename>
@@ -572,83 +848,58 @@ file<_Word, _Access>::get_block_data(
     integer<_Word> time_step, 
     block<_Word>& block) const
 {
-    const auto var_names_res = get_variable_names(scope::element);
-    if (!var_names_res) return { var_names_res.error() };
-
-    const auto& var_names = var_names_res.value();
-
-    int index = -1;
-    for (int i = 0; i < var_names.size(); i++)
-        if (var_names[i] == name)
-        {
-            index = i;
-            break;
-        }
-    
-    if (index == -1) return { error_code::VarNotPresent };
+    const auto index = get_variable_index(scope::element, name);
+    if (!index) return { index.error() };
 
     // If there is no data at all, construct the map
     if (!block.data.has_value()) block.data.emplace();
-    auto& map = block.data.value();
+    auto& vec = (*block.data)[name];
+    vec.resize(block.info.elements);
 
-    // If the map is missing the variable name construct the vector
-    // otherwise reset the memory
-    if (!map.count(name)) map.insert(std::pair(name, std::vector<_Word>()));
-    else map.at(name).clear();
-
-    auto& vec = map.at(name);
-    const auto err = ex_get_var(_handle, time_step, EX_ELEM_BLOCK, index, block.info.id, block.info.elements, vec.data());
+    const auto err = ex_get_var(_handle, time_step, EX_ELEM_BLOCK, *index, block.info.id, block.info.elements, vec.data());
     if (err < 0) return { exodus_error(err) };
+    PIO_STATS_READ("vals_elem_var" + std::to_string(*index) + "eb" + std::to_string(block.info.id), vec.size() * sizeof(real<_Word>));
     return { };
 }
 FWD_DEC_READ(unsigned long, result<void>, get_block_data, const std::string&, int64_t, block<unsigned long>&);
+FWD_DEC_READ(unsigned int, result<void>, get_block_data, const std::string&, int32_t, block<unsigned int>&);
 
 template<typename _Word, io::access _Access>
 template<typename>
-result<std::vector<std::vector<_Word>>>
+result<std::vector<std::vector<real<_Word>>>>
 file<_Word, _Access>::get_element_variable_values(
     const integer<_Word> time_step, 
     const integer<_Word> var_ind) const
 {
-    const auto time_step_res = get_time_values();
-    if (!time_step_res) return { time_step_res.error() };
-    const auto& time_steps = time_step_res.value();
-
-    if (time_step > time_steps.size()) return { error_code::TimeStepNotPresent };
     if (!time_step) return { error_code::TimeStepIndexOutOfBounds };
     if (!var_ind)   return { error_code::VariableIndexOutOfBounds };
 
-    const auto res = get_info();
-    if (!res) return { res.error() };
-
-    const auto& info = res.value();
-
-    std::vector<std::vector<_Word>> ret;
-    if (!info.num_elem_blk) return { std::move(ret) };
-
-    ret.resize(info.num_elem_blk);
+    {
+        const auto res = _load_times();
+        if (!res) return { res.error() };
+        if (time_step > _cache.times->size()) return { error_code::TimeStepNotPresent };
+    }
 
-    std::vector<int> ids(info.num_elem_blk);
-    auto error = ex_get_elem_blk_ids(_handle, ids.data());
-    if (error < 0) return { exodus_error(error) };
+    const auto res = _load_blocks();
+    if (!res) return { res.error() };
+    const auto& blocks = *_cache.blocks;
 
-    for (uint32_t i = 0; i < info.num_elem_blk; i++)
+    std::vector<std::vector<real<_Word>>> ret(blocks.size());
+    for (uint32_t i = 0; i < blocks.size(); i++)
     {
-        char elem_type[MAX_STR_LENGTH];
-        int num_elem_this_blk, num_nodes_per_elem, num_attr;
-
-        error = ex_get_elem_block(_handle, ids[i], elem_type, &num_elem_this_blk, &num_nodes_per_elem, &num_attr);
-        if (error < 0) return { exodus_error(error) };
+        const auto& info = blocks[i].info;
+        if (!info.elements) continue;
 
-        if (!num_elem_this_blk) continue;
-        ret[i].resize(num_elem_this_blk);
-        error = ex_get_elem_var(_handle, time_step, var_ind, ids[i], num_elem_this_blk, ret[i].data());
+        ret[i].resize(info.elements);
+        const auto error = ex_get_elem_var(_handle, time_step, var_ind, info.id, info.elements, ret[i].data());
         if (error < 0) return { exodus_error(error) };
+        PIO_STATS_READ("vals_elem_var" + std::to_string(var_ind) + "eb" + std::to_string(info.id), ret[i].size() * sizeof(real<_Word>));
     }
 
     return { std::move(ret) };
 }
-FWD_DEC_READ(unsigned long, result<std::vector<std::vector<unsigned long>>>, get_element_variable_values, const int64_t, const int64_t);
+FWD_DEC_READ(unsigned long, result<std::vector<std::vector<double>>>, get_element_variable_values, const int64_t, const int64_t);
+FWD_DEC_READ(unsigned int, result<std::vector<std::vector<float>>>, get_element_variable_values, const int32_t, const int32_t);
 
 #pragma endregion READ
 
@@ -51,7 +51,7 @@ namespace pio::exodus
             integer<_Word> id, elements, nodes_per_elem, attributes, edges_per_entry, faces_per_entry;
         } info;
         // change this to span
-        std::optional<std::unordered_map<std::string, std::vector<_Word>>> data; /// Data map of variables to data
+        std::optional<std::unordered_map<std::string, std::vector<real<_Word>>>> data; /// Data map of variables to data
     };
 
     /// Basic storage for errors, contains both PIO errors and pnetcdf errors
@@ -72,7 +72,8 @@ namespace pio::exodus
             VariableCountNotSet,
             VariableCountAlreadySet,
             ScopeNotSupported,
-            DimensionSizeMismatch
+            DimensionSizeMismatch,
+            BlockNotPresent
         };
 
         /**
@@ -110,7 +111,24 @@ namespace pio::exodus
     template<typename T>
     using result = io::result<T, error_code>;
 
-    /// Exodus file
+    /// Whether a block type names arbitrary polygons, whose connectivity is stored flat along with a node count per element \note case-insensitive, like libexodus
+    bool nsided(const std::string& type);
+
+    /// Whether a block type names arbitrary polyhedra, whose elements are made of faces \note case-insensitive, like libexodus
+    bool nfaced(const std::string& type);
+
+    /** \brief Exodus file
+     *
+     * The word size picks the width of everything in the file: with an 8-byte `_Word` ids, maps, counts and
+     * connectivity are 64-bit integers (both in memory and in the file) and reals are doubles, with a 4-byte
+     * `_Word` they are 32-bit integers and floats. Exodus converts reals as they are read, so a 4-byte instance
+     * can read a double precision file into half the memory.
+     *
+     * The global info, block headers, variable names and time values are read once, the first time something
+     * asks for them, and kept in memory until a write changes them. Reading many variables over many time steps
+     * then costs one metadata crawl instead of one per call.
+     * \note because of the cache, a single instance shouldn't be read from several threads at once
+     */
     template<typename _Word, io::access _Access>
     struct file
     {
@@ -139,6 +157,10 @@ namespace pio::exodus
         WRITE result<void>
         write_time_step(real<_Word> value);
 
+        /// Append `count` time steps to the file \return the index (starting at 1) of the first one
+        WRITE result<integer<_Word>>
+        write_time_steps(const real<_Word>* values, std::size_t count);
+
         /// Create a block from a block header
         WRITE result<void>
         create_block(const block_header& block);
@@ -157,28 +179,53 @@ namespace pio::exodus
 
         /// Set the connectivity for given block. \note count is optional but strongly recommended for error checking
         WRITE result<void>
-        set_block_connectivity(const block_header& block, const int* connect, std::optional<std::size_t> count = std::nullopt);
+        set_block_connectivity(const block_header& block, const integer<_Word>* connect, std::optional<std::size_t> count = std::nullopt);
 
         /// Set the entity count per node for polyhedra. \note count is optional but strongly recommended for error checking \note only needed if block type is "nsided"
         WRITE result<void>
         set_entity_count_per_node(const block_header& block, const int* connect, std::optional<std::size_t> count  = std::nullopt);
 
+        /// Set the user-facing ids of the elements or nodes (`_scope` is \ref scope::element or \ref scope::node)
+        WRITE result<void>
+        set_id_map(scope _scope, const std::vector<integer<_Word>>& ids);
+
         WRITE result<void>
         set_coordinate_names(const std::vector<std::string>& names);
 
+        /// Write the node coordinates \note only the first `num_dim` of x, y and z are written
+        WRITE result<void>
+        set_node_coordinates(const coordinates<_Word>& coords);
+
+        /// Write the values of an element variable on a block at a time step (starting at 1)
+        /// \param name name of the variable, the values are taken from `block.data`
+        WRITE result<void>
+        set_block_data(const std::string& name, integer<_Word> time_step, const block<_Word>& block);
+
+        /// Write a variable over consecutive time steps in one request
+        /// \param id id of the block for \ref scope::element, ignored otherwise
+        /// \param entities number of values per time step (elements in the block, nodes or global variables)
+        /// \param values `steps` rows of `entities` values
+        /// \note a global "variable" is the whole row of global variables, so `variable` should be 1
+        WRITE result<void>
+        set_variable_values(scope _scope, integer<_Word> variable, integer<_Word> id, integer<_Word> first_step, std::size_t steps, std::size_t entities, const real<_Word>* values);
+
         /* READ/READ-WRITE */
         /// Get global meta-data
         READ result<info<_Word>>
         get_info() const;
 
         /// Get the connectivity of given block
-        READ result<std::vector<int>>
+        READ result<std::vector<integer<_Word>>>
         get_block_connectivity(const block_header& block) const;
         
-        /// Get the polyhedra entity count for given block
+        /// Get the polyhedra entity count for given block \note the counts are `int` whatever the word size, as in libexodus
         READ result<std::vector<int>>
         get_entity_count_per_node(const block_header& block) const;
 
+        /// Get the user-facing ids of the elements or nodes (`_scope` is \ref scope::element or \ref scope::node)
+        READ result<std::vector<integer<_Word>>>
+        get_id_map(const scope& _scope) const;
+
         /// Get the coordinate information
         READ result<coordinates<_Word>>
         get_node_coordinates() const;
@@ -187,7 +234,7 @@ namespace pio::exodus
         get_coordinate_names() const;
 
         /// Get all the time-step values
-        READ result<std::vector<_Word>>
+        READ result<std::vector<real<_Word>>>
         get_time_values() const;
 
         /// Get all the variable names for a given scope
@@ -198,19 +245,47 @@ namespace pio::exodus
         READ result<std::vector<block<_Word>>>
         get_blocks() const;
 
+        /// Get the header of the block with the given id
+        READ result<block_header>
+        get_block_header(integer<_Word> id) const;
+
+        /// Get the index (starting at 1) of a variable by name
+        READ result<integer<_Word>>
+        get_variable_index(const scope& _scope, const std::string& name) const;
+
         /// Get the variable data for a block
         /// @param name name of the variable
         READ result<void>
         get_block_data(const std::string& name, integer<_Word> time_step, block<_Word>& block) const;
 
         /// Get the raw variable data
-        READ result<std::vector<std::vector<_Word>>>
+        READ result<std::vector<std::vector<real<_Word>>>>
         get_element_variable_values(const integer<_Word> time_step, const integer<_Word> var_ind) const;
 
     private:
+        /// Metadata loaded on first use
+        struct metadata
+        {
+            std::optional<exodus::info<_Word>> global;
+            std::optional<std::vector<block<_Word>>> blocks;             /// Block headers in file order
+            std::unordered_map<integer<_Word>, std::size_t> block_index; /// Block id to position in `blocks`
+            std::unordered_map<scope, std::vector<std::string>> variable_names;
+            std::unordered_map<scope, std::unordered_map<std::string, integer<_Word>>> variable_index; /// Name to index (starting at 1)
+            std::optional<std::vector<real<_Word>>> times;
+        };
+
+        result<void> _load_info() const;
+        result<void> _load_blocks() const;
+        result<void> _load_variable_names(const scope& _scope) const;
+        result<void> _load_times() const;
+
+        /// Forget cached metadata after a write
+        void _invalidate() { _cache = metadata(); }
+
         int _handle, _err;
         bool _good;
         integer<_Word> _time_steps = -1, _block_counter = 1;
         std::unordered_map<scope, uint32_t> variable_counts;
+        mutable metadata _cache;
     };
 }
\ No newline at end of file
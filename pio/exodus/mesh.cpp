@@ -0,0 +1,264 @@
+#include "mesh.hh"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace pio::exodus
+{
+
+template<typename _Word, io::access _Access>
+result<connectivity<_Word>>
+load_connectivity(const file<_Word, _Access>& file, ordering order)
+{
+    if (!file) return { error_code::FileNotGood };
+
+    const auto info = file.get_info();
+    if (!info) return { info.error() };
+
+    const auto blocks = file.get_blocks();
+    if (!blocks) return { blocks.error() };
+
+    connectivity<_Word> mesh;
+    mesh.nodes = info->num_nodes;
+    mesh.offsets.reserve(info->num_elem + 1);
+    mesh.offsets.push_back(0);
+
+    for (const auto& block : *blocks)
+    {
+        mesh.block_offsets.push_back(mesh.elements());
+        if (!block.info.elements) continue;
+        if (nfaced(block.info.type)) return { error_code::WrongBlockType };
+
+        const auto conn = file.get_block_connectivity(block.info);
+        if (!conn) return { conn.error() };
+
+        if (nsided(block.info.type))
+        {
+            const auto counts = file.get_entity_count_per_node(block.info);
+            if (!counts) return { counts.error() };
+            for (const auto count : *counts) mesh.offsets.push_back(mesh.offsets.back() + count);
+        }
+        else
+            for (integer<_Word> e = 0; e < block.info.elements; e++)
+                mesh.offsets.push_back(mesh.offsets.back() + block.info.nodes_per_elem);
+
+        if ((std::size_t)mesh.offsets.back() != mesh.indices.size() + conn->size()) return { error_code::WrongConnectivityDimensions };
+        for (const auto node : *conn) mesh.indices.push_back(node - 1);
+    }
+    mesh.block_offsets.push_back(mesh.elements());
+
+    switch (order)
+    {
+    case ordering::rcm: reorder_rcm(mesh); break;
+    case ordering::morton:
+    {
+        const auto coords = file.get_node_coordinates();
+        if (!coords) return { coords.error() };
+        reorder_morton(mesh, *coords);
+        break;
+    }
+    default: break;
+    }
+
+    return { std::move(mesh) };
+}
+
+/// Rebuild the mesh with new node numbers and a new element order
+/// \param node_order file index of each new node
+/// \param element_order file index of each new element (a permutation within every block)
+template<typename _Word>
+static void apply(connectivity<_Word>& mesh, std::vector<integer<_Word>> node_order, std::vector<integer<_Word>> element_order)
+{
+    std::vector<integer<_Word>> new_index(mesh.nodes);
+    for (std::size_t i = 0; i < node_order.size(); i++) new_index[node_order[i]] = i;
+
+    std::vector<integer<_Word>> offsets, indices;
+    offsets.reserve(mesh.offsets.size());
+    indices.reserve(mesh.indices.size());
+    offsets.push_back(0);
+    for (const auto e : element_order)
+    {
+        for (const auto node : mesh.element(e)) indices.push_back(new_index[node]);
+        offsets.push_back(indices.size());
+    }
+
+    // Compose with an earlier renumbering, so the orders always point into the file
+    if (!mesh.node_order.empty())
+        for (auto& n : node_order) n = mesh.node_order[n];
+    if (!mesh.element_order.empty())
+        for (auto& e : element_order) e = mesh.element_order[e];
+
+    mesh.offsets = std::move(offsets);
+    mesh.indices = std::move(indices);
+    mesh.node_order = std::move(node_order);
+    mesh.element_order = std::move(element_order);
+}
+
+/// Sort the elements of each block by `key`, keeping the blocks where they are
+template<typename _Word, typename _Key>
+static std::vector<integer<_Word>> sort_within_blocks(const connectivity<_Word>& mesh, const std::vector<_Key>& key)
+{
+    std::vector<integer<_Word>> order(mesh.elements());
+    std::iota(order.begin(), order.end(), 0);
+    for (std::size_t b = 0; b + 1 < mesh.block_offsets.size(); b++)
+        std::stable_sort(order.begin() + mesh.block_offsets[b], order.begin() + mesh.block_offsets[b + 1],
+            [&](integer<_Word> a, integer<_Word> c) { return key[a] < key[c]; });
+    return order;
+}
+
+template<typename _Word>
+void reorder_rcm(connectivity<_Word>& mesh)
+{
+    using index = integer<_Word>;
+    const std::size_t nodes = mesh.nodes;
+
+    // The elements around each node, also in CSR form
+    std::vector<index> node_offsets(nodes + 1, 0), node_elements(mesh.indices.size());
+    for (const auto node : mesh.indices) node_offsets[node + 1]++;
+    std::partial_sum(node_offsets.begin(), node_offsets.end(), node_offsets.begin());
+    {
+        auto fill = node_offsets;
+        for (std::size_t e = 0; e < mesh.elements(); e++)
+            for (const auto node : mesh.element(e)) node_elements[fill[node]++] = e;
+    }
+
+    // The element count stands in for the degree, it orders neighbours just as well and costs nothing
+    const auto degree = [&](index n) { return node_offsets[n + 1] - node_offsets[n]; };
+
+    std::vector<index> order;
+    order.reserve(nodes);
+    std::vector<bool> visited(nodes, false);
+    std::vector<index> by_degree(nodes), neighbours;
+    std::iota(by_degree.begin(), by_degree.end(), 0);
+    std::stable_sort(by_degree.begin(), by_degree.end(), [&](index a, index b) { return degree(a) < degree(b); });
+
+    // Breadth-first from the lowest degree node of every connected component
+    for (const auto start : by_degree)
+    {
+        if (visited[start]) continue;
+        visited[start] = true;
+        std::size_t head = order.size();
+        order.push_back(start);
+
+        while (head < order.size())
+        {
+            const auto node = order[head++];
+            neighbours.clear();
+            for (index i = node_offsets[node]; i < node_offsets[node + 1]; i++)
+                for (const auto other : mesh.element(node_elements[i]))
+                    if (!visited[other])
+                    {
+                        visited[other] = true;
+                        neighbours.push_back(other);
+                    }
+
+            std::stable_sort(neighbours.begin(), neighbours.end(), [&](index a, index b) { return degree(a) < degree(b); });
+            order.insert(order.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+
+    std::vector<index> new_index(nodes);
+    for (std::size_t i = 0; i < nodes; i++) new_index[order[i]] = i;
+
+    std::vector<index> lowest(mesh.elements(), std::numeric_limits<index>::max());
+    for (std::size_t e = 0; e < mesh.elements(); e++)
+        for (const auto node : mesh.element(e)) lowest[e] = std::min(lowest[e], new_index[node]);
+
+    auto element_order = sort_within_blocks(mesh, lowest);
+    apply(mesh, std::move(order), std::move(element_order));
+}
+
+/// Interleave the low 21 bits of each coordinate
+static uint64_t morton_code(uint32_t x, uint32_t y, uint32_t z)
+{
+    const auto spread = [](uint64_t v)
+    {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffff;
+        v = (v | v << 16) & 0x1f0000ff0000ff;
+        v = (v | v << 8)  & 0x100f00f00f00f00f;
+        v = (v | v << 4)  & 0x10c30c30c30c30c3;
+        v = (v | v << 2)  & 0x1249249249249249;
+        return v;
+    };
+    return spread(x) | spread(y) << 1 | spread(z) << 2;
+}
+
+template<typename _Word>
+void reorder_morton(connectivity<_Word>& mesh, const coordinates<_Word>& coords)
+{
+    using index = integer<_Word>;
+    using value = real<_Word>;
+    const std::size_t nodes = mesh.nodes;
+
+    // Coordinates of the current node numbering, missing dimensions are flat
+    const auto axis = [&](const std::vector<value>& values, index n) -> value
+    {
+        if (values.empty()) return 0;
+        return values[mesh.node_order.empty() ? n : mesh.node_order[n]];
+    };
+
+    const std::vector<const std::vector<value>*> axes = { &coords.x, &coords.y, &coords.z };
+    value low[3], high[3];
+    for (int d = 0; d < 3; d++)
+    {
+        low[d] = std::numeric_limits<value>::max();
+        high[d] = std::numeric_limits<value>::lowest();
+        for (std::size_t n = 0; n < nodes; n++)
+        {
+            low[d]  = std::min(low[d],  axis(*axes[d], n));
+            high[d] = std::max(high[d], axis(*axes[d], n));
+        }
+    }
+
+    const auto code = [&](const value (&point)[3])
+    {
+        uint32_t cell[3];
+        for (int d = 0; d < 3; d++)
+        {
+            const auto extent = high[d] - low[d];
+            cell[d] = (extent > 0 ? (uint32_t)((point[d] - low[d]) / extent * 0x1fffff) : 0);
+        }
+        return morton_code(cell[0], cell[1], cell[2]);
+    };
+
+    std::vector<uint64_t> node_codes(nodes);
+    for (std::size_t n = 0; n < nodes; n++)
+    {
+        const value point[3] = { axis(coords.x, n), axis(coords.y, n), axis(coords.z, n) };
+        node_codes[n] = code(point);
+    }
+
+    std::vector<uint64_t> element_codes(mesh.elements());
+    for (std::size_t e = 0; e < mesh.elements(); e++)
+    {
+        value centroid[3] = { 0, 0, 0 };
+        const auto element = mesh.element(e);
+        for (const auto node : element)
+            for (int d = 0; d < 3; d++) centroid[d] += axis(*axes[d], node);
+        for (int d = 0; d < 3 && element.size(); d++) centroid[d] /= element.size();
+        element_codes[e] = code(centroid);
+    }
+
+    std::vector<index> order(nodes);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](index a, index b) { return node_codes[a] < node_codes[b]; });
+
+    auto element_order = sort_within_blocks(mesh, element_codes);
+    apply(mesh, std::move(order), std::move(element_order));
+}
+
+template result<connectivity<unsigned long>> load_connectivity(const file<unsigned long, io::access::ro>&, ordering);
+template result<connectivity<unsigned long>> load_connectivity(const file<unsigned long, io::access::rw>&, ordering);
+template result<connectivity<unsigned int>> load_connectivity(const file<unsigned int, io::access::ro>&, ordering);
+template result<connectivity<unsigned int>> load_connectivity(const file<unsigned int, io::access::rw>&, ordering);
+
+template void reorder_rcm(connectivity<unsigned long>&);
+template void reorder_rcm(connectivity<unsigned int>&);
+
+template void reorder_morton(connectivity<unsigned long>&, const coordinates<unsigned long>&);
+template void reorder_morton(connectivity<unsigned int>&, const coordinates<unsigned int>&);
+
+}
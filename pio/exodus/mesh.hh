@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ex_file.hh"
+
+namespace pio::exodus
+{
+    /// Node and element orderings \ref load_connectivity can apply
+    enum class ordering
+    {
+        file,   /// Keep the order of the file
+        rcm,    /// Reverse Cuthill-McKee on the node graph, elements follow their lowest node
+        morton  /// Z-order of node coordinates and element centroids (reads the coordinates)
+    };
+
+    /** \brief Connectivity of every block in compressed sparse row form
+     *
+     * The nodes of element `e` are `indices[offsets[e]]` up to `indices[offsets[e + 1]]`, which works the same
+     * for fixed-size elements and for `nsided` polygons. Elements are numbered through the blocks in order and
+     * nodes start at 0 (unlike the 1-based connectivity in the file).
+     *
+     * When the mesh is renumbered, elements are only reordered within their block, so `block_offsets` still
+     * holds. `node_order[i]` is then the index in the file of new node `i` (likewise `element_order`), and both
+     * are empty when the file order is kept.
+     */
+    template<typename _Word>
+    struct connectivity
+    {
+        std::vector<integer<_Word>> offsets;       /// Start of each element in `indices`, followed by the total
+        std::vector<integer<_Word>> indices;       /// Nodes of every element
+        std::vector<integer<_Word>> block_offsets; /// First element of each block, followed by the element count
+        std::vector<integer<_Word>> node_order, element_order;
+        integer<_Word> nodes = 0;
+
+        std::size_t elements() const { return (offsets.empty() ? 0 : offsets.size() - 1); }
+
+        /// Nodes of element `e`
+        util::span<const integer<_Word>> element(std::size_t e) const
+        {
+            assert(e < elements());
+            return util::span<const integer<_Word>>(indices.data() + offsets[e], offsets[e + 1] - offsets[e]);
+        }
+    };
+
+    /// Read the connectivity of every block into a \ref connectivity, optionally renumbering the mesh
+    /// \note `nfaced` blocks (whose connectivity refers to faces) aren't supported
+    template<typename _Word, io::access _Access>
+    result<connectivity<_Word>>
+    load_connectivity(const file<_Word, _Access>& file, ordering order = ordering::file);
+
+    /// Renumber nodes with reverse Cuthill-McKee, then sort the elements of each block by their lowest node
+    template<typename _Word>
+    void reorder_rcm(connectivity<_Word>& mesh);
+
+    /// Renumber nodes and the elements of each block along a Morton (Z-order) curve
+    template<typename _Word>
+    void reorder_morton(connectivity<_Word>& mesh, const coordinates<_Word>& coords);
+}
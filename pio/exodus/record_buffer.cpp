@@ -0,0 +1,116 @@
+#include "record_buffer.hh"
+
+namespace pio::exodus
+{
+
+template<typename _Word, io::access _Access>
+record_buffer<_Word, _Access>::record_buffer(file<_Word, _Access>& file, flush_policy policy) :
+    _file(&file),
+    _policy(policy)
+{   }
+
+template<typename _Word, io::access _Access>
+record_buffer<_Word, _Access>::~record_buffer()
+{
+    close();
+}
+
+template<typename _Word, io::access _Access>
+result<void>
+record_buffer<_Word, _Access>::begin_step(real<_Word> time)
+{
+    if (_closed) return { error_code::FileNotGood };
+
+    if (!_times.empty())
+    {
+        const bool full =
+            (_policy.steps && _times.size() >= _policy.steps) ||
+            (_policy.bytes && _bytes >= _policy.bytes) ||
+            (_policy.age.count() && std::chrono::steady_clock::now() - _oldest >= _policy.age);
+
+        if (full)
+        {
+            const auto res = flush();
+            if (!res) return { res.error() };
+        }
+    }
+
+    if (_times.empty()) _oldest = std::chrono::steady_clock::now();
+    _times.push_back(time);
+    return { };
+}
+
+template<typename _Word, io::access _Access>
+result<void>
+record_buffer<_Word, _Access>::write(scope _scope, integer<_Word> variable, integer<_Word> id, const std::vector<real<_Word>>& values)
+{
+    if (_closed) return { error_code::FileNotGood };
+    if (_times.empty()) return { error_code::TimeStepNotPresent };
+
+    const std::size_t step = _times.size() - 1;
+    auto& runs = _runs[key(_scope, variable, (_scope == scope::element ? id : 0))];
+
+    // Continue the last run if this field was written on the step before, otherwise start a new one
+    if (runs.empty() || runs.back().first + runs.back().steps != step)
+    {
+        if (!runs.empty() && runs.back().first + runs.back().steps > step) return { error_code::TimeStepError };
+        runs.push_back(run{ step, 0, values.size(), { } });
+    }
+
+    auto& r = runs.back();
+    if (values.size() != r.entities) return { error_code::DimensionSizeMismatch };
+
+    r.values.insert(r.values.end(), values.begin(), values.end());
+    r.steps++;
+    _bytes += values.size() * sizeof(real<_Word>);
+    return { };
+}
+
+template<typename _Word, io::access _Access>
+result<void>
+record_buffer<_Word, _Access>::flush()
+{
+    if (_times.empty()) return { };
+
+    PIO_TRACE_SCOPE("record_buffer::flush", "", _bytes);
+
+    // The buffer is emptied even if a write fails, so a bad step isn't written again with the next flush
+    const auto times = std::move(_times);
+    const auto runs  = std::move(_runs);
+    _times.clear();
+    _runs.clear();
+    _bytes = 0;
+
+    const auto first = _file->write_time_steps(times.data(), times.size());
+    if (!first) return { first.error() };
+
+    for (const auto& [k, field] : runs)
+    {
+        const auto& [s, variable, id] = k;
+        for (const auto& r : field)
+        {
+            const auto res = _file->set_variable_values(s, variable, id, *first + r.first, r.steps, r.entities, r.values.data());
+            if (!res) return { res.error() };
+        }
+    }
+
+    return { };
+}
+
+template<typename _Word, io::access _Access>
+result<void>
+record_buffer<_Word, _Access>::close()
+{
+    if (_closed) return { };
+    const auto res = flush();
+    _closed = true;
+    if (!res) return { res.error() };
+    return { };
+}
+
+template struct record_buffer<unsigned long, io::access::wo>;
+template struct record_buffer<unsigned long, io::access::rw>;
+template struct record_buffer<unsigned int, io::access::wo>;
+template struct record_buffer<unsigned int, io::access::rw>;
+
+}
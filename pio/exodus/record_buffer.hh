@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ex_file.hh"
+
+#include <chrono>
+#include <map>
+#include <tuple>
+
+namespace pio::exodus
+{
+    /// When a \ref record_buffer writes out the steps it holds, whichever limit is reached first
+    /// \note a limit of 0 is ignored
+    struct flush_policy
+    {
+        std::size_t steps = 16;                    /// Buffered time steps
+        std::size_t bytes = 0;                     /// Buffered field values, in bytes
+        std::chrono::milliseconds age{ 0 };        /// Time since the oldest buffered step began
+    };
+
+    /** \brief Accumulates time steps in memory and writes them out as multi-record writes
+     *
+     * Writing a few small diagnostics every step costs one request per field per step, which is mostly latency.
+     * A record buffer keeps the time values and fields of several steps and, once the \ref flush_policy says so,
+     * writes each field over all of them with a single hyperslab along the time dimension:
+     * \code {.cpp}
+     * exodus::record_buffer<word_t, io::access::wo> output(file, exodus::flush_policy{ 64 });
+     * for (...)
+     * {
+     *     output.begin_step(time);
+     *     output.write(exodus::scope::node, 1, 0, temperature);
+     *     output.write(exodus::scope::element, 1, block.info.id, pressure);
+     * }
+     * output.close();
+     * \endcode
+     * Steps are only checked against the policy when the next one begins, so a step is never split over two
+     * flushes. A field that skips steps is written as one request per unbroken run of steps.
+     * \note the buffer flushes when it is destroyed, but errors are lost there, so call \ref close
+     */
+    template<typename _Word, io::access _Access>
+    struct record_buffer
+    {
+        static_assert(_Access == io::access::wo || _Access == io::access::rw, "record_buffer writes to the file");
+
+        record_buffer(file<_Word, _Access>& file, flush_policy policy = {});
+        record_buffer(const record_buffer&) = delete;
+
+        ~record_buffer();
+
+        /// Start buffering a new time step, flushing the buffered ones first if the policy says to
+        result<void> begin_step(real<_Word> time);
+
+        /// Buffer the values of a variable at the current step
+        /// \param variable index of the variable, starting at 1 (1 for the row of global variables)
+        /// \param id id of the block for \ref scope::element, ignored otherwise
+        /// \note every step must give a field the same number of values
+        result<void> write(scope _scope, integer<_Word> variable, integer<_Word> id, const std::vector<real<_Word>>& values);
+
+        /// Write every buffered step to the file
+        result<void> flush();
+
+        /// Flush and stop buffering, later writes fail
+        result<void> close();
+
+        /// Number of buffered time steps
+        std::size_t steps() const { return _times.size(); }
+
+        /// Number of buffered bytes of field values
+        std::size_t bytes() const { return _bytes; }
+
+    private:
+        using key = std::tuple<scope, integer<_Word>, integer<_Word>>;
+
+        /// Consecutive steps of one field
+        struct run
+        {
+            std::size_t first = 0, steps = 0, entities = 0; /// `first` counts from the first buffered step
+            std::vector<real<_Word>> values;
+        };
+
+        file<_Word, _Access>* _file;
+        flush_policy _policy;
+        std::vector<real<_Word>> _times;
+        std::map<key, std::vector<run>> _runs;
+        std::size_t _bytes = 0;
+        std::chrono::steady_clock::time_point _oldest;
+        bool _closed = false;
+    };
+}
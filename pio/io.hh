@@ -11,10 +11,15 @@
 #pragma once
 
 #include "./io/type.hh"
+#include "./io/backend.hh"
 #include "./io/result.hh"
 #include "./io/promise.hh"
 #include "./io/distributor.hh"
 #include "./io/span.hh"
+#include "./io/view.hh"
+#include "./io/convert.hh"
+#include "./io/stats.hh"
+#include "./io/trace.hh"
 
 #ifndef READ_TEMP
 #define READ_TEMP typename = std::enable_if<_Access == io::access::ro || _Access == io::access::rw, bool>
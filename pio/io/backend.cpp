@@ -0,0 +1,54 @@
+#include "backend.hh"
+
+namespace pio::io
+{
+    pnetcdf_backend& pnetcdf_backend::instance()
+    {
+        static pnetcdf_backend backend;
+        return backend;
+    }
+
+    int pnetcdf_backend::create(MPI_Comm comm, const char* path, int mode, MPI_Info info, int* handle) { return ncmpi_create(comm, path, mode, info, handle); }
+    int pnetcdf_backend::open(MPI_Comm comm, const char* path, int mode, MPI_Info info, int* handle) { return ncmpi_open(comm, path, mode, info, handle); }
+    int pnetcdf_backend::close(int handle) { return ncmpi_close(handle); }
+    int pnetcdf_backend::flush(int handle) { return ncmpi_flush(handle); }
+
+    int pnetcdf_backend::redef(int handle) { return ncmpi_redef(handle); }
+    int pnetcdf_backend::enddef(int handle) { return ncmpi_enddef(handle); }
+    int pnetcdf_backend::begin_indep_data(int handle) { return ncmpi_begin_indep_data(handle); }
+    int pnetcdf_backend::end_indep_data(int handle) { return ncmpi_end_indep_data(handle); }
+
+    int pnetcdf_backend::inq(int handle, int* dimensions, int* variables, int* attributes, int* unlimited) { return ncmpi_inq(handle, dimensions, variables, attributes, unlimited); }
+    int pnetcdf_backend::inq_unlimdim(int handle, int* unlimited) { return ncmpi_inq_unlimdim(handle, unlimited); }
+    int pnetcdf_backend::inq_dim(int handle, int dimension, char* name, MPI_Offset* length) { return ncmpi_inq_dim(handle, dimension, name, length); }
+    int pnetcdf_backend::inq_dimid(int handle, const char* name, int* dimension) { return ncmpi_inq_dimid(handle, name, dimension); }
+    int pnetcdf_backend::inq_dimlen(int handle, int dimension, MPI_Offset* length) { return ncmpi_inq_dimlen(handle, dimension, length); }
+    int pnetcdf_backend::inq_var(int handle, int variable, char* name, nc_type* type, int* dimensions, int* dimension_ids, int* attributes) { return ncmpi_inq_var(handle, variable, name, type, dimensions, dimension_ids, attributes); }
+    int pnetcdf_backend::inq_varid(int handle, const char* name, int* variable) { return ncmpi_inq_varid(handle, name, variable); }
+    int pnetcdf_backend::inq_varname(int handle, int variable, char* name) { return ncmpi_inq_varname(handle, variable, name); }
+    int pnetcdf_backend::inq_vartype(int handle, int variable, nc_type* type) { return ncmpi_inq_vartype(handle, variable, type); }
+    int pnetcdf_backend::inq_varndims(int handle, int variable, int* dimensions) { return ncmpi_inq_varndims(handle, variable, dimensions); }
+    int pnetcdf_backend::inq_vardimid(int handle, int variable, int* dimension_ids) { return ncmpi_inq_vardimid(handle, variable, dimension_ids); }
+    int pnetcdf_backend::inq_att(int handle, int variable, const char* name, nc_type* type, MPI_Offset* length) { return ncmpi_inq_att(handle, variable, name, type, length); }
+    int pnetcdf_backend::inq_attlen(int handle, int variable, const char* name, MPI_Offset* length) { return ncmpi_inq_attlen(handle, variable, name, length); }
+    int pnetcdf_backend::get_att(int handle, int variable, const char* name, void* values) { return ncmpi_get_att(handle, variable, name, values); }
+    int pnetcdf_backend::get_att_text(int handle, int variable, const char* name, char* text) { return ncmpi_get_att_text(handle, variable, name, text); }
+
+    int pnetcdf_backend::def_dim(int handle, const char* name, MPI_Offset length, int* dimension) { return ncmpi_def_dim(handle, name, length, dimension); }
+    int pnetcdf_backend::def_var(int handle, const char* name, nc_type type, int dimensions, const int* dimension_ids, int* variable) { return ncmpi_def_var(handle, name, type, dimensions, dimension_ids, variable); }
+    int pnetcdf_backend::put_att(int handle, int variable, const char* name, nc_type type, MPI_Offset length, const void* values) { return ncmpi_put_att(handle, variable, name, type, length, values); }
+    int pnetcdf_backend::put_att_text(int handle, int variable, const char* name, MPI_Offset length, const char* text) { return ncmpi_put_att_text(handle, variable, name, length, text); }
+
+    int pnetcdf_backend::iget_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, void* buffer, MPI_Offset size, MPI_Datatype type, int* request)
+    { return ncmpi_iget_vara(handle, variable, start, count, buffer, size, type, request); }
+
+    int pnetcdf_backend::iget_varn(int handle, int variable, int runs, MPI_Offset* const* starts, MPI_Offset* const* counts, void* buffer, MPI_Offset size, MPI_Datatype type, int* request)
+    { return ncmpi_iget_varn(handle, variable, runs, starts, counts, buffer, size, type, request); }
+
+    int pnetcdf_backend::iput_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, const void* buffer, MPI_Offset size, MPI_Datatype type, int* request)
+    { return ncmpi_iput_vara(handle, variable, start, count, buffer, size, type, request); }
+
+    int pnetcdf_backend::cancel(int handle, int count, int* requests, int* statuses) { return ncmpi_cancel(handle, count, requests, statuses); }
+    int pnetcdf_backend::wait(int handle, int count, int* requests, int* statuses) { return ncmpi_wait(handle, count, requests, statuses); }
+    int pnetcdf_backend::wait_all(int handle, int count, int* requests, int* statuses) { return ncmpi_wait_all(handle, count, requests, statuses); }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "../external.hh"
+
+namespace pio::io
+{
+    /** \brief Where a NetCDF dataset is stored
+     *
+     * A \ref netcdf::file makes every call through a backend, so the same file, exodus and checkpoint code can
+     * run against something other than the file system. The calls are the subset of PnetCDF the library uses,
+     * with the same arguments, semantics and NetCDF error codes, so a backend is a drop-in replacement for the
+     * `ncmpi_*` functions. \ref pnetcdf_backend is the default and forwards to PnetCDF, see
+     * \ref netcdf::memory_backend for datasets kept in memory.
+     * \note `handle` is whatever \ref create or \ref open handed out, it only means something to the backend that did
+     */
+    struct backend
+    {
+        virtual ~backend() = default;
+
+        virtual int create(MPI_Comm comm, const char* path, int mode, MPI_Info info, int* handle) = 0;
+        virtual int open(MPI_Comm comm, const char* path, int mode, MPI_Info info, int* handle) = 0;
+        virtual int close(int handle) = 0;
+        virtual int flush(int handle) = 0;
+
+        virtual int redef(int handle) = 0;
+        virtual int enddef(int handle) = 0;
+        virtual int begin_indep_data(int handle) = 0;
+        virtual int end_indep_data(int handle) = 0;
+
+        virtual int inq(int handle, int* dimensions, int* variables, int* attributes, int* unlimited) = 0;
+        virtual int inq_unlimdim(int handle, int* unlimited) = 0;
+        virtual int inq_dim(int handle, int dimension, char* name, MPI_Offset* length) = 0;
+        virtual int inq_dimid(int handle, const char* name, int* dimension) = 0;
+        virtual int inq_dimlen(int handle, int dimension, MPI_Offset* length) = 0;
+        virtual int inq_var(int handle, int variable, char* name, nc_type* type, int* dimensions, int* dimension_ids, int* attributes) = 0;
+        virtual int inq_varid(int handle, const char* name, int* variable) = 0;
+        virtual int inq_varname(int handle, int variable, char* name) = 0;
+        virtual int inq_vartype(int handle, int variable, nc_type* type) = 0;
+        virtual int inq_varndims(int handle, int variable, int* dimensions) = 0;
+        virtual int inq_vardimid(int handle, int variable, int* dimension_ids) = 0;
+        virtual int inq_att(int handle, int variable, const char* name, nc_type* type, MPI_Offset* length) = 0;
+        virtual int inq_attlen(int handle, int variable, const char* name, MPI_Offset* length) = 0;
+        virtual int get_att(int handle, int variable, const char* name, void* values) = 0;
+        virtual int get_att_text(int handle, int variable, const char* name, char* text) = 0;
+
+        virtual int def_dim(int handle, const char* name, MPI_Offset length, int* dimension) = 0;
+        virtual int def_var(int handle, const char* name, nc_type type, int dimensions, const int* dimension_ids, int* variable) = 0;
+        virtual int put_att(int handle, int variable, const char* name, nc_type type, MPI_Offset length, const void* values) = 0;
+        virtual int put_att_text(int handle, int variable, const char* name, MPI_Offset length, const char* text) = 0;
+
+        virtual int iget_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, void* buffer, MPI_Offset size, MPI_Datatype type, int* request) = 0;
+        virtual int iget_varn(int handle, int variable, int runs, MPI_Offset* const* starts, MPI_Offset* const* counts, void* buffer, MPI_Offset size, MPI_Datatype type, int* request) = 0;
+        virtual int iput_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, const void* buffer, MPI_Offset size, MPI_Datatype type, int* request) = 0;
+        virtual int cancel(int handle, int count, int* requests, int* statuses) = 0;
+        virtual int wait(int handle, int count, int* requests, int* statuses) = 0;
+        virtual int wait_all(int handle, int count, int* requests, int* statuses) = 0;
+    };
+
+    /// The backend that stores datasets in real files through PnetCDF
+    struct pnetcdf_backend : backend
+    {
+        /// The instance every \ref netcdf::file uses unless it is given another backend
+        static pnetcdf_backend& instance();
+
+        int create(MPI_Comm comm, const char* path, int mode, MPI_Info info, int* handle) override;
+        int open(MPI_Comm comm, const char* path, int mode, MPI_Info info, int* handle) override;
+        int close(int handle) override;
+        int flush(int handle) override;
+
+        int redef(int handle) override;
+        int enddef(int handle) override;
+        int begin_indep_data(int handle) override;
+        int end_indep_data(int handle) override;
+
+        int inq(int handle, int* dimensions, int* variables, int* attributes, int* unlimited) override;
+        int inq_unlimdim(int handle, int* unlimited) override;
+        int inq_dim(int handle, int dimension, char* name, MPI_Offset* length) override;
+        int inq_dimid(int handle, const char* name, int* dimension) override;
+        int inq_dimlen(int handle, int dimension, MPI_Offset* length) override;
+        int inq_var(int handle, int variable, char* name, nc_type* type, int* dimensions, int* dimension_ids, int* attributes) override;
+        int inq_varid(int handle, const char* name, int* variable) override;
+        int inq_varname(int handle, int variable, char* name) override;
+        int inq_vartype(int handle, int variable, nc_type* type) override;
+        int inq_varndims(int handle, int variable, int* dimensions) override;
+        int inq_vardimid(int handle, int variable, int* dimension_ids) override;
+        int inq_att(int handle, int variable, const char* name, nc_type* type, MPI_Offset* length) override;
+        int inq_attlen(int handle, int variable, const char* name, MPI_Offset* length) override;
+        int get_att(int handle, int variable, const char* name, void* values) override;
+        int get_att_text(int handle, int variable, const char* name, char* text) override;
+
+        int def_dim(int handle, const char* name, MPI_Offset length, int* dimension) override;
+        int def_var(int handle, const char* name, nc_type type, int dimensions, const int* dimension_ids, int* variable) override;
+        int put_att(int handle, int variable, const char* name, nc_type type, MPI_Offset length, const void* values) override;
+        int put_att_text(int handle, int variable, const char* name, MPI_Offset length, const char* text) override;
+
+        int iget_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, void* buffer, MPI_Offset size, MPI_Datatype type, int* request) override;
+        int iget_varn(int handle, int variable, int runs, MPI_Offset* const* starts, MPI_Offset* const* counts, void* buffer, MPI_Offset size, MPI_Datatype type, int* request) override;
+        int iput_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, const void* buffer, MPI_Offset size, MPI_Datatype type, int* request) override;
+        int cancel(int handle, int count, int* requests, int* statuses) override;
+        int wait(int handle, int count, int* requests, int* statuses) override;
+        int wait_all(int handle, int count, int* requests, int* statuses) override;
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+
+namespace pio::io
+{
+    /// Whether the host stores multi-byte values big-endian (NetCDF classic files always do)
+    inline constexpr bool host_big_endian = ( __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ );
+
+    namespace impl
+    {
+
+    template<std::size_t _Size>
+    struct unsigned_of {   };
+
+    template<> struct unsigned_of<1> { using type = uint8_t;  static uint8_t  swap(uint8_t v)  { return v; } };
+    template<> struct unsigned_of<2> { using type = uint16_t; static uint16_t swap(uint16_t v) { return __builtin_bswap16(v); } };
+    template<> struct unsigned_of<4> { using type = uint32_t; static uint32_t swap(uint32_t v) { return __builtin_bswap32(v); } };
+    template<> struct unsigned_of<8> { using type = uint64_t; static uint64_t swap(uint64_t v) { return __builtin_bswap64(v); } };
+
+    } // namespace impl
+
+    /// Read one big-endian value from unaligned memory
+    template<typename T>
+    inline T load_big_endian(const void* src)
+    {
+        using U = impl::unsigned_of<sizeof(T)>;
+        typename U::type bits;
+        std::memcpy(&bits, src, sizeof(T));
+        if constexpr (!host_big_endian) bits = U::swap(bits);
+
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+
+    /**
+     * @brief Copy `count` big-endian values from `src` into native-endian `dst`
+     *
+     * The loop body is a plain load/bswap/store on unsigned integers with no aliasing between source and
+     * destination, which GCC and Clang turn into byte-shuffle SIMD instructions (`pshufb`/`vpshufb`, `tbl`).
+     */
+    template<typename T>
+    inline void load_big_endian(const void* __restrict src, T* __restrict dst, std::size_t count)
+    {
+        if constexpr (host_big_endian || sizeof(T) == 1)
+            std::memcpy(dst, src, count * sizeof(T));
+        else
+        {
+            using U = impl::unsigned_of<sizeof(T)>;
+            const auto* s = static_cast<const unsigned char*>(src);
+            auto* d = reinterpret_cast<unsigned char*>(dst);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                typename U::type bits;
+                std::memcpy(&bits, s + i * sizeof(T), sizeof(T));
+                bits = U::swap(bits);
+                std::memcpy(d + i * sizeof(T), &bits, sizeof(T));
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../external.hh"
+
+#include "byteswap.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace pio::io
+{
+    /// Values are converted this many at a time, few enough that a chunk of any type stays in L1
+    inline constexpr std::size_t convert_chunk = 1024;
+
+    /// Whether values of one type can be converted to another \note like PnetCDF, text only converts to text
+    constexpr bool convertible(nc_type from, nc_type to)
+    {
+        return (from == NC_CHAR) == (to == NC_CHAR);
+    }
+
+    /// Convert `count` values, the loop is simple enough for the compiler to vectorize
+    template<typename _From, typename _To>
+    inline void convert(const _From* __restrict src, _To* __restrict dst, std::size_t count)
+    {
+        if constexpr (std::is_same_v<_From, _To>)
+            std::memcpy(dst, src, count * sizeof(_To));
+        else
+            for (std::size_t i = 0; i < count; i++)
+                dst[i] = static_cast<_To>(src[i]);
+    }
+
+    /// Call `f` with a value of the C type that stores `type` \return false if the type is unknown
+    template<typename F>
+    inline bool visit_type(nc_type type, F&& f)
+    {
+        switch (type)
+        {
+        case NC_BYTE:   f((signed char)0);        return true;
+        case NC_CHAR:   f((char)0);               return true;
+        case NC_SHORT:  f((short)0);              return true;
+        case NC_INT:    f((int)0);                return true;
+        case NC_FLOAT:  f((float)0);              return true;
+        case NC_DOUBLE: f((double)0);             return true;
+        case NC_UBYTE:  f((unsigned char)0);      return true;
+        case NC_USHORT: f((unsigned short)0);     return true;
+        case NC_UINT:   f((unsigned int)0);       return true;
+        case NC_INT64:  f((long long)0);          return true;
+        case NC_UINT64: f((unsigned long long)0); return true;
+        }
+        return false;
+    }
+
+    /// Convert `count` values stored as `from` into `dst`
+    template<typename _To>
+    inline bool convert_from(nc_type from, const void* src, _To* dst, std::size_t count)
+    {
+        return visit_type(from, [&](auto tag)
+        {
+            using _From = decltype(tag);
+            convert(static_cast<const _From*>(src), dst, count);
+        });
+    }
+
+    /// Convert `count` values into `dst`, which stores them as `to`
+    template<typename _From>
+    inline bool convert_to(const _From* src, nc_type to, void* dst, std::size_t count)
+    {
+        return visit_type(to, [&](auto tag)
+        {
+            using _To = decltype(tag);
+            convert(src, static_cast<_To*>(dst), count);
+        });
+    }
+
+    /// Swap big-endian values stored as `from` into host order and convert them into `dst`
+    /// \note values are swapped into a stack buffer one chunk at a time, so no temporary the size of the data is needed
+    template<typename _To>
+    inline bool load_big_endian_as(nc_type from, const unsigned char* src, _To* dst, std::size_t count)
+    {
+        return visit_type(from, [&](auto tag)
+        {
+            using _From = decltype(tag);
+            if constexpr (std::is_same_v<_From, _To>)
+                load_big_endian(src, dst, count);
+            else
+            {
+                _From chunk[convert_chunk];
+                for (std::size_t i = 0; i < count; i += convert_chunk)
+                {
+                    const auto n = std::min(convert_chunk, count - i);
+                    load_big_endian(src + i * sizeof(_From), chunk, n);
+                    convert(chunk, dst + i, n);
+                }
+            }
+        });
+    }
+}
@@ -1,11 +1,14 @@
 #include "distributor.hh"
 
 #include "type.hh"
+#include "trace.hh"
 
 #include <iostream>
 #include <algorithm>
 #include <cassert>
 #include <limits>
+#include <queue>
+#include <chrono>
 
 namespace pio::io
 {
@@ -48,46 +51,46 @@ namespace pio::io
 
     }
 
-    io::result<std::vector<distributor::subvolume>>
-    distributor::get_tasks() const
+    distributor::distributor(int rank, int processes) :
+        _rank(rank),
+        _processes(processes)
+    {
+        assert(rank >= 0 && rank < processes);
+    }
+
+    std::vector<std::vector<uint32_t>>
+    distributor::_assign() const
     {
-        const auto first_rank = 0U;
         const auto count = processes();
 
         // We want to figure out how many cells there are in total...
-        const auto total_size = std::accumulate(data_volumes.begin(), data_volumes.end(), 0,
-        [](auto val, auto v)
+        std::vector<std::size_t> volume_ends(data_volumes.size());
+        std::size_t total_size = 0;
+        for (uint32_t i = 0; i < data_volumes.size(); i++)
         {
-            return val + v.cell_count();
-        });
+            total_size += data_volumes[i].cell_count();
+            volume_ends[i] = total_size;
+        }
 
         // ... so that we can figure out about how many cells each process should have
-        const auto cells_per_process = total_size / (float)count;
+        const auto cells_per_process = total_size / (double)count;
 
         // Now we step through the entire cell count to find out how many 
         // processes per volume
-        std::size_t memory_index = 0, last_volume_location = 0;
+        std::size_t memory_index = 0;
         uint32_t current_rank = 0, volume_index = 0;
         std::vector<std::vector<uint32_t>> process_counts(data_volumes.size());
         while (memory_index < total_size)
         {
-            const auto next_block_location = cells_per_process * (current_rank + 1);
-            const auto next_volume_location = [&]()
-            {
-                if (volume_index == data_volumes.size() - 1) return total_size;
-                return std::accumulate(data_volumes.begin(), data_volumes.begin() + volume_index + 1, 0,
-                [](auto val, auto& v)
-                {
-                    return val + v.cell_count();
-                });
-            }();
+            // The last block always ends exactly at the end so rounding can't create a phantom rank
+            const double next_block_location = (current_rank + 1 >= (uint32_t)count ? total_size : cells_per_process * (current_rank + 1));
+            const auto next_volume_location = volume_ends[volume_index];
             
             // If the volume ends before the block, increment this volume's process count
             if (next_volume_location <= next_block_location)
             {
                 process_counts[volume_index].push_back(current_rank);
                 memory_index = next_volume_location;
-                last_volume_location = next_volume_location;
                 volume_index++;
             }
             // Otherwise, if the block ends before the volume, increment the proccess count
@@ -100,73 +103,126 @@ namespace pio::io
             }
         }
 
+        return process_counts;
+    }
+
+    std::vector<distributor::subvolume>
+    distributor::_split(uint32_t volume_index, std::size_t pieces) const
+    {
+        const auto& dimensions = data_volumes[volume_index].dimensions;
+
+        std::vector<distributor::subvolume> volume;
+        volume.reserve(pieces);
+        volume.push_back([&](){
+            distributor::subvolume vol;
+            for (const auto& dim : dimensions)
+                vol.counts.push_back(dim);
+            vol.offsets = std::vector<MPI_Offset>(dimensions.size(), 0);
+            vol.volume_index = volume_index;
+            return vol;
+        }());
+
+        const auto cells = [](const distributor::subvolume& v)
+        {
+            return std::accumulate(v.counts.begin(), v.counts.end(), std::size_t(1), std::multiplies<std::size_t>());
+        };
+
+        // Subdivide this volume, always halving the largest piece (the earliest one on ties)
+        using entry = std::pair<std::size_t, int64_t>; // cell count, negated index
+        std::priority_queue<entry> largest;
+        largest.push({ cells(volume[0]), 0 });
+        for (std::size_t i = 1; i < pieces; i++)
+        {
+            const auto index = -largest.top().second;
+            largest.pop();
+
+            volume.push_back(volume[index].split());
+            largest.push({ cells(volume[index]), -index });
+            largest.push({ cells(volume.back()), -(int64_t)(volume.size() - 1) });
+        }
+
+        return volume;
+    }
+
+    std::vector<std::vector<distributor::subvolume>>
+    distributor::plan() const
+    {
+        std::vector<std::vector<distributor::subvolume>> tasks(processes());
+
+        const auto process_counts = _assign();
+        for (uint32_t volume_index = 0; volume_index < process_counts.size(); volume_index++)
+        {
+            const auto& volume_ranks = process_counts[volume_index];
+            if (volume_ranks.empty()) continue;
+
+            auto volume = _split(volume_index, volume_ranks.size());
+            for (uint32_t i = 0; i < volume_ranks.size(); i++)
+                tasks[volume_ranks[i]].push_back(std::move(volume[i]));
+        }
+
+        return tasks;
+    }
+
+    io::result<std::vector<distributor::subvolume>>
+    distributor::get_tasks() const
+    {
+        PIO_TRACE_SCOPE("get_tasks");
         std::vector<distributor::subvolume> volumes;
 
-        volume_index = 0;
-        for (const auto& volume_ranks : process_counts)
+        // Only subdivide the volumes this rank takes part in
+        const auto process_counts = _assign();
+        for (uint32_t volume_index = 0; volume_index < process_counts.size(); volume_index++)
         {
-            const auto& dimensions = data_volumes[volume_index].dimensions;
+            const auto& volume_ranks = process_counts[volume_index];
             const auto it = std::find(volume_ranks.begin(), volume_ranks.end(), rank());
-            if (it != volume_ranks.end())
-            {
-                if (volume_ranks.size() == 1)
-                {
-                    volumes.push_back([&](){
-                        distributor::subvolume sub_vol;
-                        for (const auto& dim : dimensions)
-                            sub_vol.counts.push_back(dim);
-                        sub_vol.offsets = std::vector<MPI_Offset>(dimensions.size(), 0);
-                        sub_vol.volume_index = volume_index;
-                        return sub_vol;
-                    }());
-                }
-                else if (volume_ranks.size())
-                {
-                    std::vector<distributor::subvolume> volume;
-                    volume.push_back([&](){
-                        distributor::subvolume vol;
-                        for (const auto& dim : dimensions)
-                            vol.counts.push_back(dim);
-                        vol.offsets = std::vector<MPI_Offset>(dimensions.size(), 0);
-                        vol.volume_index = volume_index;
-                        return vol;
-                    }());
-
-                    // Subdivide this volume 
-                    for (uint32_t i = 0; i < volume_ranks.size() - 1; i++)
-                    {
-                        auto [max_cell_count, max_index] = std::pair(
-                            std::numeric_limits<uint32_t>::min(),
-                            -1
-                        );
-
-                        for (uint32_t i = 0; i < volume.size(); i++)
-                        {
-                            const auto cell_count = std::accumulate(
-                                volume[i].counts.begin(), 
-                                volume[i].counts.end(), 
-                                1, 
-                                std::multiplies<std::size_t>()
-                            );
-                            if (cell_count > max_cell_count) 
-                            {
-                                max_cell_count = cell_count;
-                                max_index = i;
-                            }
-                        }
-
-                        volume.push_back(volume[max_index].split());
-                    }
-
-                    assert(volume.size() == volume_ranks.size());
-                    for (auto i = 0; i < volume_ranks.size(); i++)
-                        if (volume_ranks[i] == rank())
-                            volumes.push_back(volume[i]);
-                }
-            }
-            volume_index++;
+            if (it == volume_ranks.end()) continue;
+
+            auto volume = _split(volume_index, volume_ranks.size());
+            volumes.push_back(std::move(volume[std::distance(volume_ranks.begin(), it)]));
         }
 
         return { std::move(volumes) };
-    }   
+    }
+
+    std::size_t
+    distributor::extent_count(const volume& vol, const subvolume& sub)
+    {
+        if (sub.counts.empty()) return 1;
+
+        // Trailing dimensions that are covered entirely merge into one contiguous run
+        int64_t j = sub.counts.size() - 1;
+        while (j > 0 && sub.counts[j] == (MPI_Offset)vol.dimensions[j]) j--;
+
+        return std::accumulate(sub.counts.begin(), sub.counts.begin() + j, std::size_t(1), std::multiplies<std::size_t>());
+    }
+
+    distributor::report
+    distributor::simulate(const std::vector<volume>& volumes, int processes)
+    {
+        distributor dist(0, processes);
+        dist.data_volumes = volumes;
+
+        const auto begin = std::chrono::steady_clock::now();
+        const auto tasks = dist.plan();
+        const auto end = std::chrono::steady_clock::now();
+
+        report r;
+        r.processes = processes;
+        r.planning_seconds = std::chrono::duration<double>(end - begin).count();
+        r.bytes.resize(processes, 0);
+        r.extents.resize(processes, 0);
+        for (int p = 0; p < processes; p++)
+            for (const auto& sub : tasks[p])
+            {
+                const auto& vol = volumes[sub.volume_index];
+                r.bytes[p] += std::accumulate(sub.counts.begin(), sub.counts.end(), std::size_t(1), std::multiplies<std::size_t>()) * nc_sizeof(vol.data_type);
+                r.extents[p] += extent_count(vol, sub);
+            }
+
+        r.max_bytes   = *std::max_element(r.bytes.begin(), r.bytes.end());
+        r.max_extents = *std::max_element(r.extents.begin(), r.extents.end());
+        r.mean_bytes  = std::accumulate(r.bytes.begin(), r.bytes.end(), 0.0) / processes;
+        r.imbalance   = (r.mean_bytes > 0 ? r.max_bytes / r.mean_bytes : 0.0);
+        return r;
+    }
 }
\ No newline at end of file
@@ -62,7 +62,7 @@ namespace pio::io
                 return std::accumulate(
                     dimensions.begin(), 
                     dimensions.end(), 
-                    1, 
+                    std::size_t(1), 
                     std::multiplies<std::size_t>()
                 );
             }
@@ -83,20 +83,52 @@ namespace pio::io
             subvolume split();
         };
 
+        /// Quality metrics of a decomposition, see \ref simulate
+        struct report
+        {
+            int processes;
+            std::vector<std::size_t> bytes;   /// Bytes assigned to each rank
+            std::vector<std::size_t> extents; /// Contiguous file extents each rank touches (assuming row-major storage)
+            std::size_t max_bytes, max_extents;
+            double mean_bytes, imbalance;     /// imbalance is max/mean of the bytes per rank
+            double planning_seconds;          /// Time spent computing the decomposition
+        };
+
         /// List of volumes to split among processes
         std::vector<volume> data_volumes;
 
         distributor(MPI_Comm communicator);
 
+        /// Construct without MPI, as if this were process `rank` out of `processes` \note useful for planning offline
+        distributor(int rank, int processes);
+
         /// Given the mpi comm and the list data_volumes, attempts to evenly distribute data load.
         /// @return io::result<std::vector<subvolume>> A list of subvolumes this process is responsible for.
         io::result<std::vector<subvolume>>
         get_tasks() const;
 
+        /// Compute the subvolumes of every process \note does not communicate, every process gets the same answer
+        std::vector<std::vector<subvolume>>
+        plan() const;
+
+        /// Evaluate how data_volumes would be split over the given amount of processes, without MPI
+        static report
+        simulate(const std::vector<volume>& volumes, int processes);
+
+        /// The amount of contiguous runs a subvolume of the given volume covers in a row-major file
+        static std::size_t
+        extent_count(const volume& vol, const subvolume& sub);
+
         auto rank() const { return _rank; }
         auto processes() const { return _processes; }
 
     private:
+        /// The ranks each volume is divided among, in order
+        std::vector<std::vector<uint32_t>> _assign() const;
+
+        /// Split one volume into as many subvolumes as there are ranks assigned to it
+        std::vector<subvolume> _split(uint32_t volume_index, std::size_t pieces) const;
+
         const int _rank, _processes;
     };
 }
\ No newline at end of file
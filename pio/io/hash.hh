@@ -0,0 +1,99 @@
+#pragma once
+
+#include "byteswap.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace pio::io
+{
+    namespace impl
+    {
+
+    inline constexpr uint64_t xxh_prime1 = 0x9E3779B185EBCA87ULL;
+    inline constexpr uint64_t xxh_prime2 = 0xC2B2AE3D27D4EB4FULL;
+    inline constexpr uint64_t xxh_prime3 = 0x165667B19E3779F9ULL;
+    inline constexpr uint64_t xxh_prime4 = 0x85EBCA77C2B2AE63ULL;
+    inline constexpr uint64_t xxh_prime5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t rotl(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+    /// Read a little-endian value from unaligned memory
+    template<typename T>
+    inline T load_little_endian(const unsigned char* p)
+    {
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        if constexpr (host_big_endian) v = unsigned_of<sizeof(T)>::swap(v);
+        return v;
+    }
+
+    inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+    {
+        return rotl(acc + input * xxh_prime2, 31) * xxh_prime1;
+    }
+
+    inline uint64_t xxh_merge(uint64_t acc, uint64_t v)
+    {
+        return (acc ^ xxh_round(0, v)) * xxh_prime1 + xxh_prime4;
+    }
+
+    } // namespace impl
+
+    /**
+     * @brief The 64-bit xxHash (XXH64) of `size` bytes
+     *
+     * The bulk of the input runs through four independent accumulators, so the multiplies of one 32-byte stripe
+     * overlap and the hash keeps up with memory bandwidth. The result matches the reference implementation.
+     */
+    inline uint64_t xxh64(const void* data, std::size_t size, uint64_t seed = 0)
+    {
+        using namespace impl;
+
+        const auto* p = static_cast<const unsigned char*>(data);
+        const auto* end = p + size;
+        uint64_t h;
+
+        if (size >= 32)
+        {
+            uint64_t v1 = seed + xxh_prime1 + xxh_prime2, v2 = seed + xxh_prime2, v3 = seed, v4 = seed - xxh_prime1;
+            for (; p + 32 <= end; p += 32)
+            {
+                v1 = xxh_round(v1, load_little_endian<uint64_t>(p));
+                v2 = xxh_round(v2, load_little_endian<uint64_t>(p + 8));
+                v3 = xxh_round(v3, load_little_endian<uint64_t>(p + 16));
+                v4 = xxh_round(v4, load_little_endian<uint64_t>(p + 24));
+            }
+
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = xxh_merge(h, v1);
+            h = xxh_merge(h, v2);
+            h = xxh_merge(h, v3);
+            h = xxh_merge(h, v4);
+        }
+        else
+            h = seed + xxh_prime5;
+
+        h += size;
+
+        for (; p + 8 <= end; p += 8)
+            h = rotl(h ^ xxh_round(0, load_little_endian<uint64_t>(p)), 27) * xxh_prime1 + xxh_prime4;
+
+        if (p + 4 <= end)
+        {
+            h = rotl(h ^ (load_little_endian<uint32_t>(p) * xxh_prime1), 23) * xxh_prime2 + xxh_prime3;
+            p += 4;
+        }
+
+        for (; p < end; p++)
+            h = rotl(h ^ (*p * xxh_prime5), 11) * xxh_prime1;
+
+        h ^= h >> 33;
+        h *= xxh_prime2;
+        h ^= h >> 29;
+        h *= xxh_prime3;
+        h ^= h >> 32;
+        return h;
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+namespace pio::io::impl
+{
+    /// Escape a string for use inside a JSON string literal, control characters are dropped
+    inline std::string json_escape(const std::string& str)
+    {
+        std::string out;
+        out.reserve(str.size());
+        for (const char c : str)
+        {
+            if (c == '"' || c == '\\') out += '\\';
+            if ((unsigned char)c < 0x20) continue;
+            out += c;
+        }
+        return out;
+    }
+}
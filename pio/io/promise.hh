@@ -4,8 +4,13 @@
 #include <memory>
 #include <cstring>
 #include <cassert>
+#include <tuple>
 
 #include "type.hh"
+#include "backend.hh"
+#include "view.hh"
+#include "stats.hh"
+#include "trace.hh"
 
 namespace pio::io
 {
@@ -29,18 +34,20 @@ namespace pio::io
     using NthType = typename std::tuple_element<N, std::tuple<Ts...>>::type;
 
     
-    template<io::access, std::size_t>
+    template<io::access, typename... _Types>
     struct request_handler;
 
-    template<std::size_t RequestCount>
-    struct request_handler<io::access::ro, RequestCount>
+    // The buffers PnetCDF reads into are the very vectors handed out by promise::take
+    template<typename... _Types>
+    struct request_handler<io::access::ro, _Types...>
     {
         std::shared_ptr<int> requests;
-        std::array<std::pair<std::size_t, std::shared_ptr<void>>, RequestCount> data;
+        std::shared_ptr<std::tuple<std::vector<typename _Types::integral_type>...>> data;
+        std::array<std::pair<std::vector<MPI_Offset>, std::vector<MPI_Offset>>, sizeof...(_Types)> extents;
     };
     
-    template<std::size_t RequestCount>
-    struct request_handler<io::access::wo, RequestCount>
+    template<typename... _Types>
+    struct request_handler<io::access::wo, _Types...>
     {
         std::shared_ptr<int> requests;
     };
@@ -60,12 +67,18 @@ namespace pio::io
         using integral_type = typename impl::NthType<_Index, _Types...>::integral_type;
 
         /// Construct a promise
+        /// @param storage the backend the file is stored on
         /// @param handle the ID handle of the file to which this corresponds
         /// @param counts the size of the data to be retrieved for each request (a list of zeros for write-only requests)
-        promise(int handle, const std::array<std::size_t, RequestCount>& counts) :
+        promise(backend& storage, int handle, const std::array<std::size_t, RequestCount>& counts) :
+            _backend(&storage),
             _handle(handle),
             _error(std::nullopt)
         {
+#       ifdef PIO_INSTRUMENT
+            _request = trace::next_request();
+#       endif
+
             _handler.emplace();
 
             _handler.value().requests = std::shared_ptr<int>(
@@ -76,17 +89,11 @@ namespace pio::io
             // Need only allocate memory if we are reading
             if constexpr (_Access == io::access::ro)
             {
+                auto& data = _handler.value().data;
+                data = std::make_shared<std::tuple<std::vector<typename _Types::integral_type>...>>();
                 impl::static_for<RequestCount>([&](auto n) {
                     constexpr std::size_t i = n;
-
-                    using _Type = impl::NthType<i, _Types...>;
-                    
-                    auto ptr = std::shared_ptr<void>(
-                        std::calloc(counts[i], sizeof(typename _Type::integral_type)),
-                        [](void* ptr) { std::free(ptr); }
-                    );
-
-                    _handler.value().data[i] = std::pair(counts[i], ptr);
+                    std::get<i>(*data).resize(counts[i]);
                 });
             }
         }
@@ -105,18 +112,33 @@ namespace pio::io
 
         const E& error() const { assert(_error.has_value()); return _error.value(); }
 
+        /// Id the requests of this promise are traced under (zero unless built with `PIO_INSTRUMENT`)
+        uint64_t request_id() const { return _request; }
+
+        /// Name of the traced request span, begun when the request is posted and ended by \ref wait or \ref completed
+        static constexpr const char* trace_name() { return (_Access == io::access::ro ? "read" : "write"); }
+
+        /// End the traced request span of requests that were completed by a wait elsewhere, like one collective wait over many promises
+        void completed() const
+        {
+            PIO_TRACE_REQUEST_END(trace_name(), "", 0, _request);
+        }
+
         /// Block until the requests have finished
         /// @return List of status strings for each request
         std::array<std::string, RequestCount> wait() const
         {
             assert(good());
+            PIO_STATS_TIME(wait);
+            PIO_TRACE_SCOPE("wait", "", 0, _request);
 
             std::array<std::string, RequestCount> statuses;
             std::array<int, RequestCount>         statuses_int;
 
             auto* reqs = const_cast<int*>(_handler.value().requests.get());
-            const auto err = ncmpi_wait(_handle, RequestCount, reqs, statuses_int.data());
+            const auto err = _backend->wait(_handle, RequestCount, reqs, statuses_int.data());
             assert(err == NC_NOERR);
+            completed();
 
             impl::static_for<RequestCount>([&](auto n) {
                 constexpr std::size_t i = n;
@@ -126,7 +148,7 @@ namespace pio::io
             return statuses;
         }
 
-        /// Get the data from the given request as a vector
+        /// Get a copy of the data from the given request
         /// \note \ref promise::wait() should be called before trying to access the data
         template<std::size_t _Index>
         std::vector<integral_type<_Index>>
@@ -135,10 +157,23 @@ namespace pio::io
             if constexpr (_Access == io::access::ro)
             {
                 assert(good());
-                const auto& data_ref = _handler.value().data[_Index];
-                std::vector<integral_type<_Index>> data(data_ref.first);
-                std::memcpy(data.data(), data_ref.second.get(), sizeof(integral_type<_Index>) * data.size());
-                return data;
+                return std::get<_Index>(*_handler.value().data);
+            }
+            else
+                assert(false); // need better way to handle this...
+        }
+
+        /// Move the data from the given request out of the promise without copying it
+        /// \note \ref promise::wait() should be called before trying to access the data
+        /// \note Copies of a promise share their data, so afterwards the request is empty in every copy
+        template<std::size_t _Index>
+        std::vector<integral_type<_Index>>
+        take()
+        {
+            if constexpr (_Access == io::access::ro)
+            {
+                assert(good());
+                return std::move(std::get<_Index>(*_handler.value().data));
             }
             else
                 assert(false); // need better way to handle this...
@@ -154,19 +189,55 @@ namespace pio::io
             if constexpr (_Access == io::access::ro)
             {
                 assert(good());
-                return static_cast<integral_type<_Index>*>(
-                    _handler.value().data[_Index].second.get()
-                );
+                return std::get<_Index>(*_handler.value().data).data();
             }
             else 
                 assert(false); // need better way to handle this...
         }
 
+        /// Record which section of the variable a request reads, so \ref view can describe it
+        template<std::size_t _Index>
+        void set_extent(const std::vector<MPI_Offset>& start, const std::vector<MPI_Offset>& count)
+        {
+            static_assert(_Access == io::access::ro);
+            assert(good());
+            _handler.value().extents[_Index] = std::pair(start, count);
+        }
+
+        /// View the data from the given request with the shape and global offset of the section it read
+        /// \note \ref promise::wait() should be called before trying to access the data
+        template<std::size_t _Index>
+        util::view<const integral_type<_Index>>
+        view() const
+        {
+            static_assert(_Access == io::access::ro);
+            assert(good());
+            const auto& data = std::get<_Index>(*_handler.value().data);
+            const auto& [start, count] = _handler.value().extents[_Index];
+            if (count.empty()) return util::view<const integral_type<_Index>>(data.data(), { (MPI_Offset)data.size() });
+            return util::view<const integral_type<_Index>>(data.data(), count, start);
+        }
+
+        /// \copydoc view
+        template<std::size_t _Index>
+        util::view<integral_type<_Index>>
+        view()
+        {
+            static_assert(_Access == io::access::ro);
+            assert(good());
+            auto& data = std::get<_Index>(*_handler.value().data);
+            const auto& [start, count] = _handler.value().extents[_Index];
+            if (count.empty()) return util::view<integral_type<_Index>>(data.data(), { (MPI_Offset)data.size() });
+            return util::view<integral_type<_Index>>(data.data(), count, start);
+        }
+
         int* requests() { return _handler.value().requests.get(); }
 
     private:
+        backend* _backend = nullptr;
         int _handle;
+        uint64_t _request = 0;
         std::optional<E> _error;
-        std::optional<impl::request_handler<_Access, RequestCount>> _handler;
+        std::optional<impl::request_handler<_Access, _Types...>> _handler;
     };
 }
\ No newline at end of file
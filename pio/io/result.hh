@@ -3,6 +3,7 @@
 #include <iostream>
 #include <cassert>
 #include <optional>
+#include <utility>
 
 namespace pio::io
 {
@@ -19,6 +20,10 @@ namespace pio::io
         {   }
 
         base_result(const base_result&) = delete;
+        base_result(base_result&&) = default;
+
+        base_result& operator=(const base_result&) = delete;
+        base_result& operator=(base_result&&) = default;
 
         virtual ~base_result() = default;
 
@@ -33,22 +38,36 @@ namespace pio::io
 
     }
 
-    /// Represents the result from an operation or an error
+    /** \brief Represents the result from an operation or an error
+     *
+     * Results can't be copied, only moved, so large payloads are never duplicated by accident. To take the
+     * value out without a copy, move the result itself:
+     * \code {.cpp}
+     * auto res = file.get_block_connectivity(block);
+     * if (!res) return;
+     * std::vector<int> connectivity = std::move(res).value();
+     * \endcode
+     */
     template<typename T, typename E = int>
     struct result : detail::base_result<T, E>
     {
         using detail::base_result<T, E>::base_result;
 
-        result(T&& val) : _value(val)
+        result(T&& val) : _value(std::move(val))
         {   }
 
+        result(result&&) = default;
+        result& operator=(result&&) = default;
+
         ~result() = default;
 
-        T&       value()       { return _value.value(); }
-        const T& value() const { return _value.value(); }
+        T&       value() &       { return _value.value(); }
+        const T& value() const & { return _value.value(); }
+        T&&      value() &&      { return std::move(_value.value()); }
 
-        T&       operator*()       { return _value.value(); }
-        const T& operator*() const { return _value.value(); }
+        T&       operator*() &       { return _value.value(); }
+        const T& operator*() const & { return _value.value(); }
+        T&&      operator*() &&      { return std::move(_value.value()); }
 
         T*       operator->()       { return &(*_value); }
         const T* operator->() const { return &(*std::as_const(_value)); }
@@ -64,6 +83,8 @@ namespace pio::io
         using detail::base_result<void, E>::base_result;
 
         result()  = default;
+        result(result&&) = default;
+        result& operator=(result&&) = default;
         ~result() = default;
     };
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <cstddef>
+
+namespace pio::io
+{
+    /** \brief Bounded lock-free multi-producer/single-consumer queue
+     *
+     * Any number of threads may \ref push concurrently, but only one thread may \ref pop. Each cell carries a
+     * sequence number that tells producers and the consumer whether the cell is free or holds a value, so no
+     * locks are needed on either side.
+     *
+     * \note The capacity is rounded up to the next power of two
+     */
+    template<typename T>
+    struct ring_buffer
+    {
+        ring_buffer(std::size_t capacity) :
+            _mask([](std::size_t c)
+            {
+                std::size_t r = 1;
+                while (r < c) r <<= 1;
+                return r - 1;
+            }(capacity)),
+            _cells(std::make_unique<cell[]>(_mask + 1)),
+            _head(0),
+            _tail(0)
+        {
+            for (std::size_t i = 0; i <= _mask; i++)
+                _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        ring_buffer(const ring_buffer&) = delete;
+
+        /// Try to enqueue a value, thread-safe for any amount of producers
+        /// @return false if the buffer is full
+        bool push(T&& value)
+        {
+            auto position = _head.load(std::memory_order_relaxed);
+            cell* c = nullptr;
+            for (;;)
+            {
+                c = &_cells[position & _mask];
+                const auto sequence = c->sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+                if (!difference)
+                {
+                    if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0) return false;
+                else position = _head.load(std::memory_order_relaxed);
+            }
+
+            c->value = std::move(value);
+            c->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Try to dequeue a value \note Must only be called from the single consumer thread
+        std::optional<T> pop()
+        {
+            auto& c = _cells[_tail & _mask];
+            if (c.sequence.load(std::memory_order_acquire) != _tail + 1) return std::nullopt;
+
+            std::optional<T> value(std::move(c.value));
+            c.sequence.store(_tail + _mask + 1, std::memory_order_release);
+            _tail++;
+            return value;
+        }
+
+        std::size_t capacity() const { return _mask + 1; }
+
+    private:
+        struct cell
+        {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        const std::size_t _mask;
+        std::unique_ptr<cell[]> _cells;
+        alignas(64) std::atomic<std::size_t> _head; // shared by the producers
+        alignas(64) std::size_t _tail;              // owned by the consumer
+    };
+}
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cassert>
+#include <cstddef>
+
 namespace pio::util
 {
+    /// A contiguous run of `len` elements
     template<typename T>
     struct span
     {
@@ -9,14 +13,20 @@ namespace pio::util
             _ptr(ptr), _len(len)
         {   }
 
-        T& operator[](const std::size_t& index)
+        T& operator[](const std::size_t& index) const
         {
-            // assert(index < _len)
+            assert(index < _len);
             return _ptr[index];
         }
 
+        T* data() const { return _ptr; }
+        std::size_t size() const { return _len; }
+
+        T* begin() const { return _ptr; }
+        T* end()   const { return _ptr + _len; }
+
     private:
         T* _ptr;
         std::size_t _len;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,175 @@
+#include "stats.hh"
+#include "json.hh"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+namespace pio::io::stats
+{
+    registry& registry::get()
+    {
+        static registry instance;
+        return instance;
+    }
+
+    void registry::record_read(const std::string& variable, std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto& c = _variables[variable];
+        c.bytes_read += bytes;
+        c.read_requests++;
+    }
+
+    void registry::record_write(const std::string& variable, std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto& c = _variables[variable];
+        c.bytes_written += bytes;
+        c.write_requests++;
+    }
+
+    void registry::add_time(timer t, double seconds)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _times[(std::size_t)t].first += seconds;
+        _times[(std::size_t)t].second++;
+    }
+
+    void registry::reset()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _variables.clear();
+        _times = {};
+    }
+
+    std::unordered_map<std::string, counters> registry::variables() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _variables;
+    }
+
+    std::array<std::pair<double, std::size_t>, (std::size_t)timer::Count> registry::times() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _times;
+    }
+
+    namespace
+    {
+        thread_local std::array<uint32_t, (std::size_t)timer::Count> depth{};
+    }
+
+    scoped_timer::scoped_timer(timer t) :
+        _timer(t),
+        _start(MPI_Wtime()),
+        _outermost(depth[(std::size_t)t]++ == 0)
+    {   }
+
+    scoped_timer::~scoped_timer()
+    {
+        depth[(std::size_t)_timer]--;
+        if (_outermost) registry::get().add_time(_timer, MPI_Wtime() - _start);
+    }
+
+    std::string to_string(timer t)
+    {
+        switch (t)
+        {
+        case timer::wait:        return "wait";
+        case timer::metadata:    return "metadata";
+        case timer::define:      return "define";
+        case timer::independent: return "independent";
+        default: return "";
+        }
+    }
+
+    /// Every process ends up with the sorted union of the variable names seen on any process
+    static std::vector<std::string> all_names(const std::unordered_map<std::string, counters>& local, MPI_Comm comm)
+    {
+        std::string packed;
+        for (const auto& [name, c] : local) { packed += name; packed += '\0'; }
+
+        int size;
+        MPI_Comm_size(comm, &size);
+
+        int length = packed.size();
+        std::vector<int> lengths(size), displacements(size, 0);
+        MPI_Allgather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, comm);
+        for (int i = 1; i < size; i++) displacements[i] = displacements[i - 1] + lengths[i - 1];
+
+        std::vector<char> gathered(displacements.back() + lengths.back());
+        MPI_Allgatherv(packed.data(), length, MPI_CHAR, gathered.data(), lengths.data(), displacements.data(), MPI_CHAR, comm);
+
+        std::vector<std::string> names;
+        for (std::size_t i = 0; i < gathered.size(); )
+        {
+            names.emplace_back(&gathered[i]);
+            i += names.back().size() + 1;
+        }
+
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        return names;
+    }
+
+    std::string report(MPI_Comm comm)
+    {
+        int size;
+        MPI_Comm_size(comm, &size);
+
+        const auto& reg = registry::get();
+        const auto local = reg.variables();
+        const auto times = reg.times();
+        const auto names = all_names(local, comm);
+
+        // Layout: [seconds, calls] per timer, then the four counters per variable
+        constexpr std::size_t timer_count = (std::size_t)timer::Count;
+        std::vector<double> values;
+        values.reserve(timer_count * 2 + names.size() * 4);
+        for (const auto& [seconds, calls] : times)
+        {
+            values.push_back(seconds);
+            values.push_back(calls);
+        }
+        for (const auto& name : names)
+        {
+            const auto it = local.find(name);
+            const auto c = (it == local.end() ? counters() : it->second);
+            values.push_back(c.bytes_read);
+            values.push_back(c.bytes_written);
+            values.push_back(c.read_requests);
+            values.push_back(c.write_requests);
+        }
+
+        std::vector<double> min(values.size()), max(values.size()), sum(values.size());
+        MPI_Allreduce(values.data(), min.data(), values.size(), MPI_DOUBLE, MPI_MIN, comm);
+        MPI_Allreduce(values.data(), max.data(), values.size(), MPI_DOUBLE, MPI_MAX, comm);
+        MPI_Allreduce(values.data(), sum.data(), values.size(), MPI_DOUBLE, MPI_SUM, comm);
+
+        const auto stat = [&](std::size_t i)
+        {
+            std::stringstream ss;
+            ss << "{\"min\": " << min[i] << ", \"max\": " << max[i] << ", \"mean\": " << sum[i] / size << "}";
+            return ss.str();
+        };
+
+        std::stringstream json;
+        json << "{\"processes\": " << size << ", \"timers\": {";
+        for (std::size_t t = 0; t < timer_count; t++)
+            json << (t ? ", " : "") << "\"" << to_string((timer)t) << "\": {\"seconds\": " << stat(t * 2) << ", \"calls\": " << stat(t * 2 + 1) << "}";
+        json << "}, \"variables\": {";
+        for (std::size_t v = 0; v < names.size(); v++)
+        {
+            const auto base = timer_count * 2 + v * 4;
+            json << (v ? ", " : "") << "\"" << impl::json_escape(names[v]) << "\": {"
+                 << "\"bytes_read\": "     << stat(base)     << ", "
+                 << "\"bytes_written\": "  << stat(base + 1) << ", "
+                 << "\"read_requests\": "  << stat(base + 2) << ", "
+                 << "\"write_requests\": " << stat(base + 3) << "}";
+        }
+        json << "}}";
+        return json.str();
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../external.hh"
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/** \brief Low-overhead I/O counters and timers
+ *
+ * Everything in here is only recorded when the library is built with `PIO_INSTRUMENT` defined (the
+ * `PIO_ENABLE_INSTRUMENTATION` CMake option). Otherwise the `PIO_STATS_*` macros compile to nothing and
+ * \ref pio::io::stats::report only holds zeros.
+ * \code {.cpp}
+ * // ... run the simulation ...
+ * const auto json = io::stats::report(MPI_COMM_WORLD); // collective
+ * if (!rank) std::cout << json << "\n";
+ * \endcode
+ */
+namespace pio::io::stats
+{
+    /// Categories of time spent inside the library
+    enum class timer
+    {
+        wait,        /// Blocked in `promise::wait`
+        metadata,    /// Inquiring about dimensions, variables and (Exodus) entities
+        define,      /// In `ncmpi_redef`/`ncmpi_enddef`
+        independent, /// In `ncmpi_begin_indep_data`
+        Count
+    };
+
+    /// Per-variable traffic
+    struct counters
+    {
+        std::size_t bytes_read = 0, bytes_written = 0, read_requests = 0, write_requests = 0;
+    };
+
+    /// Process-wide store of every counter and timer
+    struct registry
+    {
+        static registry& get();
+
+        void record_read(const std::string& variable, std::size_t bytes);
+        void record_write(const std::string& variable, std::size_t bytes);
+        void add_time(timer t, double seconds);
+
+        /// Clear every counter and timer
+        void reset();
+
+        /// Copies of the current values
+        std::unordered_map<std::string, counters> variables() const;
+        std::array<std::pair<double, std::size_t>, (std::size_t)timer::Count> times() const;
+
+    private:
+        registry() = default;
+
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, counters> _variables;
+        std::array<std::pair<double, std::size_t>, (std::size_t)timer::Count> _times{};
+    };
+
+    /// Adds the time between construction and destruction to a category \note nested timers of the same category only count once
+    struct scoped_timer
+    {
+        scoped_timer(timer t);
+        ~scoped_timer();
+
+        scoped_timer(const scoped_timer&) = delete;
+
+    private:
+        timer _timer;
+        double _start;
+        bool _outermost;
+    };
+
+    /// Name of a timer category as it appears in the report
+    std::string to_string(timer t);
+
+    /// \brief Reduce every counter and timer across `comm` into min/max/mean and format them as JSON
+    /// \note Collective, every process gets the same string back
+    std::string report(MPI_Comm comm);
+}
+
+#ifdef PIO_INSTRUMENT
+#define PIO_STATS_CONCAT_IMPL(a, b) a##b
+#define PIO_STATS_CONCAT(a, b) PIO_STATS_CONCAT_IMPL(a, b)
+#define PIO_STATS_TIME(category) const pio::io::stats::scoped_timer PIO_STATS_CONCAT(_pio_timer_, __LINE__)(pio::io::stats::timer::category)
+#define PIO_STATS_READ(variable, bytes) pio::io::stats::registry::get().record_read(variable, bytes)
+#define PIO_STATS_WRITE(variable, bytes) pio::io::stats::registry::get().record_write(variable, bytes)
+#else
+#define PIO_STATS_TIME(category)
+#define PIO_STATS_READ(variable, bytes)
+#define PIO_STATS_WRITE(variable, bytes)
+#endif
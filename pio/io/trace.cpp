@@ -0,0 +1,174 @@
+#include "trace.hh"
+#include "json.hh"
+
+#include <fstream>
+#include <memory>
+#include <thread>
+
+namespace pio::io::trace
+{
+    namespace
+    {
+        // Hooks are swapped as a whole so that callers never see half of a pair
+        std::mutex hooks_mutex;
+        std::shared_ptr<const hooks> installed;
+        std::atomic<bool> enabled{false};
+        std::atomic<uint64_t> request_counter{0};
+
+        std::shared_ptr<const hooks> current()
+        {
+            std::lock_guard<std::mutex> lock(hooks_mutex);
+            return installed;
+        }
+
+        int world_rank()
+        {
+            int initialized = 0, finalized = 0;
+            MPI_Initialized(&initialized);
+            MPI_Finalized(&finalized);
+            if (!initialized || finalized) return 0;
+
+            int rank;
+            MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+            return rank;
+        }
+
+        event make_event(kind type, const char* name, const std::string& variable, std::size_t bytes, uint64_t request)
+        {
+            return event{ type, name, world_rank(), variable, bytes, request, MPI_Wtime() };
+        }
+    }
+
+    void install(hooks h)
+    {
+        std::lock_guard<std::mutex> lock(hooks_mutex);
+        installed = std::make_shared<const hooks>(std::move(h));
+        enabled = true;
+    }
+
+    void uninstall()
+    {
+        std::lock_guard<std::mutex> lock(hooks_mutex);
+        installed.reset();
+        enabled = false;
+    }
+
+    bool active()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    uint64_t next_request()
+    {
+        return ++request_counter;
+    }
+
+    void begin(kind type, const char* name, const std::string& variable, std::size_t bytes, uint64_t request)
+    {
+        if (!active()) return;
+        const auto h = current();
+        if (h && h->begin) h->begin(make_event(type, name, variable, bytes, request));
+    }
+
+    void end(kind type, const char* name, const std::string& variable, std::size_t bytes, uint64_t request)
+    {
+        if (!active()) return;
+        const auto h = current();
+        if (h && h->end) h->end(make_event(type, name, variable, bytes, request));
+    }
+
+    scope::scope(const char* name, const std::string& variable, std::size_t bytes, uint64_t request) :
+        _name(name),
+        _bytes(bytes),
+        _request(request),
+        _active(active())
+    {
+        if (!_active) return;
+        _variable = variable;
+        begin(kind::scope, _name, _variable, _bytes, _request);
+    }
+
+    scope::~scope()
+    {
+        if (_active) end(kind::scope, _name, _variable, _bytes, _request);
+    }
+
+    batch::batch(const char* name) :
+        _name(name)
+    {   }
+
+    batch::~batch()
+    {
+        end();
+    }
+
+    void batch::begin(const std::string& variable, std::size_t bytes)
+    {
+        if (!active()) return;
+        const auto request = next_request();
+        trace::begin(kind::request, _name, variable, bytes, request);
+        _open.push_back(span{ variable, bytes, request });
+    }
+
+    void batch::end()
+    {
+        for (const auto& s : _open)
+            trace::end(kind::request, _name, s.variable, s.bytes, s.request);
+        _open.clear();
+    }
+
+    chrome_sink::chrome_sink(const std::string& prefix) :
+        _prefix(prefix)
+    {   }
+
+    trace::hooks chrome_sink::hooks()
+    {
+        return {
+            [this](const event& e) { _record(e, (e.type == kind::scope ? 'B' : 'b')); },
+            [this](const event& e) { _record(e, (e.type == kind::scope ? 'E' : 'e')); }
+        };
+    }
+
+    void chrome_sink::_record(const event& e, char phase)
+    {
+        const uint64_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+        std::lock_guard<std::mutex> lock(_mutex);
+        _records.push_back(record{ e, phase, thread });
+    }
+
+    bool chrome_sink::write() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        const int rank = world_rank();
+        std::ofstream file(_prefix + "." + std::to_string(rank) + ".json");
+        if (!file) return false;
+
+        // Threads get small ids in the order they first appear
+        std::vector<uint64_t> threads;
+        const auto thread_index = [&](uint64_t thread)
+        {
+            for (std::size_t i = 0; i < threads.size(); i++)
+                if (threads[i] == thread) return i;
+            threads.push_back(thread);
+            return threads.size() - 1;
+        };
+
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        file << "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": " << rank << ", \"args\": {\"name\": \"rank " << rank << "\"}}";
+        file.precision(3);
+        for (const auto& r : _records)
+        {
+            file << ",\n{\"ph\": \"" << r.phase << "\", \"name\": \"" << r.e.name << "\""
+                 << ", \"cat\": \"" << (r.e.type == kind::scope ? "call" : "request") << "\""
+                 << ", \"pid\": " << r.e.rank << ", \"tid\": " << thread_index(r.thread)
+                 << ", \"ts\": " << std::fixed << r.e.time * 1e6;
+            if (r.e.type == kind::request) file << ", \"id\": " << r.e.request;
+            file << ", \"args\": {\"variable\": \"" << impl::json_escape(r.e.variable) << "\", \"bytes\": " << r.e.bytes
+                 << ", \"request\": " << r.e.request << "}}";
+        }
+        file << "\n]}\n";
+
+        return file.good();
+    }
+}
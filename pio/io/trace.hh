@@ -0,0 +1,162 @@
+#pragma once
+
+#include "../external.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** \brief Timeline hooks for requests and library calls
+ *
+ * Where \ref pio::io::stats aggregates, tracing reports every call as it happens: a `scope` event spans a
+ * library call (posting a read, waiting, planning a distribution) and a `request` event spans a request from
+ * the moment it is posted until the wait that completes it returns, whether that is \ref pio::io::promise::wait or
+ * one wait over many requests (see \ref pio::io::promise::completed and \ref batch). Like the counters, the call sites
+ * are only compiled in with `PIO_INSTRUMENT`, and nothing is reported until hooks are installed.
+ * \code {.cpp}
+ * io::trace::chrome_sink sink("trace");   // writes trace.<rank>.json
+ * io::trace::install(sink.hooks());
+ * // ... run the simulation ...
+ * io::trace::uninstall();
+ * sink.write();
+ * \endcode
+ */
+namespace pio::io::trace
+{
+    enum class kind
+    {
+        scope,  /// A library call, begins and ends on the same thread
+        request /// The lifetime of a non-blocking request, may end on a different thread
+    };
+
+    struct event
+    {
+        kind type;
+        const char* name;       /// Call or request name, always a string literal
+        int rank;               /// Rank in `MPI_COMM_WORLD`
+        std::string variable;   /// Variable the call concerns (empty if none)
+        std::size_t bytes;      /// Payload size (zero if unknown)
+        uint64_t request;       /// Id of the request the event belongs to (zero if none)
+        double time;            /// `MPI_Wtime()` at the event
+    };
+
+    /// Callbacks invoked at the beginning and end of every event \note can be called from several threads at once
+    struct hooks
+    {
+        std::function<void(const event&)> begin, end;
+    };
+
+    /// Replace the installed hooks
+    void install(hooks h);
+
+    /// Remove the installed hooks
+    void uninstall();
+
+    /// Whether any hooks are installed
+    bool active();
+
+    /// A new process-unique request id (never zero)
+    uint64_t next_request();
+
+    void begin(kind type, const char* name, const std::string& variable = "", std::size_t bytes = 0, uint64_t request = 0);
+    void end(kind type, const char* name, const std::string& variable = "", std::size_t bytes = 0, uint64_t request = 0);
+
+    /// Reports a scope event between construction and destruction
+    struct scope
+    {
+        scope(const char* name, const std::string& variable = "", std::size_t bytes = 0, uint64_t request = 0);
+        ~scope();
+
+        scope(const scope&) = delete;
+
+    private:
+        const char* _name;
+        std::string _variable;
+        std::size_t _bytes;
+        uint64_t _request;
+        bool _active;
+    };
+
+    /** \brief Request spans of raw requests that are posted one at a time and completed by a single wait
+     *
+     * Spans still open when the batch is destroyed are ended then, so an early return on an error (once the
+     * requests have been waited on or cancelled) leaves none behind.
+     */
+    struct batch
+    {
+        batch(const char* name);
+        ~batch();
+
+        batch(const batch&) = delete;
+
+        /// Begin the span of a request that was just posted
+        void begin(const std::string& variable = "", std::size_t bytes = 0);
+
+        /// End the span of every request begun so far
+        void end();
+
+    private:
+        struct span
+        {
+            std::string variable;
+            std::size_t bytes;
+            uint64_t request;
+        };
+
+        const char* _name;
+        std::vector<span> _open;
+    };
+
+    /** \brief Collects events in memory and writes them in the Chrome trace-event format
+     *
+     * Each rank writes its own `<prefix>.<rank>.json`, which can be opened in `chrome://tracing` or Perfetto.
+     * Timestamps come from `MPI_Wtime`, so files from different ranks line up when `MPI_WTIME_IS_GLOBAL` holds.
+     */
+    struct chrome_sink
+    {
+        chrome_sink(const std::string& prefix);
+
+        chrome_sink(const chrome_sink&) = delete;
+
+        /// Hooks that record into this sink \note the sink must outlive them being installed
+        trace::hooks hooks();
+
+        /// Write everything recorded so far \return whether the file could be written
+        bool write() const;
+
+    private:
+        struct record
+        {
+            event e;
+            char phase;
+            uint64_t thread;
+        };
+
+        void _record(const event& e, char phase);
+
+        std::string _prefix;
+        mutable std::mutex _mutex;
+        std::vector<record> _records;
+    };
+}
+
+#ifdef PIO_INSTRUMENT
+#define PIO_TRACE_CONCAT_IMPL(a, b) a##b
+#define PIO_TRACE_CONCAT(a, b) PIO_TRACE_CONCAT_IMPL(a, b)
+#define PIO_TRACE_SCOPE(...) const pio::io::trace::scope PIO_TRACE_CONCAT(_pio_trace_, __LINE__)(__VA_ARGS__)
+#define PIO_TRACE_REQUEST_BEGIN(...) pio::io::trace::begin(pio::io::trace::kind::request, __VA_ARGS__)
+#define PIO_TRACE_REQUEST_END(...) pio::io::trace::end(pio::io::trace::kind::request, __VA_ARGS__)
+#define PIO_TRACE_BATCH(var, name) pio::io::trace::batch var(name)
+#define PIO_TRACE_BATCH_BEGIN(var, ...) var.begin(__VA_ARGS__)
+#define PIO_TRACE_BATCH_END(var) var.end()
+#else
+#define PIO_TRACE_SCOPE(...)
+#define PIO_TRACE_REQUEST_BEGIN(...)
+#define PIO_TRACE_REQUEST_END(...)
+#define PIO_TRACE_BATCH(var, name)
+#define PIO_TRACE_BATCH_BEGIN(var, ...)
+#define PIO_TRACE_BATCH_END(var)
+#endif
@@ -6,4 +6,11 @@ namespace pio::io
     const func_ptr<type<NC_FLOAT>::integral_type> type<NC_FLOAT>::func = &ncmpi_iget_vara_float;
     const func_ptr<type<NC_CHAR>::integral_type> type<NC_CHAR>::func = &ncmpi_iget_vara_text;
     const func_ptr<type<NC_INT>::integral_type> type<NC_INT>::func = &ncmpi_iget_vara_int;
+    const func_ptr<type<NC_INT64>::integral_type> type<NC_INT64>::func = &ncmpi_iget_vara_longlong;
+
+    const MPI_Datatype type<NC_DOUBLE>::mpi = MPI_DOUBLE;
+    const MPI_Datatype type<NC_FLOAT>::mpi = MPI_FLOAT;
+    const MPI_Datatype type<NC_CHAR>::mpi = MPI_CHAR;
+    const MPI_Datatype type<NC_INT>::mpi = MPI_INT;
+    const MPI_Datatype type<NC_INT64>::mpi = MPI_LONG_LONG;
 }
\ No newline at end of file
@@ -26,6 +26,8 @@ namespace pio::io
     }
 
     /// An isomorphism of primitive data-types to MPI/NC data types.
+    /// \note The type used in memory doesn't need to match the type a variable is stored as, values are converted
+    /// on the way in and out (see \ref io::convertible)
     template<nc_type T>
     struct type
     {   };
@@ -40,6 +42,7 @@ namespace pio::io
         const static nc_type nc = NC_DOUBLE;
         using integral_type = double; 
         const static func_ptr<integral_type> func;
+        const static MPI_Datatype mpi;
     };
 
     /** @copydoc type */
@@ -49,6 +52,7 @@ namespace pio::io
         const static nc_type nc = NC_CHAR;
         using integral_type = char; 
         const static func_ptr<integral_type> func;
+        const static MPI_Datatype mpi;
     };
     
     /** @copydoc type */
@@ -58,6 +62,7 @@ namespace pio::io
         const static nc_type nc = NC_FLOAT;
         using integral_type = float; 
         const static func_ptr<integral_type> func;
+        const static MPI_Datatype mpi;
     };
     
     /** @copydoc type */
@@ -67,6 +72,17 @@ namespace pio::io
         const static nc_type nc = NC_INT;
         using integral_type = int; 
         const static func_ptr<integral_type> func;
+        const static MPI_Datatype mpi;
+    };
+
+    /** @copydoc type */
+    template<>
+    struct type<NC_INT64> 
+    { 
+        const static nc_type nc = NC_INT64;
+        using integral_type = long long; 
+        const static func_ptr<integral_type> func;
+        const static MPI_Datatype mpi;
     };
 
 #define CASE_SIZE_TYPE(t) case t: return sizeof(io::type<t>::integral_type)
@@ -80,6 +96,7 @@ namespace pio::io
         CASE_SIZE_TYPE(NC_DOUBLE);
         CASE_SIZE_TYPE(NC_FLOAT);
         CASE_SIZE_TYPE(NC_INT);
+        CASE_SIZE_TYPE(NC_INT64);
         }
         return 0;
     }
@@ -93,4 +110,5 @@ namespace pio::types
     using Float = io::type<NC_FLOAT>;
     using Char = io::type<NC_CHAR>;
     using Int = io::type<NC_INT>;
+    using Int64 = io::type<NC_INT64>;
 }
\ No newline at end of file
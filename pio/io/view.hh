@@ -0,0 +1,188 @@
+#pragma once
+
+#include "../external.hh"
+
+#include "span.hh"
+
+#include <cassert>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace pio::util
+{
+    /** \brief A non-owning multi-dimensional view of a section of a variable
+     *
+     * Besides the shape of the buffer, a view remembers where the buffer sits in the variable (its global
+     * offset), so a \ref io::distributor::subvolume can be cut out of a larger buffer and written without any
+     * index arithmetic:
+     * \code {.cpp}
+     * util::view<const double> whole(values.data(), { 1, num_elem });
+     * const auto mine = whole.slice(subvol.offsets, subvol.counts);
+     * file.write_variable<types::Double>(name, mine);
+     * \endcode
+     * Indices passed to `operator()` and `at` are local to the view, indices passed to `global` and `slice`
+     * are in the coordinates of the variable.
+     */
+    template<typename T>
+    struct view
+    {
+        view() = default;
+
+        /// A dense row-major view \note an empty offset places the view at the origin
+        view(T* data, std::vector<MPI_Offset> shape, std::vector<MPI_Offset> offset = {}) :
+            _data(data),
+            _shape(std::move(shape)),
+            _offset(std::move(offset)),
+            _strides(row_major(_shape))
+        {
+            if (_offset.empty()) _offset.resize(_shape.size(), 0);
+            assert(_offset.size() == _shape.size());
+        }
+
+        /// A view with explicit strides (in elements)
+        view(T* data, std::vector<MPI_Offset> shape, std::vector<MPI_Offset> offset, std::vector<MPI_Offset> strides) :
+            _data(data),
+            _shape(std::move(shape)),
+            _offset(std::move(offset)),
+            _strides(std::move(strides))
+        {
+            assert(_offset.size() == _shape.size() && _strides.size() == _shape.size());
+        }
+
+        /// A mutable view converts to a const one
+        template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+        view(const view<U>& other) :
+            view(other.data(), other.shape(), other.offset(), other.strides())
+        {   }
+
+        std::size_t rank() const { return _shape.size(); }
+
+        const std::vector<MPI_Offset>& shape()   const { return _shape; }
+        const std::vector<MPI_Offset>& offset()  const { return _offset; }
+        const std::vector<MPI_Offset>& strides() const { return _strides; }
+
+        T* data() const { return _data; }
+
+        /// Number of elements in the view
+        std::size_t size() const
+        {
+            return std::accumulate(_shape.begin(), _shape.end(), std::size_t(1), std::multiplies<std::size_t>());
+        }
+
+        /// Whether the elements are laid out densely in row-major order, as a single request would read or write them
+        bool contiguous() const
+        {
+            const auto dense = row_major(_shape);
+            for (std::size_t i = 0; i < rank(); i++)
+                if (_shape[i] > 1 && _strides[i] != dense[i]) return false;
+            return true;
+        }
+
+        /// Element at local indices
+        template<typename... _Indices>
+        T& operator()(_Indices... indices) const
+        {
+            static_assert((std::is_integral_v<_Indices> && ...));
+            assert(sizeof...(_Indices) == rank());
+
+            std::size_t dim = 0;
+            MPI_Offset flat = 0;
+            ((assert((MPI_Offset)indices < _shape[dim]), flat += (MPI_Offset)indices * _strides[dim++]), ...);
+            return _data[flat];
+        }
+
+        /// Element at local indices
+        T& at(const std::vector<MPI_Offset>& index) const
+        {
+            assert(index.size() == rank());
+            MPI_Offset flat = 0;
+            for (std::size_t i = 0; i < rank(); i++)
+            {
+                assert(index[i] >= 0 && index[i] < _shape[i]);
+                flat += index[i] * _strides[i];
+            }
+            return _data[flat];
+        }
+
+        /// Element at indices in the coordinates of the variable
+        T& global(const std::vector<MPI_Offset>& index) const
+        {
+            assert(index.size() == rank());
+            std::vector<MPI_Offset> local(rank());
+            for (std::size_t i = 0; i < rank(); i++) local[i] = index[i] - _offset[i];
+            return at(local);
+        }
+
+        /// The view with its leading dimension fixed at local index `i`
+        view operator[](MPI_Offset i) const
+        {
+            assert(rank() && i >= 0 && i < _shape[0]);
+            return view(
+                _data + i * _strides[0],
+                std::vector<MPI_Offset>(_shape.begin() + 1, _shape.end()),
+                std::vector<MPI_Offset>(_offset.begin() + 1, _offset.end()),
+                std::vector<MPI_Offset>(_strides.begin() + 1, _strides.end())
+            );
+        }
+
+        /// A section of this view, `begin` is in the coordinates of the variable \note no data is copied
+        view slice(const std::vector<MPI_Offset>& begin, const std::vector<MPI_Offset>& count) const
+        {
+            assert(begin.size() == rank() && count.size() == rank());
+            MPI_Offset flat = 0;
+            for (std::size_t i = 0; i < rank(); i++)
+            {
+                assert(begin[i] >= _offset[i] && begin[i] + count[i] <= _offset[i] + _shape[i]);
+                flat += (begin[i] - _offset[i]) * _strides[i];
+            }
+            return view(_data + flat, count, begin, _strides);
+        }
+
+        /// A section of this view along a single dimension, `begin` is in the coordinates of the variable
+        view slice(std::size_t dim, MPI_Offset begin, MPI_Offset count) const
+        {
+            assert(dim < rank());
+            auto b = _offset;
+            auto c = _shape;
+            b[dim] = begin;
+            c[dim] = count;
+            return slice(b, c);
+        }
+
+        /// Number of rows along the innermost dimension
+        std::size_t rows() const
+        {
+            if (!rank()) return 1;
+            return std::accumulate(_shape.begin(), _shape.end() - 1, std::size_t(1), std::multiplies<std::size_t>());
+        }
+
+        /// The `r`th innermost row (in row-major order) \note the innermost dimension must have unit stride
+        span<T> row(std::size_t r) const
+        {
+            if (!rank()) return span<T>(_data, 1);
+            assert(_strides.back() == 1 && r < rows());
+
+            MPI_Offset flat = 0;
+            for (std::size_t i = rank() - 1; i-- > 0; )
+            {
+                flat += (MPI_Offset)(r % _shape[i]) * _strides[i];
+                r /= _shape[i];
+            }
+            return span<T>(_data + flat, _shape.back());
+        }
+
+        /// Strides of a dense row-major array of the given shape
+        static std::vector<MPI_Offset> row_major(const std::vector<MPI_Offset>& shape)
+        {
+            std::vector<MPI_Offset> strides(shape.size(), 1);
+            for (std::size_t i = shape.size(); i-- > 1; )
+                strides[i - 1] = strides[i] * shape[i];
+            return strides;
+        }
+
+    private:
+        T* _data = nullptr;
+        std::vector<MPI_Offset> _shape, _offset, _strides;
+    };
+}
@@ -0,0 +1,710 @@
+#include "checkpoint.hh"
+
+#include "../io/hash.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <optional>
+
+#define NET_CHECK(res) { const auto err = res; if (err != NC_NOERR) return { pio::netcdf::netcdf_error(err) }; }
+#define RES_CHECK(res) { const auto r = res; if (!r) return { r.error() }; }
+
+namespace pio::netcdf
+{
+
+/// Dimension `i` of field `name`, every field gets its own so that no two have to agree on a length
+static std::string dimension_name(const std::string& name, std::size_t i)
+{
+    return name + "_dim" + std::to_string(i);
+}
+
+/// Wait for every request at once, which is collective, so each process must call it
+static result<void> wait_collective(io::backend& storage, int handle, std::vector<int>& requests)
+{
+    std::vector<int> statuses(requests.size());
+    {
+        PIO_STATS_TIME(wait);
+        NET_CHECK(storage.wait_all(handle, requests.size(), requests.data(), statuses.data()));
+    }
+    for (const auto status : statuses)
+        if (status != NC_NOERR) return { netcdf_error(status) };
+    return { };
+}
+
+static result<void> end_independent(io::backend& storage, int handle)
+{
+    const auto err = storage.end_indep_data(handle);
+    if (err != NC_NOERR && err != NC_ENOTINDEP) return { netcdf_error(err) };
+    return { };
+}
+
+template<typename _Type>
+result<void>
+checkpoint::add(const std::string& name, const std::vector<MPI_Offset>& shape, const util::view<const typename _Type::integral_type>& local)
+{
+    using value_type = typename _Type::integral_type;
+
+    if (local.rank() != shape.size()) return { error_code::DimensionSizeMismatch };
+    for (std::size_t i = 0; i < shape.size(); i++)
+        if (local.offset()[i] < 0 || local.offset()[i] + local.shape()[i] > shape[i]) return { error_code::IndexOutOfBounds };
+
+    field f{ name, _Type::nc, _Type::mpi, shape, local.offset(), local.shape(), local.data(), { }, local.size() };
+    if (f.size && !local.contiguous())
+    {
+        // Strided pieces are packed row by row, PnetCDF then sees a single dense buffer like any other
+        f.packed.resize(f.size * sizeof(value_type));
+        auto* out = reinterpret_cast<value_type*>(f.packed.data());
+        for (std::size_t r = 0; r < local.rows(); r++)
+        {
+            const auto row = local.row(r);
+            std::memcpy(out, row.data(), row.size() * sizeof(value_type));
+            out += row.size();
+        }
+        f.data = nullptr;
+    }
+
+    _fields.push_back(std::move(f));
+    return { };
+}
+template result<void> checkpoint::add<types::Double>(const std::string&, const std::vector<MPI_Offset>&, const util::view<const double>&);
+template result<void> checkpoint::add<types::Float>(const std::string&, const std::vector<MPI_Offset>&, const util::view<const float>&);
+template result<void> checkpoint::add<types::Int>(const std::string&, const std::vector<MPI_Offset>&, const util::view<const int>&);
+template result<void> checkpoint::add<types::Int64>(const std::string&, const std::vector<MPI_Offset>&, const util::view<const long long>&);
+
+result<void>
+checkpoint::write(file<io::access::wo>& file) const
+{
+    if (!file) return { error_code::NullFile };
+
+    const auto defined = file.define([&]() -> result<void>
+    {
+        for (const auto& f : _fields)
+        {
+            std::vector<int> dimensions;
+            for (std::size_t i = 0; i < f.shape.size(); i++)
+            {
+                int id;
+                NET_CHECK(file.storage().def_dim(file.get_handle(), dimension_name(f.name, i).c_str(), f.shape[i], &id));
+                dimensions.push_back(id);
+            }
+
+            int index;
+            NET_CHECK(file.storage().def_var(file.get_handle(), f.name.c_str(), f.type, dimensions.size(), dimensions.data(), &index));
+        }
+        return { };
+    });
+    if (!defined) return { defined.error() };
+
+    const auto collective = end_independent(file.storage(), file.get_handle());
+    if (!collective) return { collective.error() };
+
+    std::size_t bytes = 0;
+    for (const auto& f : _fields) bytes += f.size * io::nc_sizeof(f.type);
+    PIO_TRACE_SCOPE("checkpoint::write", "", bytes);
+    PIO_TRACE_BATCH(spans, "write");
+
+    // Processes without a piece post nothing, and a process that fails a lookup or a post stops, but both still take part in the collective wait
+    int posted = NC_NOERR;
+    std::vector<int> indices;
+    for (const auto& f : _fields)
+    {
+        int index;
+        posted = file.storage().inq_varid(file.get_handle(), f.name.c_str(), &index);
+        if (posted != NC_NOERR) break;
+        indices.push_back(index);
+    }
+
+    std::vector<int> requests;
+    for (std::size_t i = 0; i < _fields.size() && posted == NC_NOERR; i++)
+    {
+        const auto& f = _fields[i];
+        if (!f.size) continue;
+
+        int request;
+        posted = file.storage().iput_vara(file.get_handle(), indices[i], f.offsets.data(), f.counts.data(), f.values(), f.size, f.mpi, &request);
+        if (posted != NC_NOERR) break;
+
+        requests.push_back(request);
+        PIO_STATS_WRITE(f.name, f.size * io::nc_sizeof(f.type));
+        PIO_TRACE_BATCH_BEGIN(spans, f.name, f.size * io::nc_sizeof(f.type));
+    }
+
+    const auto res = wait_collective(file.storage(), file.get_handle(), requests);
+    PIO_TRACE_BATCH_END(spans);
+    if (posted != NC_NOERR) return { netcdf_error(posted) };
+    if (!res) return { res.error() };
+    return { };
+}
+
+result<void>
+checkpoint::write(const std::string& filename) const
+{
+    file<io::access::wo> out(filename, staging(), file_format::cdf5);
+    return write(out);
+}
+
+result<std::vector<checkpoint_variable>>
+checkpoint_variables(const file<io::access::ro>& file)
+{
+    if (!file) return { error_code::NullFile };
+
+    const auto names = file.variable_names();
+    if (!names) return { names.error() };
+
+    std::vector<checkpoint_variable> variables;
+    for (const auto& name : *names)
+    {
+        const auto info = file.get_variable_info(name);
+        if (!info) return { info.error() };
+
+        checkpoint_variable v{ name, info->type, { } };
+        for (const auto& d : info->dimensions) v.shape.push_back(d.length);
+        variables.push_back(std::move(v));
+    }
+
+    return { std::move(variables) };
+}
+
+template<typename _Type>
+result<std::vector<checkpoint_slice<_Type>>>
+read_checkpoint(const file<io::access::ro>& file, std::vector<checkpoint_slice<_Type>> slices)
+{
+    if (!file) return { error_code::NullFile };
+
+    const auto collective = end_independent(file.storage(), file.get_handle());
+    if (!collective) return { collective.error() };
+
+    // Each process brings its own slices, so a lookup that fails on one is held until after the collective wait
+    std::optional<error_code> failure;
+
+    // Size every buffer before posting, so nothing moves while reads are outstanding
+    std::vector<int> indices;
+    for (auto& slice : slices)
+    {
+        int index, dimensions;
+        nc_type type;
+        auto err = file.storage().inq_varid(file.get_handle(), slice.name.c_str(), &index);
+        if (err == NC_NOERR) err = file.storage().inq_vartype(file.get_handle(), index, &type);
+        if (err == NC_NOERR) err = file.storage().inq_varndims(file.get_handle(), index, &dimensions);
+        if (err != NC_NOERR) { failure = netcdf_error(err); break; }
+        if (!io::convertible(type, _Type::nc)) { failure = error_code::TypeMismatch; break; }
+        if (slice.offsets.size() != (std::size_t)dimensions || slice.counts.size() != slice.offsets.size()) { failure = error_code::DimensionSizeMismatch; break; }
+
+        slice.values.resize(std::accumulate(slice.counts.begin(), slice.counts.end(), std::size_t(1), std::multiplies<std::size_t>()));
+        indices.push_back(index);
+    }
+
+    std::size_t bytes = 0;
+    for (const auto& slice : slices) bytes += slice.values.size() * sizeof(typename _Type::integral_type);
+    PIO_TRACE_SCOPE("read_checkpoint", "", bytes);
+    PIO_TRACE_BATCH(spans, "read");
+
+    // A process that fails to post still takes part in the collective wait
+    std::vector<int> requests;
+    for (std::size_t i = 0; i < slices.size() && !failure; i++)
+    {
+        auto& slice = slices[i];
+        if (slice.values.empty()) continue;
+
+        int request;
+        const auto err = file.storage().iget_vara(file.get_handle(), indices[i], slice.offsets.data(), slice.counts.data(), slice.values.data(), slice.values.size(), _Type::mpi, &request);
+        if (err != NC_NOERR) { failure = netcdf_error(err); break; }
+
+        requests.push_back(request);
+        PIO_STATS_READ(slice.name, slice.values.size() * sizeof(typename _Type::integral_type));
+        PIO_TRACE_BATCH_BEGIN(spans, slice.name, slice.values.size() * sizeof(typename _Type::integral_type));
+    }
+
+    const auto res = wait_collective(file.storage(), file.get_handle(), requests);
+    PIO_TRACE_BATCH_END(spans);
+    if (failure) return { *failure };
+    if (!res) return { res.error() };
+    return { std::move(slices) };
+}
+template result<std::vector<checkpoint_slice<types::Double>>> read_checkpoint<types::Double>(const file<io::access::ro>&, std::vector<checkpoint_slice<types::Double>>);
+template result<std::vector<checkpoint_slice<types::Float>>> read_checkpoint<types::Float>(const file<io::access::ro>&, std::vector<checkpoint_slice<types::Float>>);
+template result<std::vector<checkpoint_slice<types::Int>>> read_checkpoint<types::Int>(const file<io::access::ro>&, std::vector<checkpoint_slice<types::Int>>);
+template result<std::vector<checkpoint_slice<types::Int64>>> read_checkpoint<types::Int64>(const file<io::access::ro>&, std::vector<checkpoint_slice<types::Int64>>);
+
+template<typename _Type>
+result<std::vector<checkpoint_slice<_Type>>>
+read_checkpoint(MPI_Comm comm, const file<io::access::ro>& file, const std::vector<std::string>& names)
+{
+    if (!file) return { error_code::NullFile };
+
+    io::distributor dist(comm);
+    for (uint32_t i = 0; i < names.size(); i++)
+    {
+        const auto info = file.get_variable_info(names[i]);
+        if (!info) return { info.error() };
+
+        io::distributor::volume vol;
+        vol.data_index = i;
+        vol.data_type = info->type;
+        for (const auto& d : info->dimensions) vol.dimensions.push_back(d.length);
+        dist.data_volumes.push_back(vol);
+    }
+
+    const auto tasks = dist.get_tasks();
+    if (!tasks) return { error_code::FailedTaskCreation };
+
+    std::vector<checkpoint_slice<_Type>> slices;
+    for (const auto& task : *tasks)
+        slices.push_back(checkpoint_slice<_Type>{ names[dist.data_volumes[task.volume_index].data_index], task.offsets, task.counts, { } });
+
+    return read_checkpoint<_Type>(file, std::move(slices));
+}
+template result<std::vector<checkpoint_slice<types::Double>>> read_checkpoint<types::Double>(MPI_Comm, const file<io::access::ro>&, const std::vector<std::string>&);
+template result<std::vector<checkpoint_slice<types::Float>>> read_checkpoint<types::Float>(MPI_Comm, const file<io::access::ro>&, const std::vector<std::string>&);
+template result<std::vector<checkpoint_slice<types::Int>>> read_checkpoint<types::Int>(MPI_Comm, const file<io::access::ro>&, const std::vector<std::string>&);
+template result<std::vector<checkpoint_slice<types::Int64>>> read_checkpoint<types::Int64>(MPI_Comm, const file<io::access::ro>&, const std::vector<std::string>&);
+
+
+/// Number of values in the dimensions after the first, a "row" of a chunk
+static MPI_Offset row_size(const std::vector<MPI_Offset>& counts)
+{
+    return std::accumulate(counts.begin() + 1, counts.end(), MPI_Offset(1), std::multiplies<MPI_Offset>());
+}
+
+/// Visit every chunk the rows [first, first + count) overlap, with the part of the rows inside it
+template<typename F>
+static void for_each_chunk(MPI_Offset first, MPI_Offset count, MPI_Offset chunk_rows, F&& f)
+{
+    if (count <= 0) return;
+    for (MPI_Offset k = first / chunk_rows; k <= (first + count - 1) / chunk_rows; k++)
+    {
+        const auto begin = std::max(first, k * chunk_rows);
+        const auto end = std::min(first + count, (k + 1) * chunk_rows);
+        f(k, begin, end);
+    }
+}
+
+incremental_checkpoint::incremental_checkpoint(MPI_Comm comm, const std::string& base, std::size_t chunk_bytes) :
+    _comm(comm),
+    _base(base),
+    _chunk_bytes(std::max<std::size_t>(chunk_bytes, 1))
+{   }
+
+std::string
+incremental_checkpoint::path(const std::string& base, std::size_t generation)
+{
+    return base + "." + std::to_string(generation) + ".nc";
+}
+
+result<std::size_t>
+incremental_checkpoint::write()
+{
+    const auto& fields = _pending._fields;
+    const int generation = _generation;
+
+    // Hash this process' part of every chunk and decide what changed
+    struct plan
+    {
+        history next;
+        std::size_t first_flag; /// Position of the field's chunks in `dirty`
+        std::vector<MPI_Offset> chunks; /// The chunks written, in the order they are stored
+    };
+    std::vector<plan> plans;
+    std::vector<int> dirty;
+
+    for (const auto& f : fields)
+    {
+        // Empty dimensions can't be defined, a length of zero means the record dimension
+        // (a bare error code would convert to the generation returned, hence the explicit error_code)
+        if (f.shape.empty() || std::find(f.shape.begin(), f.shape.end(), 0) != f.shape.end()) return { error_code(error_code::DimensionSizeMismatch) };
+
+        const auto element = io::nc_sizeof(f.type);
+        const auto rows = std::max<MPI_Offset>(1, _chunk_bytes / std::max<std::size_t>(1, row_size(f.shape) * element));
+        const auto chunk_count = (f.shape[0] + rows - 1) / rows;
+
+        plan p{ history{ f.type, rows, f.shape, f.offsets, f.counts, { }, { } }, dirty.size(), { } };
+        const auto it = _history.find(f.name);
+        const bool known = (it != _history.end() && it->second.type == f.type && it->second.shape == f.shape && it->second.chunk_rows == rows);
+        p.next.generations = (known ? it->second.generations : std::vector<int>(chunk_count, -1));
+
+        // The old hashes only mean something if the piece covers the same part of the array
+        const bool same_piece = (known && it->second.offsets == f.offsets && it->second.counts == f.counts);
+        dirty.resize(dirty.size() + chunk_count, 0);
+        for (MPI_Offset k = 0; k < chunk_count; k++)
+            if (p.next.generations[k] < 0) dirty[p.first_flag + k] = 1;
+
+        const auto* bytes = static_cast<const unsigned char*>(f.values());
+        const auto local_row = row_size(f.counts) * element;
+        std::size_t i = 0;
+        if (f.size)
+            for_each_chunk(f.offsets[0], f.counts[0], rows, [&](MPI_Offset k, MPI_Offset begin, MPI_Offset end)
+            {
+                const auto hash = io::xxh64(bytes + (begin - f.offsets[0]) * local_row, (end - begin) * local_row);
+                if (!same_piece || hash != it->second.hashes[i]) dirty[p.first_flag + k] = 1;
+                p.next.hashes.push_back(hash);
+                i++;
+            });
+
+        plans.push_back(std::move(p));
+    }
+
+    // A chunk is rewritten if any process changed its part
+    if (!dirty.empty())
+        MPI_Allreduce(MPI_IN_PLACE, dirty.data(), dirty.size(), MPI_INT, MPI_LOR, _comm);
+
+    for (auto& p : plans)
+        for (MPI_Offset k = 0; k < (MPI_Offset)p.next.generations.size(); k++)
+            if (dirty[p.first_flag + k])
+            {
+                p.chunks.push_back(k);
+                p.next.generations[k] = generation;
+            }
+
+    // The manifest's shape, chunk rows and chunk indices are 64-bit integers, and fields may be too
+    file<io::access::wo> out(path(_base, generation), staging(), file_format::cdf5);
+    if (!out) return { error_code(error_code::NullFile) };
+
+    const auto defined = out.define([&]() -> result<void>
+    {
+        RES_CHECK(out.define_attribute<types::Int>("", "generation", { generation }));
+
+        for (std::size_t i = 0; i < fields.size(); i++)
+        {
+            const auto& f = fields[i];
+            const auto& p = plans[i];
+
+            // The manifest, with what's needed to interpret it
+            RES_CHECK(out.define_dimension(f.name + "_chunk_count", p.next.generations.size()));
+            RES_CHECK(out.define_variable<types::Int>(f.name + "_generation", { f.name + "_chunk_count" }));
+            RES_CHECK(out.define_attribute<types::Int64>(f.name + "_generation", "shape", std::vector<long long>(f.shape.begin(), f.shape.end())));
+            RES_CHECK(out.define_attribute<types::Int64>(f.name + "_generation", "chunk_rows", { (long long)p.next.chunk_rows }));
+
+            // A dimension of length zero would be the record dimension, so fields without changes store no chunks
+            if (p.chunks.empty()) continue;
+
+            std::vector<int> dimensions(f.shape.size() + 1);
+            const auto def_dim = [&](const std::string& name, MPI_Offset length, int* id) { return out.storage().def_dim(out.get_handle(), name.c_str(), length, id); };
+            NET_CHECK(def_dim(f.name + "_chunks", p.chunks.size(), &dimensions[0]));
+            NET_CHECK(def_dim(f.name + "_chunk_rows", p.next.chunk_rows, &dimensions[1]));
+            for (std::size_t d = 1; d < f.shape.size(); d++)
+                NET_CHECK(def_dim(dimension_name(f.name, d), f.shape[d], &dimensions[d + 1]));
+
+            int index;
+            NET_CHECK(out.storage().def_var(out.get_handle(), f.name.c_str(), f.type, dimensions.size(), dimensions.data(), &index));
+            RES_CHECK(out.define_variable<types::Int64>(f.name + "_chunk_index", { f.name + "_chunks" }));
+        }
+        return { };
+    });
+    if (!defined) return { defined.error() };
+
+    const auto collective = end_independent(out.storage(), out.get_handle());
+    if (!collective) return { collective.error() };
+
+    int rank;
+    MPI_Comm_rank(_comm, &rank);
+
+    // The manifest is the same on every process, so every process finds the same variables before anything is posted
+    struct variables { int generation, chunk_index, values; };
+    std::vector<variables> ids(fields.size(), variables{ -1, -1, -1 });
+    for (std::size_t i = 0; i < fields.size(); i++)
+    {
+        const auto& name = fields[i].name;
+        NET_CHECK(out.storage().inq_varid(out.get_handle(), (name + "_generation").c_str(), &ids[i].generation));
+        if (plans[i].chunks.empty()) continue;
+        NET_CHECK(out.storage().inq_varid(out.get_handle(), (name + "_chunk_index").c_str(), &ids[i].chunk_index));
+        NET_CHECK(out.storage().inq_varid(out.get_handle(), name.c_str(), &ids[i].values));
+    }
+
+    // Chunk indices are kept alive until the wait
+    std::vector<std::vector<long long>> indices(fields.size());
+    std::vector<int> requests;
+    std::size_t written = 0, skipped = 0;
+    int posted = NC_NOERR;
+    PIO_TRACE_SCOPE("incremental_checkpoint::write", "", 0);
+    PIO_TRACE_BATCH(spans, "write");
+
+    // A failed post is reported after the wait, which the other processes are already headed for
+    const auto post = [&](int index, const MPI_Offset* start, const MPI_Offset* count, const void* data, MPI_Offset size, MPI_Datatype type, [[maybe_unused]] const std::string& name, [[maybe_unused]] std::size_t bytes)
+    {
+        int request;
+        const auto err = out.storage().iput_vara(out.get_handle(), index, start, count, data, size, type, &request);
+        if (err != NC_NOERR) { posted = err; return; }
+        requests.push_back(request);
+        PIO_TRACE_BATCH_BEGIN(spans, name, bytes);
+    };
+
+    for (std::size_t i = 0; i < fields.size(); i++)
+    {
+        const auto& f = fields[i];
+        const auto& p = plans[i];
+        const auto element = io::nc_sizeof(f.type);
+
+        if (!rank)
+        {
+            const MPI_Offset start = 0, count = p.next.generations.size();
+            post(ids[i].generation, &start, &count, p.next.generations.data(), count, MPI_INT, f.name + "_generation", count * sizeof(int));
+
+            if (!p.chunks.empty())
+            {
+                indices[i].assign(p.chunks.begin(), p.chunks.end());
+                const MPI_Offset chunks = indices[i].size();
+                post(ids[i].chunk_index, &start, &chunks, indices[i].data(), chunks, MPI_LONG_LONG, f.name + "_chunk_index", chunks * sizeof(long long));
+            }
+        }
+
+        if (!f.size) continue;
+
+        const auto* bytes = static_cast<const unsigned char*>(f.values());
+        const auto local_row = row_size(f.counts);
+        for_each_chunk(f.offsets[0], f.counts[0], p.next.chunk_rows, [&](MPI_Offset k, MPI_Offset begin, MPI_Offset end)
+        {
+            const std::size_t size = (end - begin) * local_row;
+            const auto position = std::lower_bound(p.chunks.begin(), p.chunks.end(), k);
+            if (position == p.chunks.end() || *position != k)
+            {
+                skipped += size * element;
+                return;
+            }
+
+            std::vector<MPI_Offset> start = { position - p.chunks.begin(), begin - k * p.next.chunk_rows };
+            std::vector<MPI_Offset> count = { 1, end - begin };
+            start.insert(start.end(), f.offsets.begin() + 1, f.offsets.end());
+            count.insert(count.end(), f.counts.begin() + 1, f.counts.end());
+
+            post(ids[i].values, start.data(), count.data(), bytes + (begin - f.offsets[0]) * local_row * element, size, f.mpi, f.name, size * element);
+            written += size * element;
+            PIO_STATS_WRITE(f.name, size * element);
+        });
+    }
+
+    const auto res = wait_collective(out.storage(), out.get_handle(), requests);
+    PIO_TRACE_BATCH_END(spans);
+    if (!res) return { res.error() };
+    if (posted != NC_NOERR) return { netcdf_error(posted) };
+
+    // Only a complete generation becomes the base for the next one
+    for (std::size_t i = 0; i < fields.size(); i++)
+        _history[fields[i].name] = std::move(plans[i].next);
+    _pending = checkpoint();
+    _written = written;
+    _skipped = skipped;
+    return { _generation++ };
+}
+
+namespace
+{
+
+/// The manifest of a field in some generation
+struct manifest
+{
+    std::vector<MPI_Offset> shape;
+    MPI_Offset chunk_rows;
+    std::vector<int> generations;
+};
+
+result<manifest>
+read_manifest(const file<io::access::ro>& file, const std::string& name)
+{
+    manifest m;
+
+    int index;
+    NET_CHECK(file.storage().inq_varid(file.get_handle(), (name + "_generation").c_str(), &index));
+
+    MPI_Offset rank;
+    NET_CHECK(file.storage().inq_attlen(file.get_handle(), index, "shape", &rank));
+    std::vector<long long> shape(rank);
+    long long chunk_rows;
+    NET_CHECK(file.storage().get_att(file.get_handle(), index, "shape", shape.data()));
+    NET_CHECK(file.storage().get_att(file.get_handle(), index, "chunk_rows", &chunk_rows));
+    m.shape.assign(shape.begin(), shape.end());
+    m.chunk_rows = chunk_rows;
+
+    const MPI_Offset chunks = (m.shape.empty() ? 0 : (m.shape[0] + chunk_rows - 1) / chunk_rows);
+    if (chunks)
+    {
+        auto generations = file.read_variable_sync<types::Int>(name + "_generation", { 0 }, { chunks });
+        if (!generations) return { generations.error() };
+        m.generations = std::move(generations).value();
+    }
+
+    return { std::move(m) };
+}
+
+template<typename _Type>
+result<std::vector<checkpoint_slice<_Type>>>
+read_incremental(MPI_Comm comm, const std::string& base, std::size_t generation, std::unique_ptr<file<io::access::ro>> latest, std::vector<checkpoint_slice<_Type>> slices)
+{
+    // Each process checks only its own slices, so an error is held and shared in the reduction below, and every process returns together
+    std::optional<error_code> failure;
+
+    // The manifests, read from the latest generation
+    std::map<std::string, manifest> manifests;
+    for (auto& slice : slices)
+    {
+        if (!manifests.count(slice.name))
+        {
+            auto m = read_manifest(*latest, slice.name);
+            if (!m) { failure = m.error(); break; }
+            manifests.emplace(slice.name, std::move(m).value());
+        }
+
+        const auto& m = manifests.at(slice.name);
+        if (slice.offsets.size() != m.shape.size() || slice.counts.size() != m.shape.size()) { failure = error_code::DimensionSizeMismatch; break; }
+        for (std::size_t d = 0; d < m.shape.size(); d++)
+            if (slice.offsets[d] < 0 || slice.offsets[d] + slice.counts[d] > m.shape[d]) failure = error_code::IndexOutOfBounds;
+        if (failure) break;
+
+        slice.values.resize(std::accumulate(slice.counts.begin(), slice.counts.end(), std::size_t(1), std::multiplies<std::size_t>()));
+    }
+
+    // Opening a file is collective, so every process opens every generation any of them needs, in order. The last slot
+    // is set if any process failed
+    std::vector<int> needed(generation + 2, 0);
+    for (const auto& slice : slices)
+    {
+        if (failure) break;
+        const auto& m = manifests.at(slice.name);
+        if (slice.values.empty()) continue;
+        for_each_chunk(slice.offsets[0], slice.counts[0], m.chunk_rows, [&](MPI_Offset k, MPI_Offset, MPI_Offset)
+        {
+            if (m.generations[k] < 0 || (std::size_t)m.generations[k] > generation) failure = error_code::VariableDoesntExist;
+            else needed[m.generations[k]] = 1;
+        });
+    }
+    needed.back() = (failure ? 1 : 0);
+    MPI_Allreduce(MPI_IN_PLACE, needed.data(), needed.size(), MPI_INT, MPI_LOR, comm);
+    if (failure) return { *failure };
+    if (needed.back()) return { error_code::OtherProcessFailed };
+
+    std::size_t bytes = 0;
+    for (const auto& slice : slices) bytes += slice.values.size() * sizeof(typename _Type::integral_type);
+    PIO_TRACE_SCOPE("read_incremental_checkpoint", "", bytes);
+
+    for (std::size_t g = 0; g <= generation; g++)
+    {
+        if (!needed[g]) continue;
+
+        std::unique_ptr<file<io::access::ro>> older;
+        if (g != generation) older = std::make_unique<file<io::access::ro>>(incremental_checkpoint::path(base, g));
+        const auto& in = (g == generation ? *latest : *older);
+        if (!in) return { error_code::NullFile };
+
+        // Only the processes reading from this generation look anything up, so an error is held until after the collective wait
+        std::optional<error_code> failure;
+
+        // Where each chunk of this generation is stored in its file, and the variable holding the chunks
+        std::map<std::string, std::pair<std::vector<long long>, int>> stored;
+        for (const auto& slice : slices)
+        {
+            if (failure) break;
+            if (stored.count(slice.name) || slice.values.empty()) continue;
+            const auto& m = manifests.at(slice.name);
+            if (std::find(m.generations.begin(), m.generations.end(), (int)g) == m.generations.end()) continue;
+
+            int variable;
+            nc_type type;
+            auto err = in.storage().inq_varid(in.get_handle(), slice.name.c_str(), &variable);
+            if (err == NC_NOERR) err = in.storage().inq_vartype(in.get_handle(), variable, &type);
+            if (err != NC_NOERR) { failure = netcdf_error(err); break; }
+            if (!io::convertible(type, _Type::nc)) { failure = error_code::TypeMismatch; break; }
+
+            const auto chunks = in.get_dimension(slice.name + "_chunks");
+            if (!chunks) { failure = chunks.error(); break; }
+            auto index = in.read_variable_sync<types::Int64>(slice.name + "_chunk_index", { 0 }, { chunks->length });
+            if (!index) { failure = index.error(); break; }
+            stored.emplace(slice.name, std::pair(std::move(index).value(), variable));
+        }
+
+        const auto collective = end_independent(in.storage(), in.get_handle());
+        if (!collective) return { collective.error() };
+
+        std::vector<int> requests;
+        PIO_TRACE_BATCH(spans, "read");
+        for (auto& slice : slices)
+        {
+            if (failure) break;
+            if (!stored.count(slice.name)) continue;
+            const auto& m = manifests.at(slice.name);
+            const auto& index = stored.at(slice.name).first;
+            const auto variable = stored.at(slice.name).second;
+
+            const auto local_row = row_size(slice.counts);
+            for_each_chunk(slice.offsets[0], slice.counts[0], m.chunk_rows, [&](MPI_Offset k, MPI_Offset begin, MPI_Offset end)
+            {
+                if (m.generations[k] != (int)g || failure) return;
+                const auto position = std::lower_bound(index.begin(), index.end(), (long long)k);
+                if (position == index.end() || *position != k) { failure = error_code::VariableDoesntExist; return; }
+
+                std::vector<MPI_Offset> start = { position - index.begin(), begin - k * m.chunk_rows };
+                std::vector<MPI_Offset> count = { 1, end - begin };
+                start.insert(start.end(), slice.offsets.begin() + 1, slice.offsets.end());
+                count.insert(count.end(), slice.counts.begin() + 1, slice.counts.end());
+
+                const std::size_t size = (end - begin) * local_row;
+                int request;
+                const auto err = in.storage().iget_vara(in.get_handle(), variable, start.data(), count.data(), slice.values.data() + (begin - slice.offsets[0]) * local_row, size, _Type::mpi, &request);
+                if (err != NC_NOERR) { failure = netcdf_error(err); return; }
+
+                requests.push_back(request);
+                PIO_TRACE_BATCH_BEGIN(spans, slice.name, size * sizeof(typename _Type::integral_type));
+                PIO_STATS_READ(slice.name, size * sizeof(typename _Type::integral_type));
+            });
+        }
+
+        // Still wait on what was posted, the other processes are in the same collective
+        const auto res = wait_collective(in.storage(), in.get_handle(), requests);
+        PIO_TRACE_BATCH_END(spans);
+        if (failure) return { *failure };
+        if (!res) return { res.error() };
+    }
+
+    return { std::move(slices) };
+}
+
+}
+
+template<typename _Type>
+result<std::vector<checkpoint_slice<_Type>>>
+read_incremental_checkpoint_slices(MPI_Comm comm, const std::string& base, std::size_t generation, std::vector<checkpoint_slice<_Type>> slices)
+{
+    auto latest = std::make_unique<file<io::access::ro>>(incremental_checkpoint::path(base, generation));
+    if (!*latest) return { error_code::NullFile };
+    return read_incremental<_Type>(comm, base, generation, std::move(latest), std::move(slices));
+}
+template result<std::vector<checkpoint_slice<types::Double>>> read_incremental_checkpoint_slices<types::Double>(MPI_Comm, const std::string&, std::size_t, std::vector<checkpoint_slice<types::Double>>);
+template result<std::vector<checkpoint_slice<types::Float>>> read_incremental_checkpoint_slices<types::Float>(MPI_Comm, const std::string&, std::size_t, std::vector<checkpoint_slice<types::Float>>);
+template result<std::vector<checkpoint_slice<types::Int>>> read_incremental_checkpoint_slices<types::Int>(MPI_Comm, const std::string&, std::size_t, std::vector<checkpoint_slice<types::Int>>);
+template result<std::vector<checkpoint_slice<types::Int64>>> read_incremental_checkpoint_slices<types::Int64>(MPI_Comm, const std::string&, std::size_t, std::vector<checkpoint_slice<types::Int64>>);
+
+template<typename _Type>
+result<std::vector<checkpoint_slice<_Type>>>
+read_incremental_checkpoint(MPI_Comm comm, const std::string& base, std::size_t generation, const std::vector<std::string>& names)
+{
+    auto latest = std::make_unique<file<io::access::ro>>(incremental_checkpoint::path(base, generation));
+    if (!*latest) return { error_code::NullFile };
+
+    io::distributor dist(comm);
+    for (uint32_t i = 0; i < names.size(); i++)
+    {
+        const auto m = read_manifest(*latest, names[i]);
+        if (!m) return { m.error() };
+
+        io::distributor::volume vol;
+        vol.data_index = i;
+        vol.data_type = _Type::nc;
+        vol.dimensions.assign(m->shape.begin(), m->shape.end());
+        dist.data_volumes.push_back(vol);
+    }
+
+    const auto tasks = dist.get_tasks();
+    if (!tasks) return { error_code::FailedTaskCreation };
+
+    std::vector<checkpoint_slice<_Type>> slices;
+    for (const auto& task : *tasks)
+        slices.push_back(checkpoint_slice<_Type>{ names[dist.data_volumes[task.volume_index].data_index], task.offsets, task.counts, { } });
+
+    return read_incremental<_Type>(comm, base, generation, std::move(latest), std::move(slices));
+}
+template result<std::vector<checkpoint_slice<types::Double>>> read_incremental_checkpoint<types::Double>(MPI_Comm, const std::string&, std::size_t, const std::vector<std::string>&);
+template result<std::vector<checkpoint_slice<types::Float>>> read_incremental_checkpoint<types::Float>(MPI_Comm, const std::string&, std::size_t, const std::vector<std::string>&);
+template result<std::vector<checkpoint_slice<types::Int>>> read_incremental_checkpoint<types::Int>(MPI_Comm, const std::string&, std::size_t, const std::vector<std::string>&);
+template result<std::vector<checkpoint_slice<types::Int64>>> read_incremental_checkpoint<types::Int64>(MPI_Comm, const std::string&, std::size_t, const std::vector<std::string>&);
+
+}
@@ -0,0 +1,194 @@
+/**
+ * @file checkpoint.hh
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief Checkpoint and restart of distributed arrays, independent of the process count.
+ *
+ * A checkpoint stores every field as the whole global array, so nothing in the file depends on how it was
+ * decomposed when written. A restart on any number of processes reads the slices it needs directly.
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#pragma once
+
+#include "net_file.hh"
+
+#include <memory>
+
+namespace pio::netcdf
+{
+    /// A field stored in a checkpoint
+    struct checkpoint_variable
+    {
+        std::string name;
+        nc_type type;
+        std::vector<MPI_Offset> shape; /// Shape of the global array
+    };
+
+    /// The slice of a field a process restored
+    template<typename _Type>
+    struct checkpoint_slice
+    {
+        using value_type = typename _Type::integral_type;
+
+        std::string name;
+        std::vector<MPI_Offset> offsets, counts; /// Where the slice sits in the global array
+        std::vector<value_type> values;          /// The slice in row-major order
+
+        /// The values shaped like the slice, indexed with global coordinates through `view::global`
+        util::view<const value_type> view() const { return util::view<const value_type>(values.data(), counts, offsets); }
+    };
+
+    /** \brief Collects the local pieces of distributed arrays and writes them as one checkpoint
+     *
+     * Every process adds its piece of each field together with where the piece sits in the global array,
+     * which is exactly what a \ref util::view describes. \ref write then defines every field and writes all
+     * the pieces with a single collective wait, so PnetCDF can aggregate them into large contiguous writes.
+     * \code {.cpp}
+     * netcdf::checkpoint checkpoint;
+     * checkpoint.add<types::Double>("density", { nx, ny }, util::view<const double>(rho.data(), { my_nx, ny }, { my_x, 0 }));
+     * checkpoint.add<types::Int>("material", { nx, ny }, util::view<const int>(mat.data(), { my_nx, ny }, { my_x, 0 }));
+     *
+     * checkpoint.write("restart.nc"); // created as CDF-5, so 64-bit integer fields fit
+     * \endcode
+     * Restarting, on any number of processes, reads each process' share back:
+     * \code {.cpp}
+     * netcdf::file<io::access::ro> file("restart.nc");
+     * const auto slices = netcdf::read_checkpoint<types::Double>(MPI_COMM_WORLD, file, { "density" });
+     * \endcode
+     * \note every process must add the same fields, in the same order and with the same global shape (a process
+     * without a piece of a field passes a view with a count of zero)
+     * \note the views are only read during \ref write, so the data they point to must outlive that call
+     */
+    struct checkpoint
+    {
+        /// Add this process' piece of a field
+        /// \param shape shape of the global array
+        /// \param local the piece, with its offset in the global array \note it doesn't need to be contiguous
+        template<typename _Type>
+        result<void> add(const std::string& name, const std::vector<MPI_Offset>& shape, const util::view<const typename _Type::integral_type>& local);
+
+        /// Define every field and collectively write every process' pieces
+        /// \note a \ref types::Int64 field needs a file created as \ref file_format::cdf5, a CDF-2 file turns it down
+        result<void> write(file<io::access::wo>& file) const;
+
+        /// Create `filename` as a CDF-5 file and write the checkpoint into it, see \ref write
+        result<void> write(const std::string& filename) const;
+
+        const auto& fields() const { return _fields; }
+
+    private:
+        struct field
+        {
+            std::string name;
+            nc_type type;
+            MPI_Datatype mpi;
+            std::vector<MPI_Offset> shape, offsets, counts;
+            const void* data;                  /// The piece, if it was contiguous (the caller's buffer)
+            std::vector<unsigned char> packed; /// Otherwise a packed copy of it
+            std::size_t size;                  /// Values in the piece
+
+            const void* values() const { return (packed.empty() ? data : packed.data()); }
+        };
+
+        std::vector<field> _fields;
+
+        friend struct incremental_checkpoint;
+    };
+
+    /** \brief A checkpoint that only writes the chunks of each field that changed since the last one
+     *
+     * Each field is cut into chunks of whole rows (along its first dimension) of about `chunk_bytes`. Every
+     * \ref write creates the next generation, `<base>.<generation>.nc`, which holds the chunks that changed and
+     * a manifest naming, for every chunk, the generation that last wrote it. A chunk has changed when the xxHash
+     * of any process' part of it differs from the last write, so unchanged material ids, geometry and slowly
+     * varying fields cost a hash instead of a write.
+     * \code {.cpp}
+     * netcdf::incremental_checkpoint checkpoint(MPI_COMM_WORLD, "restart");
+     * for (...)
+     * {
+     *     checkpoint.add<types::Int>("material", { nx, ny }, material_view);
+     *     checkpoint.add<types::Double>("density", { nx, ny }, density_view);
+     *     checkpoint.write(); // restart.0.nc, restart.1.nc, ...
+     * }
+     * \endcode
+     * \ref read_incremental_checkpoint follows the manifest of a generation back to the files holding each chunk,
+     * so only the latest generation and the files it refers to are needed.
+     * \note the first generation, a field whose shape changed and a process whose piece moved are written in full
+     * \note the hashes live in this object, so it has to be kept from one checkpoint to the next
+     * \note files are opened on `MPI_COMM_WORLD` like every \ref file, so `comm` should be the same
+     * \note generations are created as CDF-5 files, the manifest stores 64-bit integers
+     */
+    struct incremental_checkpoint
+    {
+        incremental_checkpoint(MPI_Comm comm, const std::string& base, std::size_t chunk_bytes = 1 << 20);
+
+        /// Add this process' piece of a field to the next generation, see \ref checkpoint::add
+        template<typename _Type>
+        result<void> add(const std::string& name, const std::vector<MPI_Offset>& shape, const util::view<const typename _Type::integral_type>& local)
+        {
+            return _pending.add<_Type>(name, shape, local);
+        }
+
+        /// Write the chunks that changed as the next generation and forget the added fields \return the generation written
+        result<std::size_t> write();
+
+        /// Number of generations written
+        std::size_t generations() const { return _generation; }
+
+        /// Bytes of its pieces this process wrote, and skipped, in the last \ref write
+        std::size_t written_bytes() const { return _written; }
+        std::size_t skipped_bytes() const { return _skipped; }
+
+        /// Path of the file holding a generation
+        static std::string path(const std::string& base, std::size_t generation);
+
+    private:
+        /// What the last write of a field looked like
+        struct history
+        {
+            nc_type type;
+            MPI_Offset chunk_rows;
+            std::vector<MPI_Offset> shape, offsets, counts; /// `offsets` and `counts` are this process' piece
+            std::vector<uint64_t> hashes;                   /// Of this process' part of each chunk its piece overlaps
+            std::vector<int> generations;                   /// The manifest, the same on every process
+        };
+
+        MPI_Comm _comm;
+        std::string _base;
+        std::size_t _chunk_bytes, _generation = 0, _written = 0, _skipped = 0;
+        checkpoint _pending;
+        std::unordered_map<std::string, history> _history;
+    };
+
+    /// List the fields of a checkpoint
+    result<std::vector<checkpoint_variable>>
+    checkpoint_variables(const file<io::access::ro>& file);
+
+    /// Read the given slices of fields, each process asking for whatever part of the global arrays it needs
+    /// \note collective, every process must call it, even if it asks for nothing
+    template<typename _Type>
+    result<std::vector<checkpoint_slice<_Type>>>
+    read_checkpoint(const file<io::access::ro>& file, std::vector<checkpoint_slice<_Type>> slices);
+
+    /// Read fields, decomposing each of them over `comm` with \ref io::distributor
+    /// \note a process can get several slices of a field, or none at all
+    template<typename _Type>
+    result<std::vector<checkpoint_slice<_Type>>>
+    read_checkpoint(MPI_Comm comm, const file<io::access::ro>& file, const std::vector<std::string>& names);
+
+    /// Read the given slices of fields from a generation of an \ref incremental_checkpoint
+    /// \note collective over `comm`, every process must call it, even if it asks for nothing
+    template<typename _Type>
+    result<std::vector<checkpoint_slice<_Type>>>
+    read_incremental_checkpoint_slices(MPI_Comm comm, const std::string& base, std::size_t generation, std::vector<checkpoint_slice<_Type>> slices);
+
+    /// Read fields from a generation of an \ref incremental_checkpoint, decomposing each of them over `comm` with \ref io::distributor
+    template<typename _Type>
+    result<std::vector<checkpoint_slice<_Type>>>
+    read_incremental_checkpoint(MPI_Comm comm, const std::string& base, std::size_t generation, const std::vector<std::string>& names);
+}
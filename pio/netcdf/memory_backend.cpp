@@ -0,0 +1,680 @@
+#include "memory_backend.hh"
+
+#include <numeric>
+#include <algorithm>
+#include <limits>
+
+namespace pio::netcdf
+{
+
+namespace
+{
+
+/**
+ * @brief Visit each innermost row of a hyperslab of a dense row-major array
+ * @param lengths  The length of each dimension of the dense array
+ * @param element  The byte-size of an element of the array
+ * @param row      Called with the byte position of the row in the array, the index of its first element in the
+ *                 packed hyperslab and its number of elements
+ */
+template<typename _Row>
+void for_each_row(
+    const std::vector<MPI_Offset>& lengths,
+    const MPI_Offset* start,
+    const MPI_Offset* count,
+    std::size_t element,
+    _Row&& row)
+{
+    const auto rank = lengths.size();
+    const std::size_t total = std::accumulate(count, count + rank, std::size_t(1), std::multiplies<std::size_t>());
+    if (!total) return;
+
+    std::vector<std::size_t> strides(rank, element);
+    for (int i = (int)rank - 2; i >= 0; i--)
+        strides[i] = strides[i + 1] * lengths[i + 1];
+
+    const std::size_t length = (rank ? count[rank - 1] : 1);
+    std::vector<MPI_Offset> index(rank ? rank - 1 : 0, 0);
+    for (std::size_t out = 0; out < total; out += length)
+    {
+        std::size_t position = 0;
+        for (uint32_t i = 0; i < rank; i++)
+            position += (start[i] + (i < index.size() ? index[i] : 0)) * strides[i];
+
+        row(position, out, length);
+
+        for (int i = (int)index.size() - 1; i >= 0; i--)
+        {
+            if (++index[i] < count[i]) break;
+            index[i] = 0;
+        }
+    }
+}
+
+/// Byte-size of a value stored as `type`, zero if the type is unknown
+std::size_t type_size(nc_type type)
+{
+    std::size_t size = 0;
+    io::visit_type(type, [&](auto tag) { size = sizeof(tag); });
+    return size;
+}
+
+/// The NetCDF type of the values in a buffer described by an MPI datatype, `stored` for `MPI_DATATYPE_NULL`
+nc_type buffer_type(MPI_Datatype type, nc_type stored)
+{
+    if (type == MPI_DATATYPE_NULL) return stored;
+    if (type == MPI_DOUBLE)        return NC_DOUBLE;
+    if (type == MPI_FLOAT)         return NC_FLOAT;
+    if (type == MPI_INT)           return NC_INT;
+    if (type == MPI_LONG_LONG)     return NC_INT64;
+    if (type == MPI_CHAR)          return NC_CHAR;
+    return NC_NAT;
+}
+
+/// Convert `count` values stored as `from` into values stored as `to`
+void convert(nc_type from, const void* src, nc_type to, void* dst, std::size_t count)
+{
+    io::visit_type(to, [&](auto tag)
+    {
+        io::convert_from(from, src, static_cast<decltype(tag)*>(dst), count);
+    });
+}
+
+/// Whether `count` values stored as `from` can all be stored as `to`, PnetCDF fails a write with `NC_ERANGE` otherwise
+bool fits(nc_type from, const void* src, nc_type to, std::size_t count)
+{
+    bool fits = true;
+    io::visit_type(to, [&](auto to_tag)
+    {
+        using _To = decltype(to_tag);
+        if constexpr (std::is_integral_v<_To> && !std::is_same_v<_To, char>)
+        {
+            io::visit_type(from, [&](auto from_tag)
+            {
+                using _From = decltype(from_tag);
+                if constexpr (!std::is_same_v<_From, char>)
+                {
+                    const auto* values = static_cast<const _From*>(src);
+                    const auto lowest = (long double)std::numeric_limits<_To>::lowest(), highest = (long double)std::numeric_limits<_To>::max();
+                    for (std::size_t i = 0; i < count && fits; i++)
+                        fits = ((long double)values[i] >= lowest && (long double)values[i] <= highest);
+                }
+            });
+        }
+    });
+    return fits;
+}
+
+/// Types a CDF-1 or CDF-2 file can't hold
+bool cdf5_only(nc_type type)
+{
+    return type == NC_UBYTE || type == NC_USHORT || type == NC_UINT || type == NC_INT64 || type == NC_UINT64;
+}
+
+int copy_name(const std::string& from, char* to)
+{
+    if (to) std::memcpy(to, from.c_str(), from.size() + 1);
+    return NC_NOERR;
+}
+
+}
+
+#define FIND(handle) auto* file = _find(handle); if (!file) return NC_EBADID;
+#define FIND_DATA(handle) FIND(handle); auto& data = *file->data;
+#define CHECK_VAR(variable) if (variable < 0 || variable >= (int)data.variables.size()) return NC_ENOTVAR;
+#define FIND_VAR(variable) CHECK_VAR(variable); auto& var = data.variables[variable];
+
+bool memory_backend::exists(const std::string& path) const
+{
+    return _datasets.count(path);
+}
+
+void memory_backend::remove(const std::string& path)
+{
+    _datasets.erase(path);
+}
+
+memory_backend::open_dataset* memory_backend::_find(int handle)
+{
+    const auto it = _open.find(handle);
+    return (it == _open.end() ? nullptr : &it->second);
+}
+
+std::vector<MPI_Offset> memory_backend::_lengths(const dataset& data, const variable_entry& var, MPI_Offset records)
+{
+    std::vector<MPI_Offset> lengths;
+    for (const auto id : var.dimensions)
+    {
+        const auto length = data.dimensions[id].length;
+        lengths.push_back(length == NC_UNLIMITED ? records : length);
+    }
+    return lengths;
+}
+
+int memory_backend::_check(const dataset& data, const variable_entry& var, const MPI_Offset* start, const MPI_Offset* count, bool grow)
+{
+    for (std::size_t i = 0; i < var.dimensions.size(); i++)
+    {
+        const auto length = data.dimensions[var.dimensions[i]].length;
+        const bool record = (length == NC_UNLIMITED);
+        if (start[i] < 0 || (!record && start[i] > length) || (record && !grow && start[i] > data.records)) return NC_EINVALCOORDS;
+        if (count[i] < 0) return NC_EEDGE;
+        if (record ? (!grow && start[i] + count[i] > data.records) : start[i] + count[i] > length) return NC_EEDGE;
+    }
+    return NC_NOERR;
+}
+
+memory_backend::attribute_entry* memory_backend::_attribute(dataset& data, int variable, const char* name)
+{
+    auto& attributes = (variable == NC_GLOBAL ? data.attributes : data.variables[variable].attributes);
+    const auto it = std::find_if(attributes.begin(), attributes.end(), [&](const auto& a) { return a.name == name; });
+    return (it == attributes.end() ? nullptr : &*it);
+}
+
+#pragma region DATASETS
+
+int memory_backend::create(MPI_Comm, const char* path, int mode, MPI_Info, int* handle)
+{
+    if ((mode & NC_NOCLOBBER) && exists(path)) return NC_EEXIST;
+
+    auto data = std::make_shared<dataset>();
+    data->cdf5 = (mode & NC_64BIT_DATA);
+    _datasets[path] = data;
+
+    *handle = _next_handle++;
+    _open.insert(std::pair(*handle, open_dataset{ std::move(data), true, true, false, { }, 0 }));
+    return NC_NOERR;
+}
+
+int memory_backend::open(MPI_Comm, const char* path, int mode, MPI_Info, int* handle)
+{
+    const auto it = _datasets.find(path);
+    if (it == _datasets.end()) return NC_ENOENT;
+
+    *handle = _next_handle++;
+    _open.insert(std::pair(*handle, open_dataset{ it->second, (bool)(mode & NC_WRITE), false, false, { }, 0 }));
+    return NC_NOERR;
+}
+
+int memory_backend::close(int handle)
+{
+    return (_open.erase(handle) ? NC_NOERR : NC_EBADID);
+}
+
+int memory_backend::flush(int handle)
+{
+    return (_find(handle) ? NC_NOERR : NC_EBADID);
+}
+
+int memory_backend::redef(int handle)
+{
+    FIND(handle);
+    if (!file->writable) return NC_EPERM;
+    if (file->define) return NC_EINDEFINE;
+    file->define = true;
+    file->independent = false;
+    return NC_NOERR;
+}
+
+int memory_backend::enddef(int handle)
+{
+    FIND(handle);
+    if (!file->define) return NC_ENOTINDEFINE;
+    file->define = false;
+    return NC_NOERR;
+}
+
+int memory_backend::begin_indep_data(int handle)
+{
+    FIND(handle);
+    if (file->define) return NC_EINDEFINE;
+    file->independent = true;
+    return NC_NOERR;
+}
+
+int memory_backend::end_indep_data(int handle)
+{
+    FIND(handle);
+    if (!file->independent) return NC_ENOTINDEP;
+    file->independent = false;
+    return NC_NOERR;
+}
+
+#pragma endregion DATASETS
+
+#pragma region INQUIRE
+
+int memory_backend::inq(int handle, int* dimensions, int* variables, int* attributes, int* unlimited)
+{
+    FIND_DATA(handle);
+    if (dimensions) *dimensions = data.dimensions.size();
+    if (variables)  *variables  = data.variables.size();
+    if (attributes) *attributes = data.attributes.size();
+    return (unlimited ? inq_unlimdim(handle, unlimited) : NC_NOERR);
+}
+
+int memory_backend::inq_unlimdim(int handle, int* unlimited)
+{
+    FIND_DATA(handle);
+    const auto it = std::find_if(data.dimensions.begin(), data.dimensions.end(), [](const auto& d) { return d.length == NC_UNLIMITED; });
+    *unlimited = (it == data.dimensions.end() ? -1 : (int)(it - data.dimensions.begin()));
+    return NC_NOERR;
+}
+
+int memory_backend::inq_dim(int handle, int dimension, char* name, MPI_Offset* length)
+{
+    FIND_DATA(handle);
+    if (dimension < 0 || dimension >= (int)data.dimensions.size()) return NC_EBADDIM;
+
+    const auto& dim = data.dimensions[dimension];
+    if (length) *length = (dim.length == NC_UNLIMITED ? data.records : dim.length);
+    return copy_name(dim.name, name);
+}
+
+int memory_backend::inq_dimid(int handle, const char* name, int* dimension)
+{
+    FIND_DATA(handle);
+    const auto it = std::find_if(data.dimensions.begin(), data.dimensions.end(), [&](const auto& d) { return d.name == name; });
+    if (it == data.dimensions.end()) return NC_EBADDIM;
+    *dimension = it - data.dimensions.begin();
+    return NC_NOERR;
+}
+
+int memory_backend::inq_dimlen(int handle, int dimension, MPI_Offset* length)
+{
+    return inq_dim(handle, dimension, nullptr, length);
+}
+
+int memory_backend::inq_var(int handle, int variable, char* name, nc_type* type, int* dimensions, int* dimension_ids, int* attributes)
+{
+    FIND_DATA(handle);
+    FIND_VAR(variable);
+    if (type)          *type = var.type;
+    if (dimensions)    *dimensions = var.dimensions.size();
+    if (dimension_ids) std::copy(var.dimensions.begin(), var.dimensions.end(), dimension_ids);
+    if (attributes)    *attributes = var.attributes.size();
+    return copy_name(var.name, name);
+}
+
+int memory_backend::inq_varid(int handle, const char* name, int* variable)
+{
+    FIND_DATA(handle);
+    const auto it = std::find_if(data.variables.begin(), data.variables.end(), [&](const auto& v) { return v.name == name; });
+    if (it == data.variables.end()) return NC_ENOTVAR;
+    *variable = it - data.variables.begin();
+    return NC_NOERR;
+}
+
+int memory_backend::inq_varname(int handle, int variable, char* name)
+{
+    return inq_var(handle, variable, name, nullptr, nullptr, nullptr, nullptr);
+}
+
+int memory_backend::inq_vartype(int handle, int variable, nc_type* type)
+{
+    return inq_var(handle, variable, nullptr, type, nullptr, nullptr, nullptr);
+}
+
+int memory_backend::inq_varndims(int handle, int variable, int* dimensions)
+{
+    return inq_var(handle, variable, nullptr, nullptr, dimensions, nullptr, nullptr);
+}
+
+int memory_backend::inq_vardimid(int handle, int variable, int* dimension_ids)
+{
+    return inq_var(handle, variable, nullptr, nullptr, nullptr, dimension_ids, nullptr);
+}
+
+int memory_backend::inq_att(int handle, int variable, const char* name, nc_type* type, MPI_Offset* length)
+{
+    FIND_DATA(handle);
+    if (variable != NC_GLOBAL) CHECK_VAR(variable);
+
+    const auto* att = _attribute(data, variable, name);
+    if (!att) return NC_ENOTATT;
+    if (type)   *type = att->type;
+    if (length) *length = att->length;
+    return NC_NOERR;
+}
+
+int memory_backend::inq_attlen(int handle, int variable, const char* name, MPI_Offset* length)
+{
+    return inq_att(handle, variable, name, nullptr, length);
+}
+
+int memory_backend::get_att(int handle, int variable, const char* name, void* values)
+{
+    FIND_DATA(handle);
+    if (variable != NC_GLOBAL) CHECK_VAR(variable);
+
+    const auto* att = _attribute(data, variable, name);
+    if (!att) return NC_ENOTATT;
+    std::memcpy(values, att->bytes.data(), att->bytes.size());
+    return NC_NOERR;
+}
+
+int memory_backend::get_att_text(int handle, int variable, const char* name, char* text)
+{
+    nc_type type;
+    if (const auto err = inq_att(handle, variable, name, &type, nullptr); err != NC_NOERR) return err;
+    if (type != NC_CHAR) return NC_ECHAR;
+    return get_att(handle, variable, name, text);
+}
+
+#pragma endregion INQUIRE
+
+#pragma region DEFINE
+
+int memory_backend::def_dim(int handle, const char* name, MPI_Offset length, int* dimension)
+{
+    FIND_DATA(handle);
+    if (!file->writable) return NC_EPERM;
+    if (!file->define) return NC_ENOTINDEFINE;
+    if (length < 0) return NC_EINVAL;
+
+    const auto& dims = data.dimensions;
+    if (std::any_of(dims.begin(), dims.end(), [&](const auto& d) { return d.name == name; })) return NC_ENAMEINUSE;
+    if (length == NC_UNLIMITED && std::any_of(dims.begin(), dims.end(), [](const auto& d) { return d.length == NC_UNLIMITED; }))
+        return NC_EUNLIMIT;
+
+    *dimension = dims.size();
+    data.dimensions.push_back(dimension_entry{ name, length });
+    return NC_NOERR;
+}
+
+int memory_backend::def_var(int handle, const char* name, nc_type type, int dimensions, const int* dimension_ids, int* variable)
+{
+    FIND_DATA(handle);
+    if (!file->writable) return NC_EPERM;
+    if (!file->define) return NC_ENOTINDEFINE;
+    if (!type_size(type)) return NC_EBADTYPE;
+    if (cdf5_only(type) && !data.cdf5) return NC_ESTRICTCDF2;
+
+    const auto& vars = data.variables;
+    if (std::any_of(vars.begin(), vars.end(), [&](const auto& v) { return v.name == name; })) return NC_ENAMEINUSE;
+
+    variable_entry var;
+    var.name = name;
+    var.type = type;
+    for (int i = 0; i < dimensions; i++)
+    {
+        const auto id = dimension_ids[i];
+        if (id < 0 || id >= (int)data.dimensions.size()) return NC_EBADDIM;
+        if (data.dimensions[id].length == NC_UNLIMITED && i) return NC_EUNLIMPOS;
+        var.dimensions.push_back(id);
+    }
+
+    *variable = vars.size();
+    data.variables.push_back(std::move(var));
+    return NC_NOERR;
+}
+
+int memory_backend::put_att(int handle, int variable, const char* name, nc_type type, MPI_Offset length, const void* values)
+{
+    FIND_DATA(handle);
+    if (!file->writable) return NC_EPERM;
+    if (!file->define) return NC_ENOTINDEFINE;
+    if (variable != NC_GLOBAL) CHECK_VAR(variable);
+    if (!type_size(type)) return NC_EBADTYPE;
+    if (cdf5_only(type) && !data.cdf5) return NC_ESTRICTCDF2;
+    if (length < 0) return NC_EINVAL;
+
+    const auto* bytes = static_cast<const unsigned char*>(values);
+    attribute_entry att{ name, type, length, std::vector<unsigned char>(bytes, bytes + length * type_size(type)) };
+    if (auto* existing = _attribute(data, variable, name)) *existing = std::move(att);
+    else (variable == NC_GLOBAL ? data.attributes : data.variables[variable].attributes).push_back(std::move(att));
+    return NC_NOERR;
+}
+
+int memory_backend::put_att_text(int handle, int variable, const char* name, MPI_Offset length, const char* text)
+{
+    return put_att(handle, variable, name, NC_CHAR, length, text);
+}
+
+#pragma endregion DEFINE
+
+#pragma region DATA
+
+int memory_backend::iget_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, void* buffer, MPI_Offset size, MPI_Datatype type, int* request)
+{
+    MPI_Offset* const starts[] = { const_cast<MPI_Offset*>(start) };
+    MPI_Offset* const counts[] = { const_cast<MPI_Offset*>(count) };
+    return iget_varn(handle, variable, 1, starts, counts, buffer, size, type, request);
+}
+
+int memory_backend::iget_varn(int handle, int variable, int runs, MPI_Offset* const* starts, MPI_Offset* const* counts, void* buffer, MPI_Offset size, MPI_Datatype type, int* request)
+{
+    FIND_DATA(handle);
+    if (file->define) return NC_EINDEFINE;
+    FIND_VAR(variable);
+
+    const auto memory = buffer_type(type, var.type);
+    if (memory == NC_NAT) return NC_EBADTYPE;
+    if (!io::convertible(var.type, memory)) return NC_ECHAR;
+
+    // Everything is checked when the request is posted, like PnetCDF does
+    std::size_t total = 0;
+    std::vector<std::pair<std::vector<MPI_Offset>, std::vector<MPI_Offset>>> sections;
+    for (int r = 0; r < runs; r++)
+    {
+        if (const auto err = _check(data, var, starts[r], counts[r], false); err != NC_NOERR) return err;
+        sections.emplace_back(std::vector<MPI_Offset>(starts[r], starts[r] + var.dimensions.size()), std::vector<MPI_Offset>(counts[r], counts[r] + var.dimensions.size()));
+        total += std::accumulate(counts[r], counts[r] + var.dimensions.size(), std::size_t(1), std::multiplies<std::size_t>());
+    }
+    if (type != MPI_DATATYPE_NULL && (std::size_t)size != total) return NC_EIOMISMATCH;
+
+    *request = file->next_request++;
+    file->requests.insert(std::pair(*request, [data = file->data, variable, memory, buffer, sections = std::move(sections)]()
+    {
+        const auto& var = data->variables[variable];
+        const auto element = type_size(var.type), out_element = type_size(memory);
+        const auto lengths = _lengths(*data, var, data->records);
+
+        auto* out = static_cast<unsigned char*>(buffer);
+        for (const auto& [start, count] : sections)
+        {
+            for_each_row(lengths, start.data(), count.data(), element, [&](std::size_t position, std::size_t index, std::size_t n)
+            {
+                // Regions that were never written read as zeros
+                const std::size_t available = (position < var.bytes.size() ? (var.bytes.size() - position) / element : 0);
+                const auto copied = std::min(n, available);
+                if (copied) convert(var.type, var.bytes.data() + position, memory, out + index * out_element, copied);
+                std::memset(out + (index + copied) * out_element, 0, (n - copied) * out_element);
+            });
+            out += std::accumulate(count.begin(), count.end(), std::size_t(1), std::multiplies<std::size_t>()) * out_element;
+        }
+        return NC_NOERR;
+    }));
+    return NC_NOERR;
+}
+
+int memory_backend::iput_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, const void* buffer, MPI_Offset size, MPI_Datatype type, int* request)
+{
+    FIND_DATA(handle);
+    if (!file->writable) return NC_EPERM;
+    if (file->define) return NC_EINDEFINE;
+    FIND_VAR(variable);
+
+    const auto memory = buffer_type(type, var.type);
+    if (memory == NC_NAT) return NC_EBADTYPE;
+    if (!io::convertible(memory, var.type)) return NC_ECHAR;
+    if (const auto err = _check(data, var, start, count, true); err != NC_NOERR) return err;
+
+    const auto rank = var.dimensions.size();
+    const std::size_t total = std::accumulate(count, count + rank, std::size_t(1), std::multiplies<std::size_t>());
+    if (type != MPI_DATATYPE_NULL && (std::size_t)size != total) return NC_EIOMISMATCH;
+
+    // Only a request that has been checked may grow the record dimension, and only once it is carried out
+    *request = file->next_request++;
+    file->requests.insert(std::pair(*request, [data = file->data, variable, memory, buffer,
+        start = std::vector<MPI_Offset>(start, start + rank), count = std::vector<MPI_Offset>(count, count + rank)]()
+    {
+        auto& var = data->variables[variable];
+        const std::size_t total = std::accumulate(count.begin(), count.end(), std::size_t(1), std::multiplies<std::size_t>());
+        if (!fits(memory, buffer, var.type, total)) return NC_ERANGE;
+
+        const bool record = (!var.dimensions.empty() && data->dimensions[var.dimensions[0]].length == NC_UNLIMITED);
+        const auto records = (record ? std::max(data->records, start[0] + count[0]) : data->records);
+
+        const auto element = type_size(var.type), in_element = type_size(memory);
+        const auto lengths = _lengths(*data, var, records);
+        const std::size_t needed = std::accumulate(lengths.begin(), lengths.end(), element, std::multiplies<std::size_t>());
+        if (var.bytes.size() < needed) var.bytes.resize(needed, 0);
+        data->records = records;
+
+        const auto* in = static_cast<const unsigned char*>(buffer);
+        for_each_row(lengths, start.data(), count.data(), element, [&](std::size_t position, std::size_t index, std::size_t n)
+        {
+            convert(memory, in + index * in_element, var.type, var.bytes.data() + position, n);
+        });
+        var.written.emplace_back(start, count);
+        return NC_NOERR;
+    }));
+    return NC_NOERR;
+}
+
+int memory_backend::cancel(int handle, int count, int* requests, int* statuses)
+{
+    FIND(handle);
+    for (int i = 0; i < count; i++)
+    {
+        const bool known = (requests[i] == NC_REQ_NULL || file->requests.erase(requests[i]));
+        if (statuses) statuses[i] = (known ? NC_NOERR : NC_EINVAL_REQUEST);
+        requests[i] = NC_REQ_NULL;
+    }
+    return NC_NOERR;
+}
+
+int memory_backend::_complete(int handle, int count, int* requests, int* statuses, bool collective)
+{
+    FIND(handle);
+    if (file->define) return NC_EINDEFINE;
+    if (collective && file->independent) return NC_EINDEP;
+    if (!collective && !file->independent) return NC_ENOTINDEP;
+
+    for (int i = 0; i < count; i++)
+    {
+        int status = NC_NOERR;
+        if (requests[i] != NC_REQ_NULL)
+        {
+            const auto it = file->requests.find(requests[i]);
+            if (it == file->requests.end()) status = NC_EINVAL_REQUEST;
+            else
+            {
+                status = it->second();
+                file->requests.erase(it);
+            }
+        }
+
+        if (statuses) statuses[i] = status;
+        requests[i] = NC_REQ_NULL;
+    }
+    return NC_NOERR;
+}
+
+int memory_backend::wait(int handle, int count, int* requests, int* statuses)
+{
+    return _complete(handle, count, requests, statuses, false);
+}
+
+int memory_backend::wait_all(int handle, int count, int* requests, int* statuses)
+{
+    return _complete(handle, count, requests, statuses, true);
+}
+
+#pragma endregion DATA
+
+result<void>
+memory_backend::flush(const std::string& path, const std::string& filename, MPI_Comm comm) const
+{
+    const auto it = _datasets.find(path);
+    if (it == _datasets.end()) return { netcdf_error(NC_ENOENT) };
+    const auto& data = *it->second;
+
+    auto& out = io::pnetcdf_backend::instance();
+    int handle;
+    if (const auto err = out.create(comm, filename.c_str(), NC_CLOBBER | (data.cdf5 ? NC_64BIT_DATA : NC_64BIT_OFFSET), MPI_INFO_NULL, &handle); err != NC_NOERR)
+        return { netcdf_error(err) };
+
+    // The schema is the same on every process, so defining it fails everywhere or nowhere
+    const auto define = [&]() -> int
+    {
+        const auto put_attributes = [&](int variable, const std::vector<attribute_entry>& attributes)
+        {
+            for (const auto& att : attributes)
+                if (const auto err = out.put_att(handle, variable, att.name.c_str(), att.type, att.length, att.bytes.data()); err != NC_NOERR) return err;
+            return NC_NOERR;
+        };
+
+        std::vector<int> dimension_ids;
+        for (const auto& dim : data.dimensions)
+        {
+            int id;
+            if (const auto err = out.def_dim(handle, dim.name.c_str(), dim.length, &id); err != NC_NOERR) return err;
+            dimension_ids.push_back(id);
+        }
+
+        for (const auto& var : data.variables)
+        {
+            std::vector<int> dims;
+            for (const auto d : var.dimensions) dims.push_back(dimension_ids[d]);
+
+            int id;
+            if (const auto err = out.def_var(handle, var.name.c_str(), var.type, dims.size(), dims.data(), &id); err != NC_NOERR) return err;
+            if (const auto err = put_attributes(id, var.attributes); err != NC_NOERR) return err;
+        }
+
+        if (const auto err = put_attributes(NC_GLOBAL, data.attributes); err != NC_NOERR) return err;
+        return out.enddef(handle);
+    };
+
+    if (const auto err = define(); err != NC_NOERR)
+    {
+        out.close(handle);
+        return { netcdf_error(err) };
+    }
+
+    // Pack every written region and post it. A process that fails to post still joins the collective wait, or
+    // every other process would block in it
+    int error = NC_NOERR;
+    std::vector<std::vector<unsigned char>> buffers;
+    std::vector<int> requests;
+    for (uint32_t v = 0; v < data.variables.size(); v++)
+    {
+        const auto& var = data.variables[v];
+        const auto element = type_size(var.type);
+        const auto lengths = _lengths(data, var, data.records);
+
+        for (const auto& [start, count] : var.written)
+        {
+            const std::size_t cells = std::accumulate(count.begin(), count.end(), std::size_t(1), std::multiplies<std::size_t>());
+            buffers.emplace_back(cells * element);
+            auto* buffer = buffers.back().data();
+            for_each_row(lengths, start.data(), count.data(), element, [&](std::size_t position, std::size_t index, std::size_t n)
+            {
+                std::memcpy(buffer + index * element, var.bytes.data() + position, n * element);
+            });
+
+            int request;
+            const auto err = out.iput_vara(handle, v, start.data(), count.data(), buffer, cells, MPI_DATATYPE_NULL, &request);
+            if (err != NC_NOERR) { if (error == NC_NOERR) error = err; continue; }
+            requests.push_back(request);
+        }
+    }
+
+    std::vector<int> statuses(requests.size());
+    if (const auto err = out.wait_all(handle, requests.size(), requests.data(), statuses.data()); err != NC_NOERR && error == NC_NOERR) error = err;
+    for (const auto status : statuses)
+        if (status != NC_NOERR && error == NC_NOERR) error = status;
+
+    if (const auto err = out.close(handle); err != NC_NOERR && error == NC_NOERR) error = err;
+    if (error != NC_NOERR) return { netcdf_error(error) };
+    return { };
+}
+
+#undef FIND_VAR
+#undef CHECK_VAR
+#undef FIND_DATA
+#undef FIND
+
+}
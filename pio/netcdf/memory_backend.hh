@@ -0,0 +1,159 @@
+/**
+ * @file memory_backend.hh
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief A storage backend that keeps NetCDF datasets in memory.
+ *
+ * A \ref pio::netcdf::file opened on it runs exactly the code it would on disk, so tests, benchmarks of the
+ * library's own overhead and in-situ coupling don't pay for a file system. Datasets can be flushed into real
+ * files on demand.
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#pragma once
+
+#include "net_file.hh"
+
+#include <memory>
+
+namespace pio::netcdf
+{
+    /** \brief Diskless datasets behind a \ref file
+     *
+     * Every call a file makes (defining, inquiring, posting requests, waiting) goes to memory instead of
+     * PnetCDF, so promises, metadata lookups, the exodus helpers and checkpoints all work unchanged. PnetCDF's
+     * rules are enforced with its error codes: define mode, independent and collective data mode, the types a
+     * CDF-2 file can hold, values that don't fit the type they are stored as and the record dimension.
+     * \code {.cpp}
+     * netcdf::memory_backend memory;
+     * {
+     *     netcdf::file<io::access::wo> file(memory, "out.nc");
+     *     file.define(...);
+     *     file.write_variable<types::Double>("coordx", x.data(), x.size(), { 0 }, { n }).wait();
+     * }
+     * netcdf::file<io::access::ro> file(memory, "out.nc"); // reads back what was written
+     * memory.flush("out.nc", "/scratch/out.nc");            // and copies it into a real file
+     * \endcode
+     * \note Every process has its own datasets, collective calls don't communicate and a process only sees what
+     * it wrote itself. A dataset outlives the files that used it, until it is removed or the backend is destroyed.
+     * \note Like PnetCDF, a request is carried out when it is waited on, so its buffer must stay alive until then
+     */
+    struct memory_backend : io::backend
+    {
+        memory_backend() = default;
+        memory_backend(const memory_backend&) = delete;
+
+        /// Whether a dataset exists
+        bool exists(const std::string& path) const;
+
+        /// Forget a dataset \note files that have it open keep using it until they are closed
+        void remove(const std::string& path);
+
+        /// \brief Write a dataset into a real file through PnetCDF
+        /// \note Collective over `comm`, every process must have defined the same dimensions, variables and
+        /// attributes. Each process writes back only the regions it wrote.
+        result<void> flush(const std::string& path, const std::string& filename, MPI_Comm comm = MPI_COMM_WORLD) const;
+
+        int create(MPI_Comm comm, const char* path, int mode, MPI_Info info, int* handle) override;
+        int open(MPI_Comm comm, const char* path, int mode, MPI_Info info, int* handle) override;
+        int close(int handle) override;
+        int flush(int handle) override;
+
+        int redef(int handle) override;
+        int enddef(int handle) override;
+        int begin_indep_data(int handle) override;
+        int end_indep_data(int handle) override;
+
+        int inq(int handle, int* dimensions, int* variables, int* attributes, int* unlimited) override;
+        int inq_unlimdim(int handle, int* unlimited) override;
+        int inq_dim(int handle, int dimension, char* name, MPI_Offset* length) override;
+        int inq_dimid(int handle, const char* name, int* dimension) override;
+        int inq_dimlen(int handle, int dimension, MPI_Offset* length) override;
+        int inq_var(int handle, int variable, char* name, nc_type* type, int* dimensions, int* dimension_ids, int* attributes) override;
+        int inq_varid(int handle, const char* name, int* variable) override;
+        int inq_varname(int handle, int variable, char* name) override;
+        int inq_vartype(int handle, int variable, nc_type* type) override;
+        int inq_varndims(int handle, int variable, int* dimensions) override;
+        int inq_vardimid(int handle, int variable, int* dimension_ids) override;
+        int inq_att(int handle, int variable, const char* name, nc_type* type, MPI_Offset* length) override;
+        int inq_attlen(int handle, int variable, const char* name, MPI_Offset* length) override;
+        int get_att(int handle, int variable, const char* name, void* values) override;
+        int get_att_text(int handle, int variable, const char* name, char* text) override;
+
+        int def_dim(int handle, const char* name, MPI_Offset length, int* dimension) override;
+        int def_var(int handle, const char* name, nc_type type, int dimensions, const int* dimension_ids, int* variable) override;
+        int put_att(int handle, int variable, const char* name, nc_type type, MPI_Offset length, const void* values) override;
+        int put_att_text(int handle, int variable, const char* name, MPI_Offset length, const char* text) override;
+
+        int iget_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, void* buffer, MPI_Offset size, MPI_Datatype type, int* request) override;
+        int iget_varn(int handle, int variable, int runs, MPI_Offset* const* starts, MPI_Offset* const* counts, void* buffer, MPI_Offset size, MPI_Datatype type, int* request) override;
+        int iput_vara(int handle, int variable, const MPI_Offset* start, const MPI_Offset* count, const void* buffer, MPI_Offset size, MPI_Datatype type, int* request) override;
+        int cancel(int handle, int count, int* requests, int* statuses) override;
+        int wait(int handle, int count, int* requests, int* statuses) override;
+        int wait_all(int handle, int count, int* requests, int* statuses) override;
+
+    private:
+        struct attribute_entry
+        {
+            std::string name;
+            nc_type type;
+            MPI_Offset length;
+            std::vector<unsigned char> bytes;
+        };
+
+        struct dimension_entry
+        {
+            std::string name;
+            MPI_Offset length; /// `NC_UNLIMITED` for the record dimension
+        };
+
+        struct variable_entry
+        {
+            std::string name;
+            nc_type type;
+            std::vector<int> dimensions;
+            std::vector<attribute_entry> attributes;
+            std::vector<unsigned char> bytes; /// Row-major, grows with the records of a record variable
+            std::vector<std::pair<std::vector<MPI_Offset>, std::vector<MPI_Offset>>> written; /// Every region written, for \ref flush
+        };
+
+        struct dataset
+        {
+            bool cdf5;
+            std::vector<dimension_entry> dimensions;
+            std::vector<variable_entry> variables;
+            std::vector<attribute_entry> attributes;
+            MPI_Offset records = 0;
+        };
+
+        /// A dataset as one file sees it
+        struct open_dataset
+        {
+            std::shared_ptr<dataset> data;
+            bool writable, define, independent;
+            std::unordered_map<int, std::function<int()>> requests; /// Posted requests, carried out when waited on
+            int next_request = 0;
+        };
+
+        /// The open dataset behind a handle, null if there is none
+        open_dataset* _find(int handle);
+
+        /// Check that a section lies inside a variable \param grow whether it may extend the record dimension
+        static int _check(const dataset& data, const variable_entry& var, const MPI_Offset* start, const MPI_Offset* count, bool grow);
+
+        /// The lengths of a variable's dimensions, the record dimension counting `records` records
+        static std::vector<MPI_Offset> _lengths(const dataset& data, const variable_entry& var, MPI_Offset records);
+
+        static attribute_entry* _attribute(dataset& data, int variable, const char* name);
+
+        int _complete(int handle, int count, int* requests, int* statuses, bool collective);
+
+        std::unordered_map<std::string, std::shared_ptr<dataset>> _datasets;
+        std::unordered_map<int, open_dataset> _open;
+        int _next_handle = 0;
+    };
+}
@@ -0,0 +1,412 @@
+#include "mmap_file.hh"
+
+#include <numeric>
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace pio::netcdf
+{
+
+namespace
+{
+
+/// Header tags from the CDF specification
+constexpr uint32_t NC_DIMENSION_TAG = 0x0A;
+constexpr uint32_t NC_VARIABLE_TAG  = 0x0B;
+constexpr uint32_t NC_ATTRIBUTE_TAG = 0x0C;
+constexpr uint32_t STREAMING        = 0xFFFFFFFF;
+
+std::size_t external_size(nc_type type)
+{
+    switch (type)
+    {
+    case NC_BYTE: case NC_CHAR: case NC_UBYTE: return 1;
+    case NC_SHORT: case NC_USHORT:             return 2;
+    case NC_INT: case NC_UINT: case NC_FLOAT:  return 4;
+    case NC_DOUBLE: case NC_INT64: case NC_UINT64: return 8;
+    default: return 0;
+    }
+}
+
+/// Sequential big-endian reader over the header bytes
+struct header_reader
+{
+    const unsigned char* ptr;
+    const unsigned char* end;
+    int version;
+    bool good = true;
+
+    bool has(std::size_t bytes)
+    {
+        if (static_cast<std::size_t>(end - ptr) < bytes) good = false;
+        return good;
+    }
+
+    uint32_t u32()
+    {
+        if (!has(4)) return 0;
+        const auto v = io::load_big_endian<uint32_t>(ptr);
+        ptr += 4;
+        return v;
+    }
+
+    uint64_t u64()
+    {
+        if (!has(8)) return 0;
+        const auto v = io::load_big_endian<uint64_t>(ptr);
+        ptr += 8;
+        return v;
+    }
+
+    /// Element counts, dimension lengths and ids are 64-bit in CDF-5
+    uint64_t count() { return (version == 5 ? u64() : u32()); }
+
+    /// Variable offsets are 64-bit in everything but CDF-1
+    uint64_t offset() { return (version == 1 ? u32() : u64()); }
+
+    void skip(std::size_t bytes)
+    {
+        const auto padded = (bytes + 3) & ~std::size_t(3);
+        if (has(padded)) ptr += padded;
+    }
+
+    std::string name()
+    {
+        const auto length = count();
+        if (!has(length)) return "";
+        std::string s(reinterpret_cast<const char*>(ptr), length);
+        skip(length);
+        return s;
+    }
+
+    /// Reads a list header, returns the amount of elements (zero if the list is absent)
+    uint64_t list(uint32_t tag)
+    {
+        const auto t = u32();
+        const auto n = count();
+        if (t != tag && (t || n)) good = false;
+        return n;
+    }
+
+    /// Skips an attribute list, returns the amount of attributes
+    uint64_t attributes()
+    {
+        const auto n = list(NC_ATTRIBUTE_TAG);
+        for (uint64_t i = 0; i < n && good; i++)
+        {
+            name();
+            const auto type = static_cast<nc_type>(u32());
+            const auto values = count();
+            skip(values * external_size(type));
+        }
+        return n;
+    }
+};
+
+}
+
+mapped_file::mapped_file(const std::string& filename) :
+    _data(nullptr),
+    _size(0),
+    _fd(-1),
+    _good(false),
+    _error(error_code::NullFile),
+    _records(0),
+    _record_size(0),
+    _attributes(0)
+{
+    _fd = ::open(filename.c_str(), O_RDONLY);
+    if (_fd < 0) return;
+
+    struct stat st;
+    if (fstat(_fd, &st) != 0 || !st.st_size) { close(); return; }
+    _size = st.st_size;
+
+    void* ptr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (ptr == MAP_FAILED) { close(); return; }
+    _data = static_cast<const unsigned char*>(ptr);
+
+    if (!_parse())
+    {
+        _error = error_code::UnsupportedFormat;
+        close();
+        return;
+    }
+
+    _good = true;
+}
+
+mapped_file::~mapped_file()
+{ close(); }
+
+void mapped_file::close()
+{
+    if (_data) munmap(const_cast<unsigned char*>(_data), _size);
+    if (_fd >= 0) ::close(_fd);
+    _data = nullptr;
+    _fd = -1;
+    _good = false;
+}
+
+bool mapped_file::_parse()
+{
+    header_reader reader{ _data, _data + _size, 0 };
+    if (!reader.has(4) || std::memcmp(_data, "CDF", 3)) return false;
+    reader.version = _data[3];
+    reader.ptr += 4;
+    if (reader.version != 1 && reader.version != 2 && reader.version != 5) return false;
+
+    const auto records = reader.count();
+    if (records == STREAMING) return false;
+    _records = records;
+
+    const auto dim_count = reader.list(NC_DIMENSION_TAG);
+    for (uint64_t i = 0; i < dim_count && reader.good; i++)
+    {
+        dimension dim;
+        dim.id = i;
+        dim.name = reader.name();
+        dim.length = reader.count();
+        _dimensions.push_back(std::move(dim));
+    }
+
+    _attributes = reader.attributes();
+
+    const auto var_count = reader.list(NC_VARIABLE_TAG);
+    for (uint64_t i = 0; i < var_count && reader.good; i++)
+    {
+        entry var;
+        var.name = reader.name();
+        var.info.index = i;
+
+        const auto dims = reader.count();
+        for (uint64_t d = 0; d < dims && reader.good; d++)
+        {
+            const auto id = reader.count();
+            if (id >= _dimensions.size()) return false;
+            var.info.dimensions.push_back(_dimensions[id]);
+        }
+
+        var.info.attributes = reader.attributes();
+        var.info.type  = reader.u32();
+        var.size       = reader.count();
+        var.begin      = reader.offset();
+        var.record     = (!var.info.dimensions.empty() && var.info.dimensions[0].length == 0);
+        if (!external_size(var.info.type)) return false;
+
+        _variable_ids.insert(std::pair(var.name, _variables.size()));
+        _variables.push_back(std::move(var));
+    }
+    if (!reader.good) return false;
+
+    // The record dimension reports the amount of records, like ncmpi_inq_dim does
+    for (auto& dim : _dimensions)
+        if (!dim.length) dim.length = _records;
+    for (auto& var : _variables)
+        for (auto& dim : var.info.dimensions)
+            dim.length = _dimensions[dim.id].length;
+
+    // Records are interleaved, each record holds one slab of every record variable. When there is only one
+    // record variable its slabs are not padded.
+    const auto record_vars = std::count_if(_variables.begin(), _variables.end(), [](const auto& v) { return v.record; });
+    for (const auto& var : _variables)
+    {
+        if (!var.record) continue;
+        if (record_vars == 1)
+            _record_size = std::accumulate(var.info.dimensions.begin() + 1, var.info.dimensions.end(),
+                external_size(var.info.type), [](std::size_t a, const auto& d) { return a * d.length; });
+        else
+            _record_size += var.size;
+    }
+
+    return true;
+}
+
+const mapped_file::entry* mapped_file::_find(const std::string& name) const
+{
+    const auto it = _variable_ids.find(name);
+    if (it == _variable_ids.end()) return nullptr;
+    return &_variables[it->second];
+}
+
+result<std::unordered_map<std::string, MPI_Offset>>
+mapped_file::get_dimension_lengths() const
+{
+    if (!_good) return { error_code::NullFile };
+
+    std::unordered_map<std::string, MPI_Offset> map;
+    for (const auto& dim : _dimensions)
+        map.insert(std::pair(dim.name, dim.length));
+    return { std::move(map) };
+}
+
+result<info>
+mapped_file::inquire() const
+{
+    if (!_good) return { error_code::NullFile };
+
+    info i;
+    i.dimensions = _dimensions.size();
+    i.variables  = _variables.size();
+    i.attributes = _attributes;
+    return { std::move(i) };
+}
+
+result<std::vector<std::string>>
+mapped_file::variable_names() const
+{
+    if (!_good) return { error_code::NullFile };
+
+    std::vector<std::string> names;
+    names.reserve(_variables.size());
+    for (const auto& var : _variables) names.push_back(var.name);
+    return { std::move(names) };
+}
+
+result<variable>
+mapped_file::get_variable_info(const std::string& name) const
+{
+    if (!_good) return { error_code::NullFile };
+
+    const auto* var = _find(name);
+    if (!var) return { error_code::VariableDoesntExist };
+
+    auto info = var->info;
+    return { std::move(info) };
+}
+
+result<value_info>
+mapped_file::get_variable_value_info(const std::string& name) const
+{
+    if (!_good) return { error_code::NullFile };
+
+    const auto* var = _find(name);
+    if (!var) return { error_code::VariableDoesntExist };
+
+    value_info ret;
+    ret.type  = var->info.type;
+    ret.index = var->info.index;
+    ret.size  = 1;
+    for (const auto& dim : var->info.dimensions)
+        ret.size *= dim.length;
+    return { std::move(ret) };
+}
+
+template<typename _Type>
+result<std::vector<typename _Type::integral_type>>
+mapped_file::read_variable_sync(
+    const std::string& name,
+    const std::vector<MPI_Offset>& start,
+    const std::vector<MPI_Offset>& count) const
+{
+    using T = typename _Type::integral_type;
+
+    if (!_good) return { error_code::NullFile };
+
+    const auto* var = _find(name);
+    if (!var) return { error_code::VariableDoesntExist };
+    if (!io::convertible(var->info.type, _Type::nc)) return { error_code::TypeMismatch };
+
+    const auto& dims = var->info.dimensions;
+    if (start.size() != dims.size() || count.size() != dims.size()) return { error_code::DimensionSizeMismatch };
+    for (uint32_t i = 0; i < dims.size(); i++)
+        if (start[i] < 0 || count[i] < 0 || start[i] + count[i] > dims[i].length)
+            return { error_code::SizeMismatch };
+
+    const std::size_t total = std::accumulate(count.begin(), count.end(), std::size_t(1), std::multiplies<std::size_t>());
+    std::vector<T> values(total);
+    if (!total) return { std::move(values) };
+
+    // Byte strides of each dimension inside one record (or the whole variable if it isn't a record variable)
+    const auto element = external_size(var->info.type);
+    const std::size_t first = (var->record ? 1 : 0);
+    std::vector<std::size_t> strides(dims.size(), element);
+    for (int i = (int)dims.size() - 2; i >= (int)first; i--)
+        strides[i] = strides[i + 1] * dims[i + 1].length;
+    if (var->record) strides[0] = _record_size;
+
+    // Walk every innermost row of the hyperslab, each of which is contiguous in the file. A one dimensional
+    // record variable has one value per record, so its rows are single values.
+    const auto rank = dims.size();
+    const bool per_record = (var->record && rank == 1);
+    const std::size_t row = (rank && !per_record ? count[rank - 1] : 1);
+    std::vector<MPI_Offset> index(per_record ? 1 : (rank ? rank - 1 : 0), 0);
+    for (std::size_t out = 0; out < total; out += row)
+    {
+        std::size_t position = var->begin;
+        for (uint32_t i = 0; i < rank; i++)
+            position += (start[i] + (i < index.size() ? index[i] : 0)) * strides[i];
+
+        if (position + row * element > _size) return { error_code::SizeMismatch };
+        io::load_big_endian_as(var->info.type, _data + position, values.data() + out, row);
+
+        for (int i = (int)index.size() - 1; i >= 0; i--)
+        {
+            if (++index[i] < count[i]) break;
+            index[i] = 0;
+        }
+    }
+
+    return { std::move(values) };
+}
+template result<std::vector<double>> mapped_file::read_variable_sync<types::Double>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template result<std::vector<float>> mapped_file::read_variable_sync<types::Float>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template result<std::vector<int>> mapped_file::read_variable_sync<types::Int>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template result<std::vector<long long>> mapped_file::read_variable_sync<types::Int64>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template result<std::vector<char>> mapped_file::read_variable_sync<types::Char>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+
+template<typename _Type>
+result<mapped_array<typename _Type::integral_type>>
+mapped_file::map_variable(const std::string& name) const
+{
+    using T = typename _Type::integral_type;
+
+    if (!_good) return { error_code::NullFile };
+
+    const auto* var = _find(name);
+    if (!var) return { error_code::VariableDoesntExist };
+    if (var->info.type != _Type::nc) return { error_code::TypeMismatch };
+
+    // Record variables are interleaved with each other unless there is only one of them
+    const auto record_vars = std::count_if(_variables.begin(), _variables.end(), [](const auto& v) { return v.record; });
+    if (var->record && record_vars > 1) return { error_code::NotContiguous };
+
+    const std::size_t cells = std::accumulate(var->info.dimensions.begin(), var->info.dimensions.end(),
+        std::size_t(1), [](std::size_t a, const auto& d) { return a * d.length; });
+    if (var->begin + cells * sizeof(T) > _size) return { error_code::SizeMismatch };
+
+    return { mapped_array<T>(_data + var->begin, cells) };
+}
+template result<mapped_array<double>> mapped_file::map_variable<types::Double>(const std::string&) const;
+template result<mapped_array<float>> mapped_file::map_variable<types::Float>(const std::string&) const;
+template result<mapped_array<int>> mapped_file::map_variable<types::Int>(const std::string&) const;
+template result<mapped_array<long long>> mapped_file::map_variable<types::Int64>(const std::string&) const;
+template result<mapped_array<char>> mapped_file::map_variable<types::Char>(const std::string&) const;
+
+result<dimension>
+mapped_file::get_dimension(int id) const
+{
+    if (!_good) return { error_code::NullFile };
+    if (id < 0 || id >= (int)_dimensions.size()) return { error_code::DimensionDoesntExist };
+
+    auto dim = _dimensions[id];
+    return { std::move(dim) };
+}
+
+result<dimension>
+mapped_file::get_dimension(const std::string& name) const
+{
+    if (!_good) return { error_code::NullFile };
+
+    const auto it = std::find_if(_dimensions.begin(), _dimensions.end(), [&](const auto& d) { return d.name == name; });
+    if (it == _dimensions.end()) return { error_code::DimensionDoesntExist };
+
+    auto dim = *it;
+    return { std::move(dim) };
+}
+
+}
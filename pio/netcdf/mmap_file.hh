@@ -0,0 +1,150 @@
+/**
+ * @file mmap_file.hh
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief Read-only, memory-mapped access to classic NetCDF files.
+ *
+ * Parses the CDF-1 (classic), CDF-2 (64-bit offset) and CDF-5 headers directly and `mmap`s the file, so
+ * no MPI-IO or PnetCDF initialization is needed and only the pages that are actually read are touched.
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#pragma once
+
+#include "net_file.hh"
+#include "../io/byteswap.hh"
+
+namespace pio::netcdf
+{
+    /** \brief Zero-copy view over the raw, big-endian values of a variable
+     *
+     * Nothing is converted when the view is created. Values are byte-swapped when they are accessed, either one
+     * at a time through `operator[]` or in bulk through \ref copy (which is vectorized).
+     */
+    template<typename T>
+    struct mapped_array
+    {
+        mapped_array(const unsigned char* data, std::size_t size) :
+            _data(data), _size(size)
+        {   }
+
+        std::size_t size() const { return _size; }
+
+        /// The raw file bytes of this variable
+        const unsigned char* raw() const { return _data; }
+
+        T operator[](const std::size_t& index) const
+        {
+            assert(index < _size);
+            return io::load_big_endian<T>(_data + index * sizeof(T));
+        }
+
+        /// Copy `count` values starting at `first` into native-endian memory
+        void copy(T* out, std::size_t first, std::size_t count) const
+        {
+            assert(first + count <= _size);
+            io::load_big_endian(_data + first * sizeof(T), out, count);
+        }
+
+    private:
+        const unsigned char* _data;
+        std::size_t _size;
+    };
+
+    /** \brief A read-only NetCDF file backed by `mmap`
+     *
+     * Provides the same read methods as \ref file<io::access::ro> so it can be selected in its place in templated
+     * code, for example
+     * \code {.cpp}
+     * netcdf::mapped_file in("mesh.exo");
+     * const auto x = in.read_variable_sync<types::Double>("coordx", { 0 }, { num_nodes });
+     * \endcode
+     * \note Only usable on a file that is not being written to concurrently
+     */
+    struct mapped_file
+    {
+        mapped_file(const std::string& filename);
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file(mapped_file&&) = delete;
+
+        ~mapped_file();
+
+        auto error_string() const { return _error.message(); }
+
+        void close();
+
+        bool error()    const { return !_good; }
+        auto good()     const { return _good; }
+        operator bool() const { return good(); }
+
+        /// Get the lengths of each dimension in the file
+        result<std::unordered_map<std::string, MPI_Offset>>
+        get_dimension_lengths() const;
+
+        /// Get basic info about the file
+        result<info>
+        inquire() const;
+
+        /// Get the names of all of the variables
+        result<std::vector<std::string>>
+        variable_names() const;
+
+        /// Get the features of a variable
+        result<variable>
+        get_variable_info(const std::string& name) const;
+
+        /// Get the information about the data a variable describes
+        result<value_info>
+        get_variable_value_info(const std::string& name) const;
+
+        /// Copy a section of the file into memory, converting from the stored type if `_Type` differs
+        template<typename _Type>
+        result<std::vector<typename _Type::integral_type>>
+        read_variable_sync(
+            const std::string& name,
+            const std::vector<MPI_Offset>& start,
+            const std::vector<MPI_Offset>& count) const;
+
+        /// Get a zero-copy view of an entire variable \note only possible for variables stored contiguously, as `_Type` exactly
+        template<typename _Type>
+        result<mapped_array<typename _Type::integral_type>>
+        map_variable(const std::string& name) const;
+
+        /// Get a dimension by id
+        result<dimension>
+        get_dimension(int id) const;
+
+        /// Get a dimension by name
+        result<dimension>
+        get_dimension(const std::string& name) const;
+
+    private:
+        struct entry
+        {
+            std::string name;
+            variable info;
+            std::size_t begin, size;
+            bool record;
+        };
+
+        bool _parse();
+        const entry* _find(const std::string& name) const;
+
+        const unsigned char* _data;
+        std::size_t _size;
+        int _fd;
+        bool _good;
+        error_code _error;
+
+        std::size_t _records, _record_size;
+        int _attributes;
+        std::vector<dimension> _dimensions;
+        std::vector<entry> _variables;
+        std::unordered_map<std::string, std::size_t> _variable_ids;
+    };
+}
@@ -1,4 +1,5 @@
 #include "net_file.hh"
+#include "../exodus/ex_file.hh"
 
 #include <iostream>
 #include <numeric>
@@ -46,6 +47,10 @@ std::string error_code::_to_string(code c)
     case NullFile:              return "File reference is corrupted";
     case VariableDoesntExist:   return "Requested variable name doesn't exist";
     case FailedTaskCreation:    return "Failed to create tasks";
+    case UnsupportedFormat:     return "File is not a classic, 64-bit offset or CDF-5 file";
+    case NotContiguous:         return "Variable is not stored contiguously";
+    case IndexOutOfBounds:      return "Index out of bounds";
+    case OtherProcessFailed:    return "Another process in the collective call failed";
     default: return "";
     }
 }
@@ -92,177 +97,1371 @@ file<_Access>::exodus_file::get_variables() const
 
     // Read the values from the file
     const auto& [var_count, len_name] = std::tie(it_num_elem_var->length, it_len_name->length);
-    const auto var = _file->get_variable_values<types::Char>("name_elem_var", { 0, 0 }, { var_count, len_name });
+    auto var = _file->get_variable_values<types::Char>("name_elem_var", { 0, 0 }, { var_count, len_name });
     if (!var) return { var.error() };
     const auto stat = var.wait();
-    return { netcdf::format(var.template get_data<0>(), var_count, len_name) };
+    return { netcdf::format(var.template take<0>(), var_count, len_name) };
 }
 FWD_DEC_READ(result<std::vector<std::string>>, exodus_file::get_variables);
 
+template<io::access _Access>
+result<std::vector<std::string>>
+file<_Access>::exodus_file::_read_names(const std::string& variable, const std::string& count) const
+{
+    if (!_file) return { error_code::NullFile };
+
+    const auto lengths = _file->get_dimension_lengths();
+    if (!lengths) return { lengths.error() };
+    if (!lengths->count(count)) return { std::vector<std::string>() };
+
+    const auto str_len_name = (lengths->count("len_name") ? "len_name" : "len_string");
+    if (!lengths->count(str_len_name)) return { error_code::DimensionDoesntExist };
+    const auto& [rows, len_name] = std::pair(lengths->at(count), lengths->at(str_len_name));
+
+    auto names = _file->template read_variable_sync<types::Char>(variable, { 0, 0 }, { rows, len_name });
+    if (!names) return { names.error() };
+    return { format(std::move(names).value(), rows, len_name) };
+}
+
+template<io::access _Access>
+template<typename>
+result<std::vector<std::string>>
+file<_Access>::exodus_file::get_nodal_variables() const
+{
+    return _read_names("name_nod_var", "num_nod_var");
+}
+FWD_DEC_READ(result<std::vector<std::string>>, exodus_file::get_nodal_variables);
+
+template<io::access _Access>
+template<typename>
+result<std::vector<std::string>>
+file<_Access>::exodus_file::get_global_variables() const
+{
+    return _read_names("name_glo_var", "num_glo_var");
+}
+FWD_DEC_READ(result<std::vector<std::string>>, exodus_file::get_global_variables);
+
 using coord_values = std::unordered_map<std::string, std::vector<double>>;
 template<io::access _Access>
-template<typename>
-result<coord_values>
-file<_Access>::exodus_file::get_node_coordinates(bool get_data) const
+template<typename>
+result<coord_values>
+file<_Access>::exodus_file::get_node_coordinates(bool get_data) const
+{
+    if (!_file) return { error_code::NullFile };
+    const auto info = _file->get_dimension_lengths();
+    if (!info) return { info.error() };
+
+    const auto str_len_name = [&]() -> std::string
+    {
+        if (info->count("len_name")) return "len_name";
+        if (info->count("len_string")) return "len_string";
+        return "";
+    }();
+
+    if (!info->count("num_dim") || !str_len_name.size()) return { error_code::DimensionDoesntExist };
+    
+    // get dimension of file
+    const auto& dim = info->at("num_dim");
+    const auto& len_name = info->at(str_len_name);
+
+    // read in coor_names
+    auto promise = _file->get_variable_values<types::Char>("coor_names", { 0, 0 }, { dim, len_name });
+    if (!promise) return { promise.error() };
+    promise.wait();
+    const auto names = format(promise.template take<0>(), dim, len_name);
+
+    coord_values values;
+    for (const auto& name : names) values[name];
+
+    if (!get_data) return { std::move(values) };
+
+    // check cdf variables for coord (if it's the old format)
+    const auto cdf_vars = _file->variable_names();
+    if (!cdf_vars) return { cdf_vars.error() };
+    const auto it = std::find(cdf_vars->begin(), cdf_vars->end(), "coord");
+    const bool old = (it != cdf_vars->end());
+
+    if (!info->count("num_nodes")) return { error_code::DimensionDoesntExist };
+    const auto& num_nodes = info->at("num_nodes");
+
+    if (old)
+    {
+        // read from variable called coord and split data up        
+        auto value_promise = _file->get_variable_values<types::Double>("coord", { 0, 0 }, { dim, num_nodes });
+        if (!value_promise) return { value_promise.error() };
+        
+        value_promise.wait();
+        const auto data = value_promise.template take<0>();
+
+        for (uint32_t i = 0; i < names.size(); i++)
+            std::copy(data.begin() + i * num_nodes, data.begin() + (i + 1) * num_nodes, std::back_inserter(values.at(names[i])));
+    }
+    else
+    {
+        // need to make sure they exist
+        for (const auto& name : names)
+        {
+            if (std::find(cdf_vars->begin(), cdf_vars->end(), "coord" + name) == cdf_vars->end())
+                return { error_code::VariableDoesntExist };
+
+            auto value_promise = _file->get_variable_values<types::Double>("coord" + name, { 0 }, { num_nodes });
+            if (!value_promise) return { value_promise.error() };
+            
+            value_promise.wait();
+            values.at(name) = value_promise.template take<0>();
+        }
+    }
+
+    return { std::move(values) };
+}
+FWD_DEC_READ(result<coord_values>, exodus_file::get_node_coordinates, bool);
+
+using P = promise<io::access::wo, types::Double>;
+template<io::access _Access>
+template<typename>
+result<std::vector<std::shared_ptr<const P>>>
+file<_Access>::exodus_file::write_node_coordinates(
+    MPI_Comm comm, 
+    const coord_values& data)
+{
+    if (!_file) return { error_code::NullFile };
+
+    // the list needs to be the same for all processes, so we need to sort to
+    // get over the "unordered" part of the map
+    const auto names = [&]()
+    { 
+        std::vector<std::string> r;
+        r.reserve(data.size());
+        for (const auto& p : data) r.push_back(p.first);
+        std::sort(r.begin(), r.end());
+        return r;
+    }();
+    
+    io::distributor dist(comm);
+    for (uint32_t i = 0; i < names.size(); i++)
+    {
+        io::distributor::volume volume{0};
+        volume.data_index = i;
+        volume.data_type = NC_DOUBLE;
+        volume.dimensions.push_back(data.at(names[i]).size());
+        dist.data_volumes.push_back(volume);
+    }
+
+    const auto subvols = dist.get_tasks();
+    if (!subvols) return { error_code::FailedTaskCreation };
+
+    std::vector<std::shared_ptr<const P>> promises;
+    for (const auto& subvol : *subvols)
+    {
+        const auto& coord_name = names[dist.data_volumes[subvol.volume_index].data_index];
+        const auto& coords = data.at(coord_name);
+
+        const auto promise = _file->write_variable<types::Double>("coord" + coord_name, &coords[0] + subvol.offsets[0], subvol.counts[0], subvol.offsets, subvol.counts);
+        promises.push_back(std::make_shared<const P>(promise));
+    }
+
+    return { std::move(promises) };
+}
+FWD_DEC_WRITE(result<std::vector<std::shared_ptr<const P>>>, exodus_file::write_node_coordinates, MPI_Comm, const coord_values&);
+
+/// Whether a block holds arbitrary polyhedra, whose connectivity is stored flat along with a node count per element
+static bool polyhedra(const std::string& type)
+{
+    return exodus::nsided(type) || exodus::nfaced(type);
+}
+
+/// The variable holding nodal variable `variable` (from 1) and where its values start at a time step
+/// \note older files keep every nodal variable in a single (time_step, num_nod_var, num_nodes) variable
+template<typename F>
+static auto nodal_variable(const std::vector<std::string>& cdf_vars, int variable, MPI_Offset time_step, MPI_Offset node, F&& f)
+{
+    if (std::find(cdf_vars.begin(), cdf_vars.end(), "vals_nod_var") != cdf_vars.end())
+        return f(std::string("vals_nod_var"), std::vector<MPI_Offset>{ time_step, (MPI_Offset)variable - 1, node }, true);
+    return f("vals_nod_var" + std::to_string(variable), std::vector<MPI_Offset>{ time_step, node }, false);
+}
+
+/// Split `lengths` items (elements of each block, nodes, ...) evenly over `comm`, returns this process' ranges
+static result<std::vector<io::distributor::subvolume>>
+share(MPI_Comm comm, const std::vector<MPI_Offset>& lengths)
+{
+    io::distributor dist(comm);
+    for (uint32_t i = 0; i < lengths.size(); i++)
+    {
+        if (!lengths[i]) continue;
+
+        io::distributor::volume volume{0};
+        volume.data_index = i;
+        volume.data_type = NC_INT;
+        volume.dimensions.push_back(lengths[i]);
+        dist.data_volumes.push_back(volume);
+    }
+
+    auto tasks = dist.get_tasks();
+    if (!tasks) return { error_code::FailedTaskCreation };
+
+    // Point the subvolumes back at the caller's list and drop the empty ones
+    std::vector<io::distributor::subvolume> ranges;
+    for (auto& task : *tasks)
+    {
+        if (!task.counts[0]) continue;
+        task.volume_index = dist.data_volumes[task.volume_index].data_index;
+        ranges.push_back(std::move(task));
+    }
+
+    return { std::move(ranges) };
+}
+
+template<io::access _Access>
+template<typename>
+result<std::vector<element_block>>
+file<_Access>::exodus_file::get_blocks() const
+{
+    if (!_file) return { error_code::NullFile };
+    const auto lengths = _file->get_dimension_lengths();
+    if (!lengths) return { lengths.error() };
+
+    const auto length = [&](const std::string& name) -> MPI_Offset
+    {
+        const auto it = lengths->find(name);
+        return (it == lengths->end() ? 0 : it->second);
+    };
+
+    std::vector<element_block> blocks(length("num_el_blk"));
+    if (blocks.empty()) return { std::move(blocks) };
+
+    const auto ids = _file->template read_variable_sync<types::Int64>("eb_prop1", { 0 }, { (MPI_Offset)blocks.size() });
+    if (!ids) return { ids.error() };
+
+    // Older files don't name their blocks
+    const auto len_name = length("len_name");
+    auto names = (len_name ? _file->template read_variable_sync<types::Char>("eb_names", { 0, 0 }, { (MPI_Offset)blocks.size(), len_name }) : result<std::vector<char>>(error_code::VariableDoesntExist));
+    const auto block_names = (names ? format(std::move(names).value(), blocks.size(), len_name) : std::vector<std::string>(blocks.size()));
+
+    for (uint32_t i = 0; i < blocks.size(); i++)
+    {
+        const auto n = std::to_string(i + 1);
+
+        auto& block = blocks[i];
+        block.index = i + 1;
+        block.id = (*ids)[i];
+        block.elements       = length("num_el_in_blk"  + n);
+        block.nodes_per_elem = length("num_nod_per_el" + n);
+        block.attributes     = length("num_att_in_blk" + n);
+        block.name = block_names[i];
+
+        // Empty blocks may not have a connectivity variable to hang the type on
+        auto type = _file->get_attribute_text("connect" + n, "elem_type");
+        block.type = (type ? std::move(type).value() : "NULL");
+    }
+
+    return { std::move(blocks) };
+}
+FWD_DEC_READ(result<std::vector<element_block>>, exodus_file::get_blocks);
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<std::vector<exodus_section<_Type>>>
+file<_Access>::exodus_file::get_block_connectivity(MPI_Comm comm, const std::vector<element_block>& blocks) const
+{
+    if (!_file) return { error_code::NullFile };
+
+    std::vector<MPI_Offset> elements;
+    for (const auto& block : blocks)
+        elements.push_back(polyhedra(block.type) ? 0 : block.elements);
+
+    const auto ranges = share(comm, elements);
+    if (!ranges) return { ranges.error() };
+
+    std::vector<exodus_section<_Type>> sections;
+    for (const auto& range : *ranges)
+    {
+        const auto& block = blocks[range.volume_index];
+        const auto name = "connect" + std::to_string(block.index);
+
+        auto promise = _file->template get_variable_values<_Type>(name, { range.offsets[0], 0 }, { range.counts[0], block.nodes_per_elem });
+        if (!promise) return { promise.error() };
+        sections.push_back(exodus_section<_Type>{ name, range.volume_index, std::move(promise) });
+    }
+
+    return { std::move(sections) };
+}
+template result<std::vector<exodus_section<types::Int>>> file<io::access::ro>::exodus_file::get_block_connectivity<types::Int>(MPI_Comm, const std::vector<element_block>&) const;
+template result<std::vector<exodus_section<types::Int64>>> file<io::access::ro>::exodus_file::get_block_connectivity<types::Int64>(MPI_Comm, const std::vector<element_block>&) const;
+template result<std::vector<exodus_section<types::Int>>> file<io::access::rw>::exodus_file::get_block_connectivity<types::Int>(MPI_Comm, const std::vector<element_block>&) const;
+template result<std::vector<exodus_section<types::Int64>>> file<io::access::rw>::exodus_file::get_block_connectivity<types::Int64>(MPI_Comm, const std::vector<element_block>&) const;
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<std::vector<exodus_section<_Type>>>
+file<_Access>::exodus_file::get_element_variable_values(MPI_Comm comm, const std::vector<element_block>& blocks, int variable, MPI_Offset time_step) const
+{
+    if (!_file) return { error_code::NullFile };
+    if (variable < 1) return { error_code::VariableDoesntExist };
+
+    const auto cdf_vars = _file->variable_names();
+    if (!cdf_vars) return { cdf_vars.error() };
+
+    // The truth table may leave the variable out of some blocks, those just don't have a NetCDF variable
+    std::vector<std::string> names;
+    std::vector<MPI_Offset> elements;
+    for (const auto& block : blocks)
+    {
+        names.push_back("vals_elem_var" + std::to_string(variable) + "eb" + std::to_string(block.index));
+        const bool present = (std::find(cdf_vars->begin(), cdf_vars->end(), names.back()) != cdf_vars->end());
+        elements.push_back(present ? block.elements : 0);
+    }
+
+    const auto ranges = share(comm, elements);
+    if (!ranges) return { ranges.error() };
+
+    std::vector<exodus_section<_Type>> sections;
+    for (const auto& range : *ranges)
+    {
+        const auto& name = names[range.volume_index];
+
+        auto promise = _file->template get_variable_values<_Type>(name, { time_step, range.offsets[0] }, { 1, range.counts[0] });
+        if (!promise) return { promise.error() };
+        sections.push_back(exodus_section<_Type>{ name, range.volume_index, std::move(promise) });
+    }
+
+    return { std::move(sections) };
+}
+template result<std::vector<exodus_section<types::Double>>> file<io::access::ro>::exodus_file::get_element_variable_values<types::Double>(MPI_Comm, const std::vector<element_block>&, int, MPI_Offset) const;
+template result<std::vector<exodus_section<types::Float>>> file<io::access::ro>::exodus_file::get_element_variable_values<types::Float>(MPI_Comm, const std::vector<element_block>&, int, MPI_Offset) const;
+template result<std::vector<exodus_section<types::Double>>> file<io::access::rw>::exodus_file::get_element_variable_values<types::Double>(MPI_Comm, const std::vector<element_block>&, int, MPI_Offset) const;
+template result<std::vector<exodus_section<types::Float>>> file<io::access::rw>::exodus_file::get_element_variable_values<types::Float>(MPI_Comm, const std::vector<element_block>&, int, MPI_Offset) const;
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<std::vector<exodus_section<_Type>>>
+file<_Access>::exodus_file::read_node_coordinates(MPI_Comm comm) const
+{
+    if (!_file) return { error_code::NullFile };
+
+    const auto lengths = _file->get_dimension_lengths();
+    if (!lengths) return { lengths.error() };
+
+    const auto str_len_name = (lengths->count("len_name") ? "len_name" : "len_string");
+    if (!lengths->count("num_nodes") || !lengths->count("num_dim") || !lengths->count(str_len_name))
+        return { error_code::DimensionDoesntExist };
+    const auto num_dim  = lengths->at("num_dim");
+    const auto len_name = lengths->at(str_len_name);
+
+    const auto cdf_vars = _file->variable_names();
+    if (!cdf_vars) return { cdf_vars.error() };
+    const bool old = (std::find(cdf_vars->begin(), cdf_vars->end(), "coord") != cdf_vars->end());
+
+    // Unlike get_node_coordinates the order matters here, the i-th row of coor_names is the i-th coordinate
+    auto name_promise = _file->template get_variable_values<types::Char>("coor_names", { 0, 0 }, { num_dim, len_name });
+    if (!name_promise) return { name_promise.error() };
+    name_promise.wait();
+    const auto names = format(name_promise.template take<0>(), num_dim, len_name);
+
+    const auto ranges = share(comm, { lengths->at("num_nodes") });
+    if (!ranges) return { ranges.error() };
+
+    std::vector<exodus_section<_Type>> sections;
+    for (const auto& range : *ranges)
+        for (uint32_t i = 0; i < names.size(); i++)
+        {
+            const auto name = (old ? std::string("coord") : "coord" + names[i]);
+            auto promise = (old ?
+                _file->template get_variable_values<_Type>(name, { (MPI_Offset)i, range.offsets[0] }, { 1, range.counts[0] }) :
+                _file->template get_variable_values<_Type>(name, { range.offsets[0] }, { range.counts[0] }));
+            if (!promise) return { promise.error() };
+            sections.push_back(exodus_section<_Type>{ name, i, std::move(promise) });
+        }
+
+    return { std::move(sections) };
+}
+template result<std::vector<exodus_section<types::Double>>> file<io::access::ro>::exodus_file::read_node_coordinates<types::Double>(MPI_Comm) const;
+template result<std::vector<exodus_section<types::Float>>> file<io::access::ro>::exodus_file::read_node_coordinates<types::Float>(MPI_Comm) const;
+template result<std::vector<exodus_section<types::Double>>> file<io::access::rw>::exodus_file::read_node_coordinates<types::Double>(MPI_Comm) const;
+template result<std::vector<exodus_section<types::Float>>> file<io::access::rw>::exodus_file::read_node_coordinates<types::Float>(MPI_Comm) const;
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<exodus_partition<_Type>>
+file<_Access>::exodus_file::get_partition(MPI_Comm comm, const std::vector<element_block>& blocks) const
+{
+    if (!_file) return { error_code::NullFile };
+
+    const auto lengths = _file->get_dimension_lengths();
+    if (!lengths) return { lengths.error() };
+
+    const auto str_len_name = (lengths->count("len_name") ? "len_name" : "len_string");
+    if (!lengths->count("num_dim") || !lengths->count(str_len_name)) return { error_code::DimensionDoesntExist };
+    const auto num_dim  = lengths->at("num_dim");
+    const auto len_name = lengths->at(str_len_name);
+
+    const auto cdf_vars = _file->variable_names();
+    if (!cdf_vars) return { cdf_vars.error() };
+    const bool old = (std::find(cdf_vars->begin(), cdf_vars->end(), "coord") != cdf_vars->end());
+
+    exodus_partition<_Type> partition;
+    {
+        auto names = _file->template read_variable_sync<types::Char>("coor_names", { 0, 0 }, { num_dim, len_name });
+        if (!names) return { names.error() };
+        partition.coordinate_names = format(std::move(names).value(), num_dim, len_name);
+    }
+
+    auto sections = get_block_connectivity<types::Int64>(comm, blocks);
+    if (!sections) return { sections.error() };
+
+    // The connectivity of the owned elements, still in file node numbers (from 1)
+    std::vector<long long> global;
+    partition.offsets.push_back(0);
+    for (auto& section : *sections)
+    {
+        section.data.wait();
+        if (!section.data.good()) return { section.data.error() };
+
+        const auto extent = section.data.template view<0>();
+        const auto& block = blocks[section.index];
+        partition.ranges.push_back({ section.index, extent.offset()[0], extent.shape()[0] });
+
+        const auto values = section.data.template take<0>();
+        global.insert(global.end(), values.begin(), values.end());
+        for (MPI_Offset e = 0; e < extent.shape()[0]; e++)
+            partition.offsets.push_back(partition.offsets.back() + block.nodes_per_elem);
+    }
+
+    // Every node an owned element touches, ghosts included
+    partition.nodes.reserve(global.size());
+    for (const auto node : global) partition.nodes.push_back(node - 1);
+    std::sort(partition.nodes.begin(), partition.nodes.end());
+    partition.nodes.erase(std::unique(partition.nodes.begin(), partition.nodes.end()), partition.nodes.end());
+
+    partition.connectivity.reserve(global.size());
+    for (const auto node : global)
+        partition.connectivity.push_back(std::lower_bound(partition.nodes.begin(), partition.nodes.end(), node - 1) - partition.nodes.begin());
+
+    // Neighbouring nodes mostly have neighbouring numbers, so the scattered reads collapse into a few runs
+    std::vector<std::pair<MPI_Offset, MPI_Offset>> runs;
+    for (const auto node : partition.nodes)
+    {
+        if (!runs.empty() && runs.back().first + runs.back().second == node) runs.back().second++;
+        else runs.push_back(std::pair(node, 1));
+    }
+
+    {
+        // The coordinates are read collectively
+        const auto err = _file->storage().end_indep_data(_file->handle);
+        if (err != NC_NOERR && err != NC_ENOTINDEP) return { netcdf_error(err) };
+    }
+
+    // Every coordinate is looked up before anything is posted, so a missing or mistyped one fails before any read is pending
+    std::vector<std::string> names;
+    std::vector<int> indices;
+    for (MPI_Offset d = 0; d < num_dim; d++)
+    {
+        names.push_back(old ? std::string("coord") : "coord" + partition.coordinate_names[d]);
+
+        int index;
+        nc_type type;
+        NET_CHECK(_file->storage().inq_varid(_file->handle, names.back().c_str(), &index));
+        NET_CHECK(_file->storage().inq_vartype(_file->handle, index, &type));
+        if (!io::convertible(type, _Type::nc)) return { error_code::TypeMismatch };
+        indices.push_back(index);
+    }
+
+    // The old layout keeps every coordinate in one (num_dim, num_nodes) variable
+    const std::size_t ndims = (old ? 2 : 1);
+
+    PIO_TRACE_SCOPE("get_partition", "", partition.nodes.size() * num_dim * sizeof(typename _Type::integral_type));
+    PIO_TRACE_BATCH(spans, "read");
+    partition.coordinates.resize(num_dim);
+    std::vector<int> requests;
+    int posted = NC_NOERR;
+    for (MPI_Offset d = 0; d < num_dim; d++)
+    {
+        partition.coordinates[d].resize(partition.nodes.size());
+        if (runs.empty()) continue;
+
+        std::vector<MPI_Offset> starts, counts;
+        for (const auto& [first, count] : runs)
+        {
+            if (old) { starts.push_back(d); counts.push_back(1); }
+            starts.push_back(first);
+            counts.push_back(count);
+        }
+
+        std::vector<MPI_Offset*> start_ptrs, count_ptrs;
+        for (std::size_t i = 0; i < starts.size(); i += ndims)
+        {
+            start_ptrs.push_back(&starts[i]);
+            count_ptrs.push_back(&counts[i]);
+        }
+
+        int request;
+        posted = _file->storage().iget_varn(_file->handle, indices[d], runs.size(), start_ptrs.data(), count_ptrs.data(), partition.coordinates[d].data(), partition.nodes.size(), _Type::mpi, &request);
+        if (posted != NC_NOERR) break;
+
+        requests.push_back(request);
+        PIO_STATS_READ(names[d], partition.nodes.size() * sizeof(typename _Type::integral_type));
+        PIO_TRACE_BATCH_BEGIN(spans, names[d], partition.nodes.size() * sizeof(typename _Type::integral_type));
+    }
+
+    // The wait is collective, so a process that failed to post still joins it with whatever it did post
+    std::vector<int> statuses(requests.size());
+    {
+        PIO_STATS_TIME(wait);
+        const auto err = _file->storage().wait_all(_file->handle, requests.size(), requests.data(), statuses.data());
+        if (posted != NC_NOERR) return { netcdf_error(posted) };
+        if (err != NC_NOERR) return { netcdf_error(err) };
+    }
+    PIO_TRACE_BATCH_END(spans);
+    for (const auto status : statuses)
+        if (status != NC_NOERR) return { netcdf_error(status) };
+
+    return { std::move(partition) };
+}
+template result<exodus_partition<types::Double>> file<io::access::ro>::exodus_file::get_partition<types::Double>(MPI_Comm, const std::vector<element_block>&) const;
+template result<exodus_partition<types::Float>> file<io::access::ro>::exodus_file::get_partition<types::Float>(MPI_Comm, const std::vector<element_block>&) const;
+template result<exodus_partition<types::Double>> file<io::access::rw>::exodus_file::get_partition<types::Double>(MPI_Comm, const std::vector<element_block>&) const;
+template result<exodus_partition<types::Float>> file<io::access::rw>::exodus_file::get_partition<types::Float>(MPI_Comm, const std::vector<element_block>&) const;
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<exodus_snapshot<_Type>>
+file<_Access>::exodus_file::get_snapshot(MPI_Offset time_step, bool nodal) const
+{
+    if (!_file) return { error_code::NullFile };
+
+    const auto dims = _file->get_dimension_lengths();
+    if (!dims) return { dims.error() };
+    const auto length = [&](const std::string& name) -> MPI_Offset { return (dims->count(name) ? dims->at(name) : 0); };
+    if (time_step < 0 || time_step >= length("time_step")) return { error_code::IndexOutOfBounds };
+
+    const auto cdf_vars = _file->variable_names();
+    if (!cdf_vars) return { cdf_vars.error() };
+    const auto has = [&](const std::string& name) { return std::find(cdf_vars->begin(), cdf_vars->end(), name) != cdf_vars->end(); };
+
+    auto blocks = get_blocks();
+    if (!blocks) return { blocks.error() };
+
+    exodus_snapshot<_Type> snapshot;
+    snapshot.time_step = time_step;
+    snapshot.blocks = std::move(blocks).value();
+
+    if (has("name_elem_var"))
+    {
+        auto names = get_variables();
+        if (!names) return { names.error() };
+        snapshot.element_variables = std::move(names).value();
+    }
+
+    if (nodal && length("num_nod_var"))
+    {
+        const auto count = length("num_nod_var"), len_name = length("len_name");
+        auto names = _file->template read_variable_sync<types::Char>("name_nod_var", { 0, 0 }, { count, len_name });
+        if (!names) return { names.error() };
+        snapshot.nodal_variables = format(std::move(names).value(), count, len_name);
+    }
+
+    // Lay out the buffer first, so that nothing moves once reads are posted into it
+    struct field
+    {
+        std::string variable;
+        std::vector<MPI_Offset> start, count;
+        std::size_t offset, size;
+    };
+    std::vector<field> fields;
+
+    snapshot.offsets.push_back(0);
+    const auto add = [&](const std::string& name, std::vector<MPI_Offset> start, std::vector<MPI_Offset> count, MPI_Offset size)
+    {
+        if (!has(name)) size = 0;
+        if (size) fields.push_back(field{ name, std::move(start), std::move(count), snapshot.offsets.back(), (std::size_t)size });
+        snapshot.offsets.push_back(snapshot.offsets.back() + size);
+    };
+
+    for (uint32_t v = 0; v < snapshot.element_variables.size(); v++)
+        for (const auto& block : snapshot.blocks)
+            add("vals_elem_var" + std::to_string(v + 1) + "eb" + std::to_string(block.index), { time_step, 0 }, { 1, block.elements }, block.elements);
+
+    const auto num_nodes = length("num_nodes");
+    for (uint32_t v = 0; v < snapshot.nodal_variables.size(); v++)
+        nodal_variable(*cdf_vars, v + 1, time_step, 0, [&](const std::string& name, const std::vector<MPI_Offset>& start, bool combined)
+        {
+            add(name, start, (combined ? std::vector<MPI_Offset>{ 1, 1, num_nodes } : std::vector<MPI_Offset>{ 1, num_nodes }), num_nodes);
+        });
+
+    snapshot.values.resize(snapshot.offsets.back());
+    PIO_TRACE_SCOPE("get_snapshot", "", snapshot.values.size() * sizeof(typename _Type::integral_type));
+    PIO_TRACE_BATCH(spans, "read");
+
+    // Every field is looked up before anything is posted, so a bad one can't leave reads pending into the buffer
+    std::vector<int> indices;
+    indices.reserve(fields.size());
+    for (const auto& f : fields)
+    {
+        int index;
+        nc_type type;
+        NET_CHECK(_file->storage().inq_varid(_file->handle, f.variable.c_str(), &index));
+        NET_CHECK(_file->storage().inq_vartype(_file->handle, index, &type));
+        if (!io::convertible(type, _Type::nc)) return { error_code::TypeMismatch };
+        indices.push_back(index);
+    }
+
+    {
+        PIO_STATS_TIME(independent);
+        NET_CHECK(_file->storage().begin_indep_data(_file->handle));
+    }
+
+    std::vector<int> requests;
+    requests.reserve(fields.size());
+    int posted = NC_NOERR;
+    for (std::size_t i = 0; i < fields.size(); i++)
+    {
+        const auto& f = fields[i];
+        int request;
+        posted = _file->storage().iget_vara(_file->handle, indices[i], f.start.data(), f.count.data(), snapshot.values.data() + f.offset, f.size, _Type::mpi, &request);
+        if (posted != NC_NOERR) break;
+
+        requests.push_back(request);
+        PIO_STATS_READ(f.variable, f.size * sizeof(typename _Type::integral_type));
+        PIO_TRACE_BATCH_BEGIN(spans, f.variable, f.size * sizeof(typename _Type::integral_type));
+    }
+
+    // The reads that did get posted write into the snapshot, so they are cancelled before it goes away
+    std::vector<int> statuses(requests.size());
+    if (posted != NC_NOERR)
+    {
+        _file->storage().cancel(_file->handle, requests.size(), requests.data(), statuses.data());
+        return { netcdf_error(posted) };
+    }
+
+    {
+        PIO_STATS_TIME(wait);
+        NET_CHECK(_file->storage().wait(_file->handle, requests.size(), requests.data(), statuses.data()));
+    }
+    PIO_TRACE_BATCH_END(spans);
+    for (const auto status : statuses)
+        if (status != NC_NOERR) return { netcdf_error(status) };
+
+    return { std::move(snapshot) };
+}
+template result<exodus_snapshot<types::Double>> file<io::access::ro>::exodus_file::get_snapshot<types::Double>(MPI_Offset, bool) const;
+template result<exodus_snapshot<types::Float>> file<io::access::ro>::exodus_file::get_snapshot<types::Float>(MPI_Offset, bool) const;
+template result<exodus_snapshot<types::Double>> file<io::access::rw>::exodus_file::get_snapshot<types::Double>(MPI_Offset, bool) const;
+template result<exodus_snapshot<types::Float>> file<io::access::rw>::exodus_file::get_snapshot<types::Float>(MPI_Offset, bool) const;
+
+template<io::access _Access>
+template<typename _Type>
+result<exodus_history<_Type>>
+file<_Access>::exodus_file::_read_history(MPI_Comm comm, const std::vector<MPI_Offset>& entities, const std::vector<history_probe>& probes) const
+{
+    using value_type = typename _Type::integral_type;
+
+    const auto steps = _file->get_dimension("time_step");
+    if (!steps) return { steps.error() };
+
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    // Contiguous runs of time steps in rank order, so the pieces can be gathered straight into place
+    const MPI_Offset total = steps->length;
+    const auto first_step = [&](int r) { return total * r / size; };
+    const MPI_Offset first = first_step(rank), count = first_step(rank + 1) - first;
+
+    const std::size_t width = entities.size();
+    std::vector<value_type> times(count), values(count * width);
+
+    // Each probe reads its entities at every step in one request, step-major, and gets scattered into place afterwards
+    std::vector<std::vector<value_type>> buffers(probes.size());
+    std::vector<int> requests;
+
+    PIO_TRACE_SCOPE("read_history", "", values.size() * sizeof(value_type));
+    PIO_TRACE_BATCH(spans, "read");
+    {
+        // The reads are completed collectively
+        const auto err = _file->storage().end_indep_data(_file->handle);
+        if (err != NC_NOERR && err != NC_ENOTINDEP) return { netcdf_error(err) };
+    }
+
+    // Every process looks the variables up, even one without steps, so none of them is left waiting on the others
+    int time_index;
+    NET_CHECK(_file->storage().inq_varid(_file->handle, "time_whole", &time_index));
+
+    std::vector<int> indices;
+    for (const auto& probe : probes)
+    {
+        int index;
+        nc_type type;
+        NET_CHECK(_file->storage().inq_varid(_file->handle, probe.variable.c_str(), &index));
+        NET_CHECK(_file->storage().inq_vartype(_file->handle, index, &type));
+        if (!io::convertible(type, _Type::nc)) return { error_code::TypeMismatch };
+        indices.push_back(index);
+    }
+
+    if (count)
+    {
+        int request;
+        const std::vector<MPI_Offset> start{ first }, extent{ count };
+        NET_CHECK(_file->storage().iget_vara(_file->handle, time_index, start.data(), extent.data(), times.data(), count, _Type::mpi, &request));
+        requests.push_back(request);
+        PIO_TRACE_BATCH_BEGIN(spans, "time_whole", count * sizeof(value_type));
+    }
+
+    for (uint32_t p = 0; p < probes.size() && count; p++)
+    {
+        const auto& probe = probes[p];
+        const auto ndims = probe.prefix.size() + 2;
+
+        std::vector<MPI_Offset> starts, counts(count * probe.entries.size() * ndims, 1);
+        starts.reserve(counts.size());
+        for (MPI_Offset s = first; s < first + count; s++)
+            for (const auto& entry : probe.entries)
+            {
+                starts.push_back(s);
+                starts.insert(starts.end(), probe.prefix.begin(), probe.prefix.end());
+                starts.push_back(entry.second);
+            }
+
+        std::vector<MPI_Offset*> start_ptrs, count_ptrs;
+        for (std::size_t i = 0; i < starts.size(); i += ndims)
+        {
+            start_ptrs.push_back(&starts[i]);
+            count_ptrs.push_back(&counts[i]);
+        }
+
+        int request;
+        buffers[p].resize(start_ptrs.size());
+        NET_CHECK(_file->storage().iget_varn(_file->handle, indices[p], start_ptrs.size(), start_ptrs.data(), count_ptrs.data(), buffers[p].data(), buffers[p].size(), _Type::mpi, &request));
+        requests.push_back(request);
+        PIO_STATS_READ(probe.variable, buffers[p].size() * sizeof(value_type));
+        PIO_TRACE_BATCH_BEGIN(spans, probe.variable, buffers[p].size() * sizeof(value_type));
+    }
+
+    std::vector<int> statuses(requests.size());
+    {
+        PIO_STATS_TIME(wait);
+        NET_CHECK(_file->storage().wait_all(_file->handle, requests.size(), requests.data(), statuses.data()));
+    }
+    PIO_TRACE_BATCH_END(spans);
+    for (const auto status : statuses)
+        if (status != NC_NOERR) return { netcdf_error(status) };
+
+    for (uint32_t p = 0; p < probes.size(); p++)
+    {
+        const auto& entries = probes[p].entries;
+        for (MPI_Offset s = 0; s < count; s++)
+            for (std::size_t e = 0; e < entries.size(); e++)
+                values[s * width + entries[e].first] = buffers[p][s * entries.size() + e];
+    }
+
+    // Gather every process' steps
+    exodus_history<_Type> history;
+    history.entities = entities;
+    history.times.resize(total);
+    history.values.resize(total * width);
+
+    std::vector<int> step_counts(size), step_displs(size), value_counts(size), value_displs(size);
+    for (int r = 0; r < size; r++)
+    {
+        step_displs[r]  = first_step(r);
+        step_counts[r]  = first_step(r + 1) - first_step(r);
+        value_displs[r] = step_displs[r] * width;
+        value_counts[r] = step_counts[r] * width;
+    }
+
+    MPI_Allgatherv(times.data(), count, _Type::mpi, history.times.data(), step_counts.data(), step_displs.data(), _Type::mpi, comm);
+    MPI_Allgatherv(values.data(), count * width, _Type::mpi, history.values.data(), value_counts.data(), value_displs.data(), _Type::mpi, comm);
+
+    return { std::move(history) };
+}
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<exodus_history<_Type>>
+file<_Access>::exodus_file::get_element_history(MPI_Comm comm, int variable, const std::vector<MPI_Offset>& elements) const
+{
+    if (!_file) return { error_code::NullFile };
+    if (variable < 1) return { error_code::VariableDoesntExist };
+
+    const auto blocks = get_blocks();
+    if (!blocks) return { blocks.error() };
+
+    // Find the block of each element, the probes are ordered by block so every process posts the same requests
+    std::vector<history_probe> probes(blocks->size());
+    std::vector<MPI_Offset> firsts;
+    MPI_Offset total = 0;
+    for (uint32_t i = 0; i < blocks->size(); i++)
+    {
+        firsts.push_back(total);
+        total += (*blocks)[i].elements;
+        probes[i].variable = "vals_elem_var" + std::to_string(variable) + "eb" + std::to_string((*blocks)[i].index);
+    }
+
+    for (std::size_t e = 0; e < elements.size(); e++)
+    {
+        if (elements[e] < 0 || elements[e] >= total) return { error_code::IndexOutOfBounds };
+        const std::size_t b = std::upper_bound(firsts.begin(), firsts.end(), elements[e]) - firsts.begin() - 1;
+        probes[b].entries.push_back(std::pair(e, elements[e] - firsts[b]));
+    }
+
+    probes.erase(std::remove_if(probes.begin(), probes.end(), [](const history_probe& p) { return p.entries.empty(); }), probes.end());
+    return _read_history<_Type>(comm, elements, probes);
+}
+template result<exodus_history<types::Double>> file<io::access::ro>::exodus_file::get_element_history<types::Double>(MPI_Comm, int, const std::vector<MPI_Offset>&) const;
+template result<exodus_history<types::Float>> file<io::access::ro>::exodus_file::get_element_history<types::Float>(MPI_Comm, int, const std::vector<MPI_Offset>&) const;
+template result<exodus_history<types::Double>> file<io::access::rw>::exodus_file::get_element_history<types::Double>(MPI_Comm, int, const std::vector<MPI_Offset>&) const;
+template result<exodus_history<types::Float>> file<io::access::rw>::exodus_file::get_element_history<types::Float>(MPI_Comm, int, const std::vector<MPI_Offset>&) const;
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<exodus_history<_Type>>
+file<_Access>::exodus_file::get_nodal_history(MPI_Comm comm, int variable, const std::vector<MPI_Offset>& nodes) const
+{
+    if (!_file) return { error_code::NullFile };
+    if (variable < 1) return { error_code::VariableDoesntExist };
+
+    const auto num_nodes = _file->get_dimension("num_nodes");
+    if (!num_nodes) return { num_nodes.error() };
+
+    const auto cdf_vars = _file->variable_names();
+    if (!cdf_vars) return { cdf_vars.error() };
+
+    // The prefix is whatever lies between the time step and the node
+    history_probe probe;
+    nodal_variable(*cdf_vars, variable, 0, 0, [&](const std::string& name, const std::vector<MPI_Offset>& start, bool)
+    {
+        probe.variable = name;
+        probe.prefix.assign(start.begin() + 1, start.end() - 1);
+    });
+
+    for (std::size_t n = 0; n < nodes.size(); n++)
+    {
+        if (nodes[n] < 0 || nodes[n] >= num_nodes->length) return { error_code::IndexOutOfBounds };
+        probe.entries.push_back(std::pair(n, nodes[n]));
+    }
+
+    std::vector<history_probe> probes;
+    if (!probe.entries.empty()) probes.push_back(std::move(probe));
+    return _read_history<_Type>(comm, nodes, probes);
+}
+template result<exodus_history<types::Double>> file<io::access::ro>::exodus_file::get_nodal_history<types::Double>(MPI_Comm, int, const std::vector<MPI_Offset>&) const;
+template result<exodus_history<types::Float>> file<io::access::ro>::exodus_file::get_nodal_history<types::Float>(MPI_Comm, int, const std::vector<MPI_Offset>&) const;
+template result<exodus_history<types::Double>> file<io::access::rw>::exodus_file::get_nodal_history<types::Double>(MPI_Comm, int, const std::vector<MPI_Offset>&) const;
+template result<exodus_history<types::Float>> file<io::access::rw>::exodus_file::get_nodal_history<types::Float>(MPI_Comm, int, const std::vector<MPI_Offset>&) const;
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<std::vector<exodus_section<_Type>>>
+file<_Access>::exodus_file::get_nodal_variable_values(MPI_Comm comm, int variable, MPI_Offset time_step) const
+{
+    if (!_file) return { error_code::NullFile };
+    if (variable < 1) return { error_code::VariableDoesntExist };
+
+    const auto num_nodes = _file->get_dimension("num_nodes");
+    if (!num_nodes) return { num_nodes.error() };
+
+    const auto cdf_vars = _file->variable_names();
+    if (!cdf_vars) return { cdf_vars.error() };
+
+    const auto ranges = share(comm, { num_nodes->length });
+    if (!ranges) return { ranges.error() };
+
+    std::vector<exodus_section<_Type>> sections;
+    for (const auto& range : *ranges)
+    {
+        const auto [first, count] = std::pair(range.offsets[0], range.counts[0]);
+        auto promise = nodal_variable(*cdf_vars, variable, time_step, first, [&](const std::string& name, const std::vector<MPI_Offset>& start, bool combined)
+        {
+            return _file->template get_variable_values<_Type>(name, start, (combined ? std::vector<MPI_Offset>{ 1, 1, count } : std::vector<MPI_Offset>{ 1, count }));
+        });
+        if (!promise) return { promise.error() };
+        sections.push_back(exodus_section<_Type>{ "vals_nod_var" + std::to_string(variable), (std::size_t)variable - 1, std::move(promise) });
+    }
+
+    return { std::move(sections) };
+}
+template result<std::vector<exodus_section<types::Double>>> file<io::access::ro>::exodus_file::get_nodal_variable_values<types::Double>(MPI_Comm, int, MPI_Offset) const;
+template result<std::vector<exodus_section<types::Float>>> file<io::access::ro>::exodus_file::get_nodal_variable_values<types::Float>(MPI_Comm, int, MPI_Offset) const;
+template result<std::vector<exodus_section<types::Double>>> file<io::access::rw>::exodus_file::get_nodal_variable_values<types::Double>(MPI_Comm, int, MPI_Offset) const;
+template result<std::vector<exodus_section<types::Float>>> file<io::access::rw>::exodus_file::get_nodal_variable_values<types::Float>(MPI_Comm, int, MPI_Offset) const;
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<promise<io::access::ro, _Type>>
+file<_Access>::exodus_file::get_global_variable_values(MPI_Offset time_step) const
+{
+    if (!_file) return { error_code::NullFile };
+
+    const auto count = _file->get_dimension("num_glo_var");
+    if (!count) return { count.error() };
+
+    auto promise = _file->template get_variable_values<_Type>("vals_glo_var", { time_step, 0 }, { 1, count->length });
+    if (!promise) return { promise.error() };
+    return { std::move(promise) };
+}
+template result<promise<io::access::ro, types::Double>> file<io::access::ro>::exodus_file::get_global_variable_values<types::Double>(MPI_Offset) const;
+template result<promise<io::access::ro, types::Float>> file<io::access::ro>::exodus_file::get_global_variable_values<types::Float>(MPI_Offset) const;
+template result<promise<io::access::ro, types::Double>> file<io::access::rw>::exodus_file::get_global_variable_values<types::Double>(MPI_Offset) const;
+template result<promise<io::access::ro, types::Float>> file<io::access::rw>::exodus_file::get_global_variable_values<types::Float>(MPI_Offset) const;
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<promise<io::access::ro, _Type>>
+file<_Access>::exodus_file::get_time_values() const
+{
+    if (!_file) return { error_code::NullFile };
+
+    const auto steps = _file->get_dimension("time_step");
+    if (!steps) return { steps.error() };
+
+    auto promise = _file->template get_variable_values<_Type>("time_whole", { 0 }, { steps->length });
+    if (!promise) return { promise.error() };
+    return { std::move(promise) };
+}
+template result<promise<io::access::ro, types::Double>> file<io::access::ro>::exodus_file::get_time_values<types::Double>() const;
+template result<promise<io::access::ro, types::Float>> file<io::access::ro>::exodus_file::get_time_values<types::Float>() const;
+template result<promise<io::access::ro, types::Double>> file<io::access::rw>::exodus_file::get_time_values<types::Double>() const;
+template result<promise<io::access::ro, types::Float>> file<io::access::rw>::exodus_file::get_time_values<types::Float>() const;
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<std::vector<promise<io::access::wo, _Type>>>
+file<_Access>::exodus_file::write_nodal_variable_values(MPI_Comm comm, int variable, MPI_Offset time_step, const std::vector<typename _Type::integral_type>& values)
+{
+    if (!_file) return { error_code::NullFile };
+    if (variable < 1) return { error_code::VariableDoesntExist };
+
+    const auto cdf_vars = _file->variable_names();
+    if (!cdf_vars) return { cdf_vars.error() };
+
+    const auto ranges = share(comm, { (MPI_Offset)values.size() });
+    if (!ranges) return { ranges.error() };
+
+    std::vector<promise<io::access::wo, _Type>> promises;
+    for (const auto& range : *ranges)
+    {
+        const auto [first, count] = std::pair(range.offsets[0], range.counts[0]);
+        auto promise = nodal_variable(*cdf_vars, variable, time_step, first, [&](const std::string& name, const std::vector<MPI_Offset>& start, bool combined)
+        {
+            return _file->template write_variable<_Type>(name, values.data() + first, count, start, (combined ? std::vector<MPI_Offset>{ 1, 1, count } : std::vector<MPI_Offset>{ 1, count }));
+        });
+        if (!promise) return { promise.error() };
+        promises.push_back(std::move(promise));
+    }
+
+    return { std::move(promises) };
+}
+template result<std::vector<promise<io::access::wo, types::Double>>> file<io::access::wo>::exodus_file::write_nodal_variable_values<types::Double>(MPI_Comm, int, MPI_Offset, const std::vector<double>&);
+template result<std::vector<promise<io::access::wo, types::Float>>> file<io::access::wo>::exodus_file::write_nodal_variable_values<types::Float>(MPI_Comm, int, MPI_Offset, const std::vector<float>&);
+template result<std::vector<promise<io::access::wo, types::Double>>> file<io::access::rw>::exodus_file::write_nodal_variable_values<types::Double>(MPI_Comm, int, MPI_Offset, const std::vector<double>&);
+template result<std::vector<promise<io::access::wo, types::Float>>> file<io::access::rw>::exodus_file::write_nodal_variable_values<types::Float>(MPI_Comm, int, MPI_Offset, const std::vector<float>&);
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<std::vector<promise<io::access::wo, _Type>>>
+file<_Access>::exodus_file::write_global_variable_values(MPI_Comm comm, MPI_Offset time_step, const std::vector<typename _Type::integral_type>& values)
+{
+    if (!_file) return { error_code::NullFile };
+
+    // Changing data mode is collective, so every process does it even though only the first one writes
+    {
+        PIO_STATS_TIME(independent);
+        NET_CHECK(_file->storage().begin_indep_data(_file->handle));
+    }
+
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    std::vector<promise<io::access::wo, _Type>> promises;
+    if (rank || values.empty()) return { std::move(promises) };
+
+    auto promise = _file->template write_variable<_Type>("vals_glo_var", values.data(), values.size(), { time_step, 0 }, { 1, (MPI_Offset)values.size() });
+    if (!promise) return { promise.error() };
+    promises.push_back(std::move(promise));
+    return { std::move(promises) };
+}
+template result<std::vector<promise<io::access::wo, types::Double>>> file<io::access::wo>::exodus_file::write_global_variable_values<types::Double>(MPI_Comm, MPI_Offset, const std::vector<double>&);
+template result<std::vector<promise<io::access::wo, types::Float>>> file<io::access::wo>::exodus_file::write_global_variable_values<types::Float>(MPI_Comm, MPI_Offset, const std::vector<float>&);
+template result<std::vector<promise<io::access::wo, types::Double>>> file<io::access::rw>::exodus_file::write_global_variable_values<types::Double>(MPI_Comm, MPI_Offset, const std::vector<double>&);
+template result<std::vector<promise<io::access::wo, types::Float>>> file<io::access::rw>::exodus_file::write_global_variable_values<types::Float>(MPI_Comm, MPI_Offset, const std::vector<float>&);
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<std::vector<promise<io::access::wo, _Type>>>
+file<_Access>::exodus_file::write_time_value(MPI_Comm comm, MPI_Offset time_step, const typename _Type::integral_type& value)
 {
     if (!_file) return { error_code::NullFile };
-    const auto info = _file->get_dimension_lengths();
-    if (!info) return { info.error() };
 
-    const auto str_len_name = [&]() -> std::string
+    // Changing data mode is collective, so every process does it even though only the first one writes
     {
-        if (info->count("len_name")) return "len_name";
-        if (info->count("len_string")) return "len_string";
-        return "";
-    }();
+        PIO_STATS_TIME(independent);
+        NET_CHECK(_file->storage().begin_indep_data(_file->handle));
+    }
 
-    if (!info->count("num_dim") || !str_len_name.size()) return { error_code::DimensionDoesntExist };
-    
-    // get dimension of file
-    const auto& dim = info->at("num_dim");
-    const auto& len_name = info->at(str_len_name);
+    int rank;
+    MPI_Comm_rank(comm, &rank);
 
-    // read in coor_names
-    const auto promise = _file->get_variable_values<types::Char>("coor_names", { 0, 0 }, { dim, len_name });
+    std::vector<promise<io::access::wo, _Type>> promises;
+    if (rank) return { std::move(promises) };
+
+    auto promise = _file->template write_variable<_Type>("time_whole", &value, 1, { time_step }, { 1 });
     if (!promise) return { promise.error() };
-    promise.wait();
-    const auto names = format(promise.template get_data<0>(), dim, len_name);
+    promises.push_back(std::move(promise));
+    return { std::move(promises) };
+}
+template result<std::vector<promise<io::access::wo, types::Double>>> file<io::access::wo>::exodus_file::write_time_value<types::Double>(MPI_Comm, MPI_Offset, const double&);
+template result<std::vector<promise<io::access::wo, types::Float>>> file<io::access::wo>::exodus_file::write_time_value<types::Float>(MPI_Comm, MPI_Offset, const float&);
+template result<std::vector<promise<io::access::wo, types::Double>>> file<io::access::rw>::exodus_file::write_time_value<types::Double>(MPI_Comm, MPI_Offset, const double&);
+template result<std::vector<promise<io::access::wo, types::Float>>> file<io::access::rw>::exodus_file::write_time_value<types::Float>(MPI_Comm, MPI_Offset, const float&);
 
-    coord_values values;
-    for (const auto& name : names) values[name];
+/// Pack names into the rows of a (names, length) text variable
+static std::vector<char> pack_names(const std::vector<std::string>& names, MPI_Offset length)
+{
+    std::vector<char> packed(names.size() * length, '\0');
+    for (uint32_t i = 0; i < names.size(); i++)
+        std::copy_n(names[i].begin(), std::min<std::size_t>(names[i].size(), length - 1), packed.begin() + i * length);
+    return packed;
+}
 
-    if (!get_data) return { std::move(values) };
+#define RES_CHECK(res) { const auto r = res; if (!r) return { r.error() }; }
 
-    // check cdf variables for coord (if it's the old format)
-    const auto cdf_vars = _file->variable_names();
-    if (!cdf_vars) return { cdf_vars.error() };
-    const auto it = std::find(cdf_vars->begin(), cdf_vars->end(), "coord");
-    const bool old = (it != cdf_vars->end());
+template<io::access _Access>
+template<typename>
+result<void>
+file<_Access>::exodus_file::define(MPI_Comm comm, const exodus_schema& schema)
+{
+    if (!_file) return { error_code::NullFile };
 
-    if (!info->count("num_nodes")) return { error_code::DimensionDoesntExist };
-    const auto& num_nodes = info->at("num_nodes");
+    // Names are 32 characters long, plus the terminator
+    constexpr MPI_Offset len_name = 33, len_line = 81;
 
-    if (old)
+    auto& f = *_file;
+    const auto& blocks = schema.blocks;
+    const auto& vars   = schema.element_variables;
+    const auto n = [](std::size_t i) { return std::to_string(i + 1); };
+
+    const MPI_Offset num_elem = std::accumulate(blocks.begin(), blocks.end(), MPI_Offset(0), [](MPI_Offset a, const element_block& b) { return a + b.elements; });
+
+    const auto define_real = [&](const std::string& name, const std::vector<std::string>& dims)
     {
-        // read from variable called coord and split data up        
-        const auto value_promise = _file->get_variable_values<types::Double>("coord", { 0, 0 }, { dim, num_nodes });
-        if (!value_promise) return { value_promise.error() };
-        
-        value_promise.wait();
-        const auto data = value_promise.template get_data<0>();
+        return (schema.double_precision ?
+            f.template define_variable<types::Double>(name, dims) :
+            f.template define_variable<types::Float>(name, dims));
+    };
 
-        for (uint32_t i = 0; i < names.size(); i++)
-            std::copy(data.begin() + i * num_nodes, data.begin() + (i + 1) * num_nodes, std::back_inserter(values.at(names[i])));
-    }
-    else
+    // Ids and connectivity, the integers libexodus widens in a 64-bit database
+    const auto define_int = [&](const std::string& name, const std::vector<std::string>& dims)
     {
-        // need to make sure they exist
-        for (const auto& name : names)
+        return (schema.int64 ?
+            f.template define_variable<types::Int64>(name, dims) :
+            f.template define_variable<types::Int>(name, dims));
+    };
+
+    const auto res = f.define([&]() -> result<void>
+    {
+        // Global attributes libexodus checks when opening the file
+        RES_CHECK(f.template define_attribute<types::Float>("", "api_version", { 8.03f }));
+        RES_CHECK(f.template define_attribute<types::Float>("", "version", { 2.0f }));
+        RES_CHECK(f.template define_attribute<types::Int>("", "floating_point_word_size", { (schema.double_precision ? 8 : 4) }));
+        RES_CHECK(f.template define_attribute<types::Int>("", "file_size", { 1 }));
+        RES_CHECK(f.template define_attribute<types::Int>("", "maximum_name_length", { (int)len_name - 1 }));
+        RES_CHECK(f.template define_attribute<types::Int>("", "int64_status", { (schema.int64 ? EX_ALL_INT64_DB : 0) }));
+        RES_CHECK(f.define_attribute_text("", "title", schema.title));
+
+        // A zero length would make a dimension unlimited, so empty entities are left out entirely
+        RES_CHECK(f.define_dimension("len_string", len_name));
+        RES_CHECK(f.define_dimension("len_line", len_line));
+        RES_CHECK(f.define_dimension("four", 4));
+        RES_CHECK(f.define_dimension("len_name", len_name));
+        RES_CHECK(f.define_dimension("time_step", NC_UNLIMITED));
+        if (!schema.coordinates.empty())
         {
-            if (std::find(cdf_vars->begin(), cdf_vars->end(), "coord" + name) == cdf_vars->end())
-                return { error_code::VariableDoesntExist };
+            RES_CHECK(f.define_dimension("num_dim", schema.coordinates.size()));
+            RES_CHECK(f.template define_variable<types::Char>("coor_names", { "num_dim", "len_name" }));
+        }
 
-            const auto value_promise = _file->get_variable_values<types::Double>("coord" + name, { 0 }, { num_nodes });
-            if (!value_promise) return { value_promise.error() };
-            
-            value_promise.wait();
-            const auto data = value_promise.template get_data<0>();
+        RES_CHECK(define_real("time_whole", { "time_step" }));
+
+        if (schema.num_nodes)
+        {
+            RES_CHECK(f.define_dimension("num_nodes", schema.num_nodes));
+            for (const auto& name : schema.coordinates)
+                RES_CHECK(define_real("coord" + name, { "num_nodes" }));
+        }
+
+        if (num_elem) RES_CHECK(f.define_dimension("num_elem", num_elem));
+
+        if (!blocks.empty())
+        {
+            RES_CHECK(f.define_dimension("num_el_blk", blocks.size()));
+            RES_CHECK(f.template define_variable<types::Int>("eb_status", { "num_el_blk" }));
+            RES_CHECK(define_int("eb_prop1", { "num_el_blk" }));
+            RES_CHECK(f.define_attribute_text("eb_prop1", "name", "ID"));
+            RES_CHECK(f.template define_variable<types::Char>("eb_names", { "num_el_blk", "len_name" }));
+        }
+
+        for (uint32_t i = 0; i < blocks.size(); i++)
+        {
+            const auto& block = blocks[i];
+            if (!block.elements) continue;
+
+            RES_CHECK(f.define_dimension("num_el_in_blk"  + n(i), block.elements));
+            RES_CHECK(f.define_dimension("num_nod_per_el" + n(i), block.nodes_per_elem));
+
+            if (polyhedra(block.type))
+            {
+                RES_CHECK(define_int("connect"  + n(i), { "num_nod_per_el" + n(i) }));
+                RES_CHECK(define_int("ebepecnt" + n(i), { "num_el_in_blk"  + n(i) }));
+                RES_CHECK(f.define_attribute_text("ebepecnt" + n(i), "entity_type1", "NODE"));
+                RES_CHECK(f.define_attribute_text("ebepecnt" + n(i), "entity_type2", "ELEM"));
+            }
+            else
+                RES_CHECK(define_int("connect" + n(i), { "num_el_in_blk" + n(i), "num_nod_per_el" + n(i) }));
+
+            RES_CHECK(f.define_attribute_text("connect" + n(i), "elem_type", block.type));
+        }
+
+        if (!schema.nodal_variables.empty())
+        {
+            RES_CHECK(f.define_dimension("num_nod_var", schema.nodal_variables.size()));
+            RES_CHECK(f.template define_variable<types::Char>("name_nod_var", { "num_nod_var", "len_name" }));
+            for (uint32_t v = 0; v < schema.nodal_variables.size() && schema.num_nodes; v++)
+                RES_CHECK(define_real("vals_nod_var" + n(v), { "time_step", "num_nodes" }));
+        }
+
+        if (!schema.global_variables.empty())
+        {
+            RES_CHECK(f.define_dimension("num_glo_var", schema.global_variables.size()));
+            RES_CHECK(f.template define_variable<types::Char>("name_glo_var", { "num_glo_var", "len_name" }));
+            RES_CHECK(define_real("vals_glo_var", { "time_step", "num_glo_var" }));
+        }
 
-            std::copy(data.begin(), data.end(), std::back_inserter(values.at(name)));
+        if (!vars.empty())
+        {
+            RES_CHECK(f.define_dimension("num_elem_var", vars.size()));
+            RES_CHECK(f.template define_variable<types::Char>("name_elem_var", { "num_elem_var", "len_name" }));
+            if (!blocks.empty()) RES_CHECK(f.template define_variable<types::Int>("elem_var_tab", { "num_el_blk", "num_elem_var" }));
+
+            for (uint32_t v = 0; v < vars.size(); v++)
+                for (uint32_t i = 0; i < blocks.size(); i++)
+                    if (blocks[i].elements)
+                        RES_CHECK(define_real("vals_elem_var" + n(v) + "eb" + n(i), { "time_step", "num_el_in_blk" + n(i) }));
         }
+
+        return { };
+    });
+    if (!res) return { res.error() };
+
+    // The metadata is tiny, so one process writes all of it. Entering independent mode is collective though, so
+    // every process does that first
+    {
+        PIO_STATS_TIME(independent);
+        NET_CHECK(f.storage().begin_indep_data(f.handle));
     }
 
-    return { std::move(values) };
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    if (rank) return { };
+
+    std::vector<long long> ids;
+    std::vector<int> status;
+    std::vector<std::string> block_names;
+    for (const auto& block : blocks)
+    {
+        ids.push_back(block.id);
+        status.push_back(block.elements ? 1 : 0);
+        block_names.push_back(block.name);
+    }
+
+    std::vector<int> truth;
+    for (const auto& block : blocks)
+        for (uint32_t v = 0; v < vars.size(); v++)
+            truth.push_back(block.elements ? 1 : 0);
+
+    const auto write_int = [&](const std::string& name, const auto& values, const std::vector<MPI_Offset>& count) -> result<void>
+    {
+        using _Type = std::conditional_t<std::is_same_v<typename std::decay_t<decltype(values)>::value_type, int>, types::Int, types::Int64>;
+        if (values.empty()) return { };
+        const auto p = f.template write_variable<_Type>(name, values.data(), values.size(), std::vector<MPI_Offset>(count.size(), 0), count);
+        if (!p) return { p.error() };
+        p.wait();
+        return { };
+    };
+
+    const auto write_names = [&](const std::string& name, const std::vector<std::string>& names) -> result<void>
+    {
+        if (names.empty()) return { };
+        const auto packed = pack_names(names, len_name);
+        const auto p = f.template write_variable<types::Char>(name, packed.data(), packed.size(), { 0, 0 }, { (MPI_Offset)names.size(), len_name });
+        if (!p) return { p.error() };
+        p.wait();
+        return { };
+    };
+
+    RES_CHECK(write_int("eb_prop1", ids, { (MPI_Offset)blocks.size() }));
+    RES_CHECK(write_int("eb_status", status, { (MPI_Offset)blocks.size() }));
+    RES_CHECK(write_int("elem_var_tab", truth, { (MPI_Offset)blocks.size(), (MPI_Offset)vars.size() }));
+    RES_CHECK(write_names("eb_names", block_names));
+    RES_CHECK(write_names("coor_names", schema.coordinates));
+    RES_CHECK(write_names("name_elem_var", vars));
+    RES_CHECK(write_names("name_nod_var", schema.nodal_variables));
+    RES_CHECK(write_names("name_glo_var", schema.global_variables));
+    return { };
 }
-FWD_DEC_READ(result<coord_values>, exodus_file::get_node_coordinates, bool);
+FWD_DEC_WRITE(result<void>, exodus_file::define, MPI_Comm, const exodus_schema&);
+
+#undef RES_CHECK
 
-using P = promise<io::access::wo, types::Double>;
 template<io::access _Access>
-template<typename>
-result<std::vector<std::shared_ptr<const P>>>
-file<_Access>::exodus_file::write_node_coordinates(
-    MPI_Comm comm, 
-    const coord_values& data)
+template<typename _Type>
+result<std::vector<promise<io::access::wo, _Type>>>
+file<_Access>::exodus_file::_write_connectivity(
+    MPI_Comm comm,
+    const std::vector<element_block>& blocks,
+    const std::vector<std::vector<typename _Type::integral_type>>& connectivity,
+    const std::vector<std::vector<typename _Type::integral_type>>& entity_counts)
 {
+    using value_type = typename _Type::integral_type;
+
     if (!_file) return { error_code::NullFile };
+    if (connectivity.size() != blocks.size()) return { error_code::SizeMismatch };
 
-    // the list needs to be the same for all processes, so we need to sort to
-    // get over the "unordered" part of the map
-    const auto names = [&]()
-    { 
-        std::vector<std::string> r;
-        r.reserve(data.size());
-        for (const auto& p : data) r.push_back(p.first);
-        std::sort(r.begin(), r.end());
-        return r;
-    }();
-    
-    io::distributor dist(comm);
-    for (uint32_t i = 0; i < names.size(); i++)
-    {
-        io::distributor::volume volume{0};
-        volume.data_index = i;
-        volume.data_type = NC_DOUBLE;
-        volume.dimensions.push_back(data.at(names[i]).size());
-        dist.data_volumes.push_back(volume);
-    }
+    std::vector<MPI_Offset> elements;
+    for (const auto& block : blocks) elements.push_back(block.elements);
 
-    const auto subvols = dist.get_tasks();
-    if (!subvols) return { error_code::FailedTaskCreation };
+    const auto ranges = share(comm, elements);
+    if (!ranges) return { ranges.error() };
 
-    std::vector<std::shared_ptr<const P>> promises;
-    for (const auto& subvol : *subvols)
+    // The variables may be stored with another width, PnetCDF converts and fails a request whose values don't fit
+    std::vector<promise<io::access::wo, _Type>> promises;
+    const auto post = [&](const std::string& name, const value_type* data, MPI_Offset size, const std::vector<MPI_Offset>& offset, const std::vector<MPI_Offset>& count)
     {
-        const auto& coord_name = names[dist.data_volumes[subvol.volume_index].data_index];
-        const auto& coords = data.at(coord_name);
+        promises.push_back(_file->template write_variable<_Type>(name, data, size, offset, count));
+        return promises.back().good();
+    };
 
-        const auto promise = _file->write_variable<types::Double>("coord" + coord_name, &coords[0] + subvol.offsets[0], subvol.counts[0], subvol.offsets, subvol.counts);
-        promises.push_back(std::make_shared<const P>(promise));
+    for (const auto& range : *ranges)
+    {
+        const auto  i     = range.volume_index;
+        const auto& block = blocks[i];
+        const auto& conn  = connectivity[i];
+        const auto  n     = std::to_string(i + 1);
+        const auto [first, count] = std::pair(range.offsets[0], range.counts[0]);
+
+        if (polyhedra(block.type))
+        {
+            // The elements of this process start after however many nodes the elements before them have
+            if (entity_counts.size() <= i || entity_counts[i].size() != (std::size_t)block.elements) return { error_code::SizeMismatch };
+            const auto& counts = entity_counts[i];
+            const MPI_Offset node_first = std::accumulate(counts.begin(), counts.begin() + first, MPI_Offset(0));
+            const MPI_Offset node_count = std::accumulate(counts.begin() + first, counts.begin() + first + count, MPI_Offset(0));
+            if ((std::size_t)(node_first + node_count) > conn.size()) return { error_code::SizeMismatch };
+
+            if (!post("connect"  + n, conn.data() + node_first, node_count, { node_first }, { node_count })) return { promises.back().error() };
+            if (!post("ebepecnt" + n, counts.data() + first, count, { first }, { count })) return { promises.back().error() };
+        }
+        else
+        {
+            if (conn.size() != (std::size_t)(block.elements * block.nodes_per_elem)) return { error_code::SizeMismatch };
+            if (!post("connect" + n, conn.data() + first * block.nodes_per_elem, count * block.nodes_per_elem, { first, 0 }, { count, block.nodes_per_elem }))
+                return { promises.back().error() };
+        }
     }
 
     return { std::move(promises) };
 }
-FWD_DEC_WRITE(result<std::vector<std::shared_ptr<const P>>>, exodus_file::write_node_coordinates, MPI_Comm, const coord_values&);
+
+template<io::access _Access>
+template<typename>
+result<std::vector<promise<io::access::wo, types::Int>>>
+file<_Access>::exodus_file::write_block_connectivity(
+    MPI_Comm comm,
+    const std::vector<element_block>& blocks,
+    const std::vector<std::vector<int>>& connectivity,
+    const std::vector<std::vector<int>>& entity_counts)
+{
+    return _write_connectivity<types::Int>(comm, blocks, connectivity, entity_counts);
+}
+template result<std::vector<promise<io::access::wo, types::Int>>> file<io::access::wo>::exodus_file::write_block_connectivity(MPI_Comm, const std::vector<element_block>&, const std::vector<std::vector<int>>&, const std::vector<std::vector<int>>&);
+template result<std::vector<promise<io::access::wo, types::Int>>> file<io::access::rw>::exodus_file::write_block_connectivity(MPI_Comm, const std::vector<element_block>&, const std::vector<std::vector<int>>&, const std::vector<std::vector<int>>&);
+
+template<io::access _Access>
+template<typename>
+result<std::vector<promise<io::access::wo, types::Int64>>>
+file<_Access>::exodus_file::write_block_connectivity(
+    MPI_Comm comm,
+    const std::vector<element_block>& blocks,
+    const std::vector<std::vector<long long>>& connectivity,
+    const std::vector<std::vector<long long>>& entity_counts)
+{
+    return _write_connectivity<types::Int64>(comm, blocks, connectivity, entity_counts);
+}
+template result<std::vector<promise<io::access::wo, types::Int64>>> file<io::access::wo>::exodus_file::write_block_connectivity(MPI_Comm, const std::vector<element_block>&, const std::vector<std::vector<long long>>&, const std::vector<std::vector<long long>>&);
+template result<std::vector<promise<io::access::wo, types::Int64>>> file<io::access::rw>::exodus_file::write_block_connectivity(MPI_Comm, const std::vector<element_block>&, const std::vector<std::vector<long long>>&, const std::vector<std::vector<long long>>&);
 
 /* NETCDF FILE IMPLEMENTATION */
 
+/// Build the MPI hints that turn on PnetCDF's burst-buffer driver
+static MPI_Info staging_info(const staging& stage)
+{
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "nc_burst_buf", "enable");
+    MPI_Info_set(info, "nc_burst_buf_dirname", stage.directory.c_str());
+    MPI_Info_set(info, "nc_burst_buf_del_on_close", (stage.delete_on_close ? "enable" : "disable"));
+    MPI_Info_set(info, "nc_burst_buf_shared_logs", (stage.shared_logs ? "enable" : "disable"));
+    if (stage.flush_size)
+        MPI_Info_set(info, "nc_burst_buf_flush_buffer_size", std::to_string(*stage.flush_size).c_str());
+    return info;
+}
+
+template<io::access _Access>
+file<_Access>::file(const std::string& filename, const staging& stage, file_format fmt) :
+    file(io::pnetcdf_backend::instance(), filename, stage, fmt)
+{   }
+
 template<io::access _Access>
-file<_Access>::file(const std::string& filename) :
-    exodus(this)
+file<_Access>::file(io::backend& storage, const std::string& filename, const staging& stage, file_format fmt) :
+    exodus(this),
+    _backend(&storage),
+    _staged(io::write_access(_Access) && stage.enabled)
 {
+    MPI_Info info = (_staged ? staging_info(stage) : MPI_INFO_NULL);
+
     if constexpr (_Access == io::access::ro)
     {
-        err = ncmpi_open(
+        err = _backend->open(
             MPI_COMM_WORLD, 
             filename.c_str(),
             NC_NOWRITE,
-            MPI_INFO_NULL,
+            info,
             &handle
         );
     }
 
     if constexpr (_Access == io::access::wo || _Access == io::access::rw)
     {
-        err = ncmpi_create(
+        const int cdf = (fmt == file_format::cdf5 ? NC_64BIT_DATA : NC_64BIT_OFFSET);
+        err = _backend->create(
             MPI_COMM_WORLD, 
             filename.c_str(),
-            (_Access == io::access::rw ? NC_NOCLOBBER : NC_CLOBBER) | NC_WRITE | NC_64BIT_OFFSET,
-            MPI_INFO_NULL,
+            (_Access == io::access::rw ? NC_NOCLOBBER : NC_CLOBBER) | NC_WRITE | cdf,
+            info,
             &handle
         );
 
         if (err == -35) // file exists (should only happen in rw)
         {
-            err = ncmpi_open(
+            err = _backend->open(
                 MPI_COMM_WORLD, 
                 filename.c_str(),
                 NC_NOCLOBBER | NC_WRITE | NC_64BIT_OFFSET,
-                MPI_INFO_NULL,
+                info,
                 &handle
             );
         }
     }
 
+    if (info != MPI_INFO_NULL) MPI_Info_free(&info);
+
     if (err != NC_NOERR) _good = false;
     else _good = true;
 }
@@ -273,7 +1472,7 @@ file<_Access>::~file()
 
 template<io::access _Access>
 void file<_Access>::close() 
-{ if (_good) err = ncmpi_close(handle); }
+{ if (_good) err = _backend->close(handle); }
 
 #pragma region READ
 
@@ -290,7 +1489,7 @@ file<_Access>::variable_names() const
     {
         char buffer[MAX_STR_LENGTH];
         memset(buffer, 0, MAX_STR_LENGTH);
-        ncmpi_inq_varname(handle, i, buffer);
+        _backend->inq_varname(handle, i, buffer);
         for (uint32_t j = 0; j < MAX_STR_LENGTH; j++)
             if (buffer[j]) ret[i] += buffer[j];
     }
@@ -307,20 +1506,20 @@ file<_Access>::get_variable_info(const std::string& name) const
     if (!inq.good()) return { inq.error() };
 
     int index = -1;
-    auto err = ncmpi_inq_varid(handle, name.c_str(), &index);
+    auto err = _backend->inq_varid(handle, name.c_str(), &index);
     if (err != NC_NOERR || index < 0) return { netcdf_error(err) };
 
     int dimensions = 0;
     variable var{0};
     var.index = index;
-    err = ncmpi_inq_varndims(handle, index, &dimensions);
+    err = _backend->inq_varndims(handle, index, &dimensions);
     if (err != NC_NOERR) return { netcdf_error(err) };
 
     std::vector<int> dim_ids(dimensions);
     var.dimensions.resize(dimensions);
 
     char var_name[MAX_STR_LENGTH];
-    err = ncmpi_inq_var(
+    err = _backend->inq_var(
         handle, 
         index, 
         var_name, 
@@ -338,6 +1537,26 @@ file<_Access>::get_variable_info(const std::string& name) const
 }
 FWD_DEC_READ(result<variable>, get_variable_info, const std::string&);
 
+template<io::access _Access>
+template<typename>
+result<std::string>
+file<_Access>::get_attribute_text(const std::string& variable, const std::string& name) const
+{
+    int index = NC_GLOBAL;
+    if (!variable.empty()) NET_CHECK(_backend->inq_varid(handle, variable.c_str(), &index));
+
+    MPI_Offset length = 0;
+    NET_CHECK(_backend->inq_attlen(handle, index, name.c_str(), &length));
+
+    std::string text(length, '\0');
+    NET_CHECK(_backend->get_att_text(handle, index, name.c_str(), text.data()));
+
+    // Attributes are often written with their terminating null
+    text.erase(std::find(text.begin(), text.end(), '\0'), text.end());
+    return { std::move(text) };
+}
+FWD_DEC_READ(result<std::string>, get_attribute_text, const std::string&, const std::string&);
+
 template<io::access _Access>
 template<typename>
 result<value_info>
@@ -387,7 +1606,7 @@ file<_Access>::get_dimension_lengths() const
         char name[MAX_NAME_LENGTH];
         memset(name, 0, MAX_NAME_LENGTH);
         MPI_Offset offset = 0;
-        auto err = ncmpi_inq_dim(handle, i, name, &offset);
+        auto err = _backend->inq_dim(handle, i, name, &offset);
         if (err != NC_NOERR) return { err };
 
         map.insert(std::pair(std::string(name), offset));
@@ -403,7 +1622,7 @@ file<_Access>::inquire() const
 {
     info i;
     int unlimited;
-    int error = ncmpi_inq(handle, &i.dimensions, &i.variables, &i.attributes, &unlimited);
+    int error = _backend->inq(handle, &i.dimensions, &i.variables, &i.attributes, &unlimited);
 
     if (error != NC_NOERR) return { netcdf_error(error) };
     
@@ -419,57 +1638,109 @@ file<_Access>::read_variable_sync(
     const std::vector<MPI_Offset>& start,
     const std::vector<MPI_Offset>& count) const
 {
-    const auto promise  = get_variable_values<_Type>(name, start, count);
+    auto promise = get_variable_values<_Type>(name, start, count);
     if (!promise.good()) return { promise.error() };
     const auto statuses = promise.wait();
-    return { promise.template get_data<0>() };
+    return { promise.template take<0>() };
 }
 FWD_DEC_READ(result<std::vector<int>>, read_variable_sync<types::Int>, const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+FWD_DEC_READ(result<std::vector<long long>>, read_variable_sync<types::Int64>, const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
 FWD_DEC_READ(result<std::vector<float>>, read_variable_sync<types::Float>, const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
 FWD_DEC_READ(result<std::vector<double>>, read_variable_sync<types::Double>, const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
 FWD_DEC_READ(result<std::vector<char>>, read_variable_sync<types::Char>, const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
 
 template<io::access _Access>
 template<typename _Type, typename>
-const promise<io::access::ro, _Type>
+promise<io::access::ro, _Type>
 file<_Access>::get_variable_values(
     const std::string& name, 
     const std::vector<MPI_Offset>& start,
     const std::vector<MPI_Offset>& count) const
 {
-    const auto info = get_variable_value_info(name);
+    const auto info = [&]() { PIO_STATS_TIME(metadata); return get_variable_value_info(name); }();
     if (!info) return { info.error() };
-    if (info.value().type != _Type::nc) return { error_code::TypeMismatch };
+    // PnetCDF converts from the stored type into the one requested
+    if (!io::convertible(info.value().type, _Type::nc)) return { error_code::TypeMismatch };
+
+    return _post_read<_Type>(info.value().index, name, start, count);
+}
+// Need to utilize the macro here (how to deal with that comma...)
+template promise<io::access::ro, types::Double> file<io::access::ro>::get_variable_values<types::Double>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Float> file<io::access::ro>::get_variable_values<types::Float>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Int> file<io::access::ro>::get_variable_values<types::Int>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Int64> file<io::access::ro>::get_variable_values<types::Int64>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Char> file<io::access::ro>::get_variable_values<types::Char>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+
+template promise<io::access::ro, types::Double> file<io::access::rw>::get_variable_values<types::Double>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Float> file<io::access::rw>::get_variable_values<types::Float>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Int> file<io::access::rw>::get_variable_values<types::Int>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Int64> file<io::access::rw>::get_variable_values<types::Int64>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Char> file<io::access::rw>::get_variable_values<types::Char>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+
+/// Check a section against the shape of a variable, the record dimension may have grown since it was opened
+static std::optional<error_code> check_section(const variable_handle& variable, const std::vector<MPI_Offset>& start, const std::vector<MPI_Offset>& count)
+{
+    if (variable.id < 0) return error_code::VariableDoesntExist;
+    if (start.size() != variable.shape.size() || count.size() != start.size()) return error_code::DimensionSizeMismatch;
+    for (std::size_t i = 0; i < start.size(); i++)
+        if (start[i] < 0 || count[i] < 0 || ((int)i != variable.record && start[i] + count[i] > variable.shape[i])) return error_code::IndexOutOfBounds;
+    return std::nullopt;
+}
+
+template<io::access _Access>
+template<typename _Type, typename>
+promise<io::access::ro, _Type>
+file<_Access>::get_variable_values(
+    const variable_handle& variable,
+    const std::vector<MPI_Offset>& start,
+    const std::vector<MPI_Offset>& count) const
+{
+    if (!io::convertible(variable.type, _Type::nc)) return { error_code::TypeMismatch };
+    if (const auto err = check_section(variable, start, count)) return { *err };
+    return _post_read<_Type>(variable.id, variable.name, start, count);
+}
+template promise<io::access::ro, types::Double> file<io::access::ro>::get_variable_values<types::Double>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Float> file<io::access::ro>::get_variable_values<types::Float>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Int> file<io::access::ro>::get_variable_values<types::Int>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Int64> file<io::access::ro>::get_variable_values<types::Int64>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Char> file<io::access::ro>::get_variable_values<types::Char>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+
+template promise<io::access::ro, types::Double> file<io::access::rw>::get_variable_values<types::Double>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Float> file<io::access::rw>::get_variable_values<types::Float>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Int> file<io::access::rw>::get_variable_values<types::Int>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Int64> file<io::access::rw>::get_variable_values<types::Int64>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
+template promise<io::access::ro, types::Char> file<io::access::rw>::get_variable_values<types::Char>(const variable_handle&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
 
-    const std::size_t size = std::accumulate(count.begin(), count.end(), 1, std::multiplies<size_t>());
+template<io::access _Access>
+template<typename _Type>
+promise<io::access::ro, _Type>
+file<_Access>::_post_read(int id, const std::string& name, const std::vector<MPI_Offset>& start, const std::vector<MPI_Offset>& count) const
+{
+    const std::size_t size = std::accumulate(count.begin(), count.end(), std::size_t(1), std::multiplies<std::size_t>());
 
-    promise<io::access::ro, _Type> promise(handle, { size });
+    promise<io::access::ro, _Type> promise(*_backend, handle, { size });
+    promise.template set_extent<0>(start, count);
+    PIO_TRACE_SCOPE("get_variable_values", name, size * sizeof(typename _Type::integral_type), promise.request_id());
     
-    auto err = ncmpi_begin_indep_data(get_handle());
+    auto err = [&]() { PIO_STATS_TIME(independent); return _backend->begin_indep_data(handle); }();
     if (err != NC_NOERR) return { netcdf_error(err) };
 
-    err = _Type::func(
+    err = _backend->iget_vara(
         handle,
-        info.value().index,
+        id,
         start.data(),
         count.data(),
         promise.template data<0>(),
+        size,
+        _Type::mpi,
         promise.requests()
     );
     if (err != NC_NOERR) return { netcdf_error(err) };
+    PIO_STATS_READ(name, size * sizeof(typename _Type::integral_type));
+    PIO_TRACE_REQUEST_BEGIN(promise.trace_name(), name, size * sizeof(typename _Type::integral_type), promise.request_id());
 
     return promise;
 }
-// Need to utilize the macro here (how to deal with that comma...)
-template const promise<io::access::ro, types::Double> file<io::access::ro>::get_variable_values<types::Double>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
-template const promise<io::access::ro, types::Float> file<io::access::ro>::get_variable_values<types::Float>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
-template const promise<io::access::ro, types::Int> file<io::access::ro>::get_variable_values<types::Int>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
-template const promise<io::access::ro, types::Char> file<io::access::ro>::get_variable_values<types::Char>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
-
-template const promise<io::access::ro, types::Double> file<io::access::rw>::get_variable_values<types::Double>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
-template const promise<io::access::ro, types::Float> file<io::access::rw>::get_variable_values<types::Float>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
-template const promise<io::access::ro, types::Int> file<io::access::rw>::get_variable_values<types::Int>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
-template const promise<io::access::ro, types::Char> file<io::access::rw>::get_variable_values<types::Char>(const std::string&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&) const;
 
 template<io::access _Access>
 template<typename>
@@ -481,7 +1752,7 @@ file<_Access>::get_dimension(int id) const
 
     char _name[MAX_NAME_LENGTH];
     memset(_name, 0, MAX_NAME_LENGTH);
-    const auto err = ncmpi_inq_dim(handle, id, _name, &dim.length);
+    const auto err = _backend->inq_dim(handle, id, _name, &dim.length);
     if (err != NC_NOERR) return { netcdf_error(err) };
 
     for (uint32_t i = 0; i < MAX_NAME_LENGTH; i++)
@@ -496,16 +1767,55 @@ result<dimension>
 file<_Access>::get_dimension(const std::string& name) const
 {
     int id = 0;
-    const auto err = ncmpi_inq_dimid(handle, name.c_str(), &id);
+    const auto err = _backend->inq_dimid(handle, name.c_str(), &id);
     if (err != NC_NOERR) return { netcdf_error(err) };
 
     return get_dimension(id);
 }
 
+template<io::access _Access>
+result<variable_handle>
+file<_Access>::open_variable(const std::string& name) const
+{
+    PIO_STATS_TIME(metadata);
+    variable_handle variable;
+    variable.name = name;
+
+    // Only inquiries that a write-only file can answer too
+    int dimensions, unlimited;
+    NET_CHECK(_backend->inq_varid(handle, name.c_str(), &variable.id));
+    NET_CHECK(_backend->inq_vartype(handle, variable.id, &variable.type));
+    NET_CHECK(_backend->inq_varndims(handle, variable.id, &dimensions));
+    NET_CHECK(_backend->inq_unlimdim(handle, &unlimited));
+
+    std::vector<int> ids(dimensions);
+    NET_CHECK(_backend->inq_vardimid(handle, variable.id, ids.data()));
+
+    variable.shape.resize(dimensions);
+    for (int i = 0; i < dimensions; i++)
+    {
+        NET_CHECK(_backend->inq_dimlen(handle, ids[i], &variable.shape[i]));
+        if (ids[i] == unlimited) variable.record = i;
+    }
+
+    return { std::move(variable) };
+}
+
 #pragma endregion READ
 
 #pragma region WRITE
 
+template<io::access _Access>
+template<typename>
+result<void>
+file<_Access>::define_dimension(const std::string& name, MPI_Offset length)
+{
+    int dim_id;
+    NET_CHECK(_backend->def_dim(handle, name.c_str(), length, &dim_id));
+    return { };
+}
+FWD_DEC_WRITE(result<void>, define_dimension, const std::string&, MPI_Offset);
+
 template<io::access _Access>
 template<typename _Type, typename>
 result<void>
@@ -520,38 +1830,91 @@ file<_Access>::define_variable(const std::string& name, const std::vector<std::s
     }
 
     int var_id;
-    NET_CHECK(ncmpi_def_var(handle, name.c_str(), _Type::nc, dimensions.size(), dimensions.data(), &var_id));
+    NET_CHECK(_backend->def_var(handle, name.c_str(), _Type::nc, dimensions.size(), dimensions.data(), &var_id));
     return { };
 }
 template result<void> file<io::access::wo>::define_variable<types::Double>(const std::string&, const std::vector<std::string>&); // since this uses a getter maybe we only should decalre for r/w
 template result<void> file<io::access::wo>::define_variable<types::Float>(const std::string&, const std::vector<std::string>&);
 template result<void> file<io::access::wo>::define_variable<types::Int>(const std::string&, const std::vector<std::string>&);
+template result<void> file<io::access::wo>::define_variable<types::Int64>(const std::string&, const std::vector<std::string>&);
 template result<void> file<io::access::wo>::define_variable<types::Char>(const std::string&, const std::vector<std::string>&);
 
 template result<void> file<io::access::rw>::define_variable<types::Double>(const std::string&, const std::vector<std::string>&);
 template result<void> file<io::access::rw>::define_variable<types::Float>(const std::string&, const std::vector<std::string>&);
 template result<void> file<io::access::rw>::define_variable<types::Int>(const std::string&, const std::vector<std::string>&);
+template result<void> file<io::access::rw>::define_variable<types::Int64>(const std::string&, const std::vector<std::string>&);
 template result<void> file<io::access::rw>::define_variable<types::Char>(const std::string&, const std::vector<std::string>&);
 
+template<io::access _Access>
+template<typename>
+result<void>
+file<_Access>::define_attribute_text(const std::string& variable, const std::string& name, const std::string& text)
+{
+    int index = NC_GLOBAL;
+    if (!variable.empty()) NET_CHECK(_backend->inq_varid(handle, variable.c_str(), &index));
+    NET_CHECK(_backend->put_att_text(handle, index, name.c_str(), text.size(), text.c_str()));
+    return { };
+}
+FWD_DEC_WRITE(result<void>, define_attribute_text, const std::string&, const std::string&, const std::string&);
+
+template<io::access _Access>
+template<typename _Type, typename>
+result<void>
+file<_Access>::define_attribute(const std::string& variable, const std::string& name, const std::vector<typename _Type::integral_type>& values)
+{
+    int index = NC_GLOBAL;
+    if (!variable.empty()) NET_CHECK(_backend->inq_varid(handle, variable.c_str(), &index));
+    NET_CHECK(_backend->put_att(handle, index, name.c_str(), _Type::nc, values.size(), values.data()));
+    return { };
+}
+template result<void> file<io::access::wo>::define_attribute<types::Double>(const std::string&, const std::string&, const std::vector<double>&);
+template result<void> file<io::access::wo>::define_attribute<types::Float>(const std::string&, const std::string&, const std::vector<float>&);
+template result<void> file<io::access::wo>::define_attribute<types::Int>(const std::string&, const std::string&, const std::vector<int>&);
+template result<void> file<io::access::wo>::define_attribute<types::Int64>(const std::string&, const std::string&, const std::vector<long long>&);
+
+template result<void> file<io::access::rw>::define_attribute<types::Double>(const std::string&, const std::string&, const std::vector<double>&);
+template result<void> file<io::access::rw>::define_attribute<types::Float>(const std::string&, const std::string&, const std::vector<float>&);
+template result<void> file<io::access::rw>::define_attribute<types::Int>(const std::string&, const std::string&, const std::vector<int>&);
+template result<void> file<io::access::rw>::define_attribute<types::Int64>(const std::string&, const std::string&, const std::vector<long long>&);
+
 template<io::access _Access>
 template<typename>
 result<void>
 file<_Access>::define(std::function<result<void>()> function)
 {
-    NET_CHECK(ncmpi_redef(handle));
+    {
+        // A newly created file starts out in define mode
+        PIO_STATS_TIME(define);
+        const auto err = _backend->redef(handle);
+        if (err != NC_NOERR && err != NC_EINDEFINE) return { netcdf_error(err) };
+    }
 
     const auto res = function();
 
-    NET_CHECK(ncmpi_enddef(handle));
+    {
+        PIO_STATS_TIME(define);
+        NET_CHECK(_backend->enddef(handle));
+    }
 
     if (!res) return { res.error() };
     return { };
 }
 FWD_DEC_WRITE(result<void>, define, std::function<result<void>()>);
 
+template<io::access _Access>
+template<typename>
+result<void>
+file<_Access>::flush()
+{
+    if (!_good) return { error_code::NullFile };
+    NET_CHECK(_backend->flush(handle));
+    return { };
+}
+FWD_DEC_WRITE(result<void>, flush);
+
 template<io::access _Access>
 template<typename _Type, typename>
-const promise<io::access::wo, _Type>
+promise<io::access::wo, _Type>
 file<_Access>::write_variable(
     const std::string& name,
     const typename _Type::integral_type* data,
@@ -563,51 +1926,104 @@ file<_Access>::write_variable(
     if (offset.size() != count.size()) return { error_code::DimensionSizeMismatch };
     
     // data_size is equivalent to volume of data
-    const auto product = std::accumulate(count.begin(), count.end(), 1, std::multiplies<size_t>());
+    const auto product = std::accumulate(count.begin(), count.end(), std::size_t(1), std::multiplies<std::size_t>());
     if (size != product) return { error_code::SizeMismatch };
     
-    variable var;
-    if constexpr (_Access == io::access::rw)
+    // Only the id, type and rank are needed, which (unlike get_variable_info) can be asked of a write-only file
+    int index, dimensions;
+    nc_type type;
+    const auto err_info = [&]()
     {
-        const auto info = get_variable_info(name);
-        if (!info) { return { info.error() }; };
-        var = std::move(info.value());
-    }
-    else return { 5 };
+        PIO_STATS_TIME(metadata);
+        if (const auto err = _backend->inq_varid(handle, name.c_str(), &index); err != NC_NOERR) return err;
+        if (const auto err = _backend->inq_vartype(handle, index, &type); err != NC_NOERR) return err;
+        return _backend->inq_varndims(handle, index, &dimensions);
+    }();
+    if (err_info != NC_NOERR) return { netcdf_error(err_info) };
+
+    if (!io::convertible(_Type::nc, type)) return { error_code::TypeMismatch };
+    if ((std::size_t)dimensions != offset.size()) return { error_code::DimensionSizeMismatch };
+
+    return _post_write<_Type>(index, name, data, size, offset, count);
+}
+// Need to utilize the macro here (how to deal with that comma...)
+template promise<io::access::wo, types::Double> file<io::access::wo>::write_variable<types::Double>(const std::string&, const double*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Float> file<io::access::wo>::write_variable<types::Float>(const std::string&, const float*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Int> file<io::access::wo>::write_variable<types::Int>(const std::string&, const int*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Int64> file<io::access::wo>::write_variable<types::Int64>(const std::string&, const long long*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Char> file<io::access::wo>::write_variable<types::Char>(const std::string&, const char*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+
+template promise<io::access::wo, types::Double> file<io::access::rw>::write_variable<types::Double>(const std::string&, const double*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Float> file<io::access::rw>::write_variable<types::Float>(const std::string&, const float*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Int> file<io::access::rw>::write_variable<types::Int>(const std::string&, const int*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Int64> file<io::access::rw>::write_variable<types::Int64>(const std::string&, const long long*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Char> file<io::access::rw>::write_variable<types::Char>(const std::string&, const char*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+
+template<io::access _Access>
+template<typename _Type, typename>
+promise<io::access::wo, _Type>
+file<_Access>::write_variable(
+    const variable_handle& variable,
+    const typename _Type::integral_type* data,
+    const std::size_t& size,
+    const std::vector<MPI_Offset>& offset,
+    const std::vector<MPI_Offset>& count)
+{
+    if (!data || !size) return { error_code::NullData };
+    if (!io::convertible(_Type::nc, variable.type)) return { error_code::TypeMismatch };
+    if (const auto err = check_section(variable, offset, count)) return { *err };
+
+    const auto product = std::accumulate(count.begin(), count.end(), std::size_t(1), std::multiplies<std::size_t>());
+    if (size != product) return { error_code::SizeMismatch };
 
-    if (_Type::nc != var.type) return { error_code::TypeMismatch };
-    if (var.dimensions.size() != offset.size()) return { error_code::DimensionSizeMismatch };
+    return _post_write<_Type>(variable.id, variable.name, data, size, offset, count);
+}
+template promise<io::access::wo, types::Double> file<io::access::wo>::write_variable<types::Double>(const variable_handle&, const double*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Float> file<io::access::wo>::write_variable<types::Float>(const variable_handle&, const float*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Int> file<io::access::wo>::write_variable<types::Int>(const variable_handle&, const int*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Int64> file<io::access::wo>::write_variable<types::Int64>(const variable_handle&, const long long*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Char> file<io::access::wo>::write_variable<types::Char>(const variable_handle&, const char*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+
+template promise<io::access::wo, types::Double> file<io::access::rw>::write_variable<types::Double>(const variable_handle&, const double*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Float> file<io::access::rw>::write_variable<types::Float>(const variable_handle&, const float*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Int> file<io::access::rw>::write_variable<types::Int>(const variable_handle&, const int*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Int64> file<io::access::rw>::write_variable<types::Int64>(const variable_handle&, const long long*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
+template promise<io::access::wo, types::Char> file<io::access::rw>::write_variable<types::Char>(const variable_handle&, const char*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
 
+template<io::access _Access>
+template<typename _Type>
+promise<io::access::wo, _Type>
+file<_Access>::_post_write(
+    int index,
+    const std::string& name,
+    const typename _Type::integral_type* data,
+    std::size_t size,
+    const std::vector<MPI_Offset>& offset,
+    const std::vector<MPI_Offset>& count)
+{
     // need to find clever way to *not* require that counts array for this
     // type of promise
-    promise<io::access::wo, _Type> promise(get_handle(), { 0 });
+    promise<io::access::wo, _Type> promise(*_backend, handle, { 0 });
+    PIO_TRACE_SCOPE("write_variable", name, size * sizeof(typename _Type::integral_type), promise.request_id());
 
-    auto err = ncmpi_begin_indep_data(get_handle());
+    auto err = [&]() { PIO_STATS_TIME(independent); return _backend->begin_indep_data(handle); }();
     if (err != NC_NOERR) return { netcdf_error(err) };
 
-    NET_CHECK(ncmpi_iput_vara(
+    NET_CHECK(_backend->iput_vara(
         handle,
-        var.index,
+        index,
         offset.data(),
         count.data(),
         data,
         size,
-        MPI_DATATYPE_NULL,
+        _Type::mpi, // describing the buffer lets PnetCDF convert into the stored type
         promise.requests()
     ));
+    PIO_STATS_WRITE(name, size * sizeof(typename _Type::integral_type));
+    PIO_TRACE_REQUEST_BEGIN(promise.trace_name(), name, size * sizeof(typename _Type::integral_type), promise.request_id());
 
     return promise;
 }
-// Need to utilize the macro here (how to deal with that comma...)
-template const promise<io::access::wo, types::Double> file<io::access::wo>::write_variable<types::Double>(const std::string&, const double*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
-template const promise<io::access::wo, types::Float> file<io::access::wo>::write_variable<types::Float>(const std::string&, const float*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
-template const promise<io::access::wo, types::Int> file<io::access::wo>::write_variable<types::Int>(const std::string&, const int*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
-template const promise<io::access::wo, types::Char> file<io::access::wo>::write_variable<types::Char>(const std::string&, const char*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
-
-template const promise<io::access::wo, types::Double> file<io::access::rw>::write_variable<types::Double>(const std::string&, const double*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
-template const promise<io::access::wo, types::Float> file<io::access::rw>::write_variable<types::Float>(const std::string&, const float*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
-template const promise<io::access::wo, types::Int> file<io::access::rw>::write_variable<types::Int>(const std::string&, const int*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
-template const promise<io::access::wo, types::Char> file<io::access::rw>::write_variable<types::Char>(const std::string&, const char*, const std::size_t&, const std::vector<MPI_Offset>&, const std::vector<MPI_Offset>&);
 
 #pragma endregion WRITE
 
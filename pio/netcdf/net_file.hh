@@ -21,6 +21,7 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <optional>
 
 /// All of the functionality for handling NetCDF files
 namespace pio::netcdf
@@ -67,6 +68,25 @@ namespace pio::netcdf
         std::vector<dimension> dimensions;
     };
 
+    /** \brief A variable whose id, type and shape have been looked up once
+     *
+     * Reads and writes by name look the variable up on every call, which for a small per-step write can cost
+     * more than the write. Open the variable once and pass the handle instead:
+     * \code {.cpp}
+     * const auto temperature = file.open_variable("temperature");
+     * for (...) file.write_variable<types::Double>(*temperature, values.data(), values.size(), { step, 0 }, { 1, n });
+     * \endcode
+     * \note a handle belongs to the file that opened it and stays valid until the file is redefined
+     */
+    struct variable_handle
+    {
+        std::string name;
+        int id = -1;
+        nc_type type = NC_NAT;
+        std::vector<MPI_Offset> shape; /// Length of each dimension when the handle was opened
+        int record = -1;               /// Which dimension is the record dimension (-1 if none), it may have grown since
+    };
+
     /// Information about the type of data stored in a variable entry
     struct value_info
     {
@@ -96,7 +116,11 @@ namespace pio::netcdf
             NullData,
             NullFile,
             VariableDoesntExist,
-            FailedTaskCreation
+            FailedTaskCreation,
+            UnsupportedFormat,
+            NotContiguous,
+            IndexOutOfBounds,
+            OtherProcessFailed
         };
 
         /**
@@ -136,6 +160,145 @@ namespace pio::netcdf
     template<io::access _Access, typename... _Types>
     using promise = io::promise<_Access, error_code, _Types...>;
 
+    /// Format of a file that is created \note an existing file keeps the format it was written in
+    enum class file_format
+    {
+        cdf2, /// 64-bit offsets (`NC_64BIT_OFFSET`), readable by every NetCDF library but without 64-bit integer types
+        cdf5  /// 64-bit data (`NC_64BIT_DATA`), needed for \ref types::Int64 variables and attributes
+    };
+
+    /**
+     * @brief Staging (burst-buffer) options for a writable file
+     * 
+     * When enabled, writes are first appended to a node-local log inside \ref directory (a local disk
+     * or `/dev/shm`) through PnetCDF's burst-buffer driver, so \ref promise::wait() returns as soon as the
+     * data is in the log. The log is drained into the shared file on \ref file::flush() and on
+     * \ref file::close(), only after one of those is the data durable.
+     */
+    struct staging
+    {
+        bool enabled = false;
+        std::string directory = "/dev/shm";        /// Where the node-local logs are placed
+        bool delete_on_close  = true;              /// Remove the logs once they have been drained
+        bool shared_logs      = false;             /// Use one log per node instead of one per process
+        std::optional<std::size_t> flush_size;     /// Bytes of memory used to move the log into the shared file while draining it (PnetCDF's default if empty) \note this doesn't make the log drain any sooner
+    };
+
+    /// An element block as described by the ExodusII conventions
+    struct element_block
+    {
+        int index;        /// Position of the block in the file (starting at 1), the `N` in `connect<N>`
+        long long id;     /// User-facing id of the block (from `eb_prop1`)
+        std::string type; /// Element type (the `elem_type` attribute of `connect<N>`)
+        std::string name; /// Name of the block (from `eb_names`, empty if there is none)
+        MPI_Offset elements, nodes_per_elem, attributes; /// \note for `nsided` blocks `nodes_per_elem` is the node count of the whole block
+    };
+
+    /// Everything needed to lay out an ExodusII file, see \ref file::exodus_file::define
+    struct exodus_schema
+    {
+        std::string title;
+        MPI_Offset num_nodes = 0;
+        std::vector<std::string> coordinates;       /// Coordinate names (`x`, `y`, `z`), one per dimension of the mesh, stored in `coord<name>`
+        std::vector<element_block> blocks;          /// Blocks in order, their `index` and `attributes` are ignored
+        std::vector<std::string> element_variables; /// Element variables, defined on every block
+        std::vector<std::string> nodal_variables;   /// Nodal variables, each stored in its own `vals_nod_var<V>`
+        std::vector<std::string> global_variables;  /// Global variables, stored together in `vals_glo_var`
+        bool double_precision = true;               /// Store real values as doubles rather than floats
+        bool int64 = false;                         /// Store block ids and connectivity as 64-bit integers \note the file must be created as \ref file_format::cdf5
+    };
+
+    /// The part of an ExodusII variable that one process reads
+    template<typename _Type>
+    struct exodus_section
+    {
+        std::string variable; /// The NetCDF variable being read
+        std::size_t index;    /// Index of the block (or coordinate) the section belongs to
+        promise<io::access::ro, _Type> data; /// \ref promise::view gives the values along with their offset in the variable
+    };
+
+    /** \brief Every element (and optionally nodal) variable of an ExodusII file at one time step
+     *
+     * The values of all the fields sit back to back in one buffer, so a snapshot is a single allocation however
+     * many variables and blocks the file has. Element fields come first in variable-major order, then the nodal
+     * fields. A block that the truth table leaves a variable out of gets an empty span.
+     */
+    template<typename _Type>
+    struct exodus_snapshot
+    {
+        using value_type = typename _Type::integral_type;
+
+        MPI_Offset time_step;
+        std::vector<std::string> element_variables, nodal_variables;
+        std::vector<element_block> blocks;
+
+        std::vector<value_type> values;   /// Every field, back to back
+        std::vector<std::size_t> offsets; /// Where each field starts in `values`, followed by the total size
+
+        /// Values of element variable `variable` (starting at 0) on the `block`th block
+        util::span<const value_type> element(std::size_t variable, std::size_t block) const
+        {
+            return _field(variable * blocks.size() + block);
+        }
+
+        /// Values of nodal variable `variable` (starting at 0)
+        util::span<const value_type> nodal(std::size_t variable) const
+        {
+            return _field(element_variables.size() * blocks.size() + variable);
+        }
+
+    private:
+        util::span<const value_type> _field(std::size_t i) const
+        {
+            assert(i + 1 < offsets.size());
+            return util::span<const value_type>(values.data() + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+    };
+
+    /// The values of one variable at a few entities (elements or nodes) over every time step
+    template<typename _Type>
+    struct exodus_history
+    {
+        using value_type = typename _Type::integral_type;
+
+        std::vector<MPI_Offset> entities; /// The entities, in the order they were asked for
+        std::vector<value_type> times;    /// Value of each time step
+        std::vector<value_type> values;   /// (time steps, entities) in row-major order
+
+        /// Value at the `entity`th entity asked for at a time step
+        value_type operator()(std::size_t time_step, std::size_t entity) const
+        {
+            assert(entity < entities.size() && time_step < times.size());
+            return values[time_step * entities.size() + entity];
+        }
+    };
+
+    /** \brief The part of an ExodusII mesh that one process owns, see \ref file::exodus_file::get_partition
+     *
+     * Each process keeps the connectivity of its own elements, renumbered into the nodes those elements touch.
+     * `nodes` lists them by their index in the file, in increasing order. Nodes on the boundary between
+     * partitions (ghosts) appear on every process whose elements use them.
+     */
+    template<typename _Type>
+    struct exodus_partition
+    {
+        using value_type = typename _Type::integral_type;
+
+        /// A run of owned elements of one block
+        struct range
+        {
+            std::size_t block;        /// Position of the block in the list passed in
+            MPI_Offset first, count;  /// Elements of the block, starting at 0
+        };
+
+        std::vector<range> ranges;
+        std::vector<MPI_Offset> offsets;      /// Start of each owned element (in the order of `ranges`) in `connectivity`, followed by the total
+        std::vector<MPI_Offset> connectivity; /// Local node indices, into `nodes`
+        std::vector<MPI_Offset> nodes;        /// Index in the file (starting at 0) of each local node
+        std::vector<std::string> coordinate_names;
+        std::vector<std::vector<value_type>> coordinates; /// One vector per coordinate, in the order of `nodes`
+    };
+
     /// \brief A NetCDF file
     /// \todo Add a file_type enum that specifies whether the currently contained exodus_file struct exists or not
     template<io::access _Access>
@@ -148,6 +311,14 @@ namespace pio::netcdf
             READ result<std::vector<std::string>>
             get_variables() const;
 
+            /// \brief Get the names of the nodal variables (empty if there are none)
+            READ result<std::vector<std::string>>
+            get_nodal_variables() const;
+
+            /// \brief Get the names of the global variables (empty if there are none)
+            READ result<std::vector<std::string>>
+            get_global_variables() const;
+
             /// \brief Copy the node coordinates into memory
             /// \param get_data Whether or not to read the actual node coordinates, or just read the names
             /// \note This is a blocking method
@@ -161,15 +332,163 @@ namespace pio::netcdf
             WRITE result<std::vector<std::shared_ptr<const promise<io::access::wo, types::Double>>>>
             write_node_coordinates(MPI_Comm comm, const std::unordered_map<std::string, std::vector<double>>& data);
 
+            /// \brief Get the element blocks
+            /// \note Every process reads the (small) block metadata
+            READ result<std::vector<element_block>>
+            get_blocks() const;
+
+            /// \brief Post non-blocking reads of this process' share of the connectivity of every block
+            /// \details The elements of all the blocks are divided evenly over `comm`, each process reads whole rows
+            /// of `connect<N>`. Call \ref promise::wait on every section before using its data.
+            /// \note Blocks of arbitrary polyhedra (`nsided`/`nfaced`) are skipped
+            template<typename _Type, READ_TEMP>
+            result<std::vector<exodus_section<_Type>>>
+            get_block_connectivity(MPI_Comm comm, const std::vector<element_block>& blocks) const;
+
+            /// \brief Post non-blocking reads of this process' share of an element variable at a time step
+            /// \param variable Index of the variable, starting at 1 (the `V` in `vals_elem_var<V>eb<N>`)
+            /// \param time_step Index of the time step, starting at 0
+            /// \note Blocks the variable isn't defined on are skipped
+            template<typename _Type, READ_TEMP>
+            result<std::vector<exodus_section<_Type>>>
+            get_element_variable_values(MPI_Comm comm, const std::vector<element_block>& blocks, int variable, MPI_Offset time_step) const;
+
+            /// \brief Post non-blocking reads of this process' share of the node coordinates
+            /// \note Every process reads the same nodes of each coordinate, the sections are in the order of `coor_names`
+            template<typename _Type, READ_TEMP>
+            result<std::vector<exodus_section<_Type>>>
+            read_node_coordinates(MPI_Comm comm) const;
+
+            /// \brief Read this process' share of the elements of a mesh along with the coordinates of just the nodes they use
+            /// \details Collective. The elements are split like \ref get_block_connectivity, the nodes they reference are
+            /// collected and their coordinates are fetched with one scattered request per coordinate, so memory and I/O
+            /// follow the size of the partition rather than the size of the mesh.
+            /// \note Blocks of arbitrary polyhedra (`nsided`/`nfaced`) are skipped
+            template<typename _Type, READ_TEMP>
+            result<exodus_partition<_Type>>
+            get_partition(MPI_Comm comm, const std::vector<element_block>& blocks) const;
+
+            /// \brief Post non-blocking reads of this process' share of a nodal variable at a time step
+            /// \param variable Index of the variable, starting at 1
+            /// \param time_step Index of the time step, starting at 0
+            template<typename _Type, READ_TEMP>
+            result<std::vector<exodus_section<_Type>>>
+            get_nodal_variable_values(MPI_Comm comm, int variable, MPI_Offset time_step) const;
+
+            /// \brief Post a non-blocking read of every global variable at a time step \note every process reads the (short) row
+            template<typename _Type, READ_TEMP>
+            result<promise<io::access::ro, _Type>>
+            get_global_variable_values(MPI_Offset time_step) const;
+
+            /// \brief Post a non-blocking read of the value of every time step
+            template<typename _Type, READ_TEMP>
+            result<promise<io::access::ro, _Type>>
+            get_time_values() const;
+
+            /// \brief Write a nodal variable at a time step, split evenly over `comm`
+            /// \param values The values at every node, every process passes the same data
+            /// \return The write requests of this process
+            template<typename _Type, WRITE_TEMP>
+            result<std::vector<promise<io::access::wo, _Type>>>
+            write_nodal_variable_values(MPI_Comm comm, int variable, MPI_Offset time_step, const std::vector<typename _Type::integral_type>& values);
+
+            /// \brief Write every global variable at a time step \note collective over `comm`, but only the first process of `comm` writes, the others get no requests
+            template<typename _Type, WRITE_TEMP>
+            result<std::vector<promise<io::access::wo, _Type>>>
+            write_global_variable_values(MPI_Comm comm, MPI_Offset time_step, const std::vector<typename _Type::integral_type>& values);
+
+            /// \brief Write the value of a time step \note collective over `comm`, but only the first process of `comm` writes, the others get no requests
+            template<typename _Type, WRITE_TEMP>
+            result<std::vector<promise<io::access::wo, _Type>>>
+            write_time_value(MPI_Comm comm, MPI_Offset time_step, const typename _Type::integral_type& value);
+
+            /// \brief Read every element variable, and every nodal variable if `nodal` is set, at a time step
+            /// \details The reads of all the fields are posted into the snapshot's buffer and completed by a single wait
+            /// \param time_step Index of the time step, starting at 0
+            /// \note Independent, the calling process reads the whole snapshot
+            template<typename _Type, READ_TEMP>
+            result<exodus_snapshot<_Type>>
+            get_snapshot(MPI_Offset time_step, bool nodal = false) const;
+
+            /// \brief Read the history of an element variable at a few elements
+            /// \details Collective, the time steps are split evenly over `comm` and every process reads only the requested
+            /// values of its own steps (a single `varn` request per block), then the history is gathered on every process.
+            /// \param variable Index of the variable, starting at 1
+            /// \param elements Indices of the elements, starting at 0 and counting through the blocks in order
+            template<typename _Type, READ_TEMP>
+            result<exodus_history<_Type>>
+            get_element_history(MPI_Comm comm, int variable, const std::vector<MPI_Offset>& elements) const;
+
+            /// \brief Read the history of a nodal variable at a few nodes, see \ref get_element_history
+            /// \param variable Index of the variable, starting at 1
+            /// \param nodes Indices of the nodes, starting at 0
+            template<typename _Type, READ_TEMP>
+            result<exodus_history<_Type>>
+            get_nodal_history(MPI_Comm comm, int variable, const std::vector<MPI_Offset>& nodes) const;
+
+            /// \brief Define every dimension, variable and attribute of an ExodusII file in a single define phase
+            /// \details Collective, every process must pass the same schema. The first process of `comm` then writes
+            /// the small metadata variables (block ids and names, coordinate and variable names, the truth table).
+            WRITE result<void>
+            define(MPI_Comm comm, const exodus_schema& schema);
+
+            /// \brief Write the connectivity of every block, split evenly over `comm`
+            /// \param connectivity The full connectivity of each block, every process passes the same data
+            /// \param entity_counts The node count of each element of `nsided` blocks (may be empty for other blocks)
+            /// \return The write requests of this process
+            WRITE result<std::vector<promise<io::access::wo, types::Int>>>
+            write_block_connectivity(
+                MPI_Comm comm,
+                const std::vector<element_block>& blocks,
+                const std::vector<std::vector<int>>& connectivity,
+                const std::vector<std::vector<int>>& entity_counts = {});
+
+            /// \brief Write 64-bit connectivity, see above
+            /// \note A file defined without \ref exodus_schema::int64 stores `int` connectivity, a value that doesn't fit fails its request
+            WRITE result<std::vector<promise<io::access::wo, types::Int64>>>
+            write_block_connectivity(
+                MPI_Comm comm,
+                const std::vector<element_block>& blocks,
+                const std::vector<std::vector<long long>>& connectivity,
+                const std::vector<std::vector<long long>>& entity_counts = {});
+
         private:
             friend class file;
 
             exodus_file(file* base_file);
 
+            /// Read the rows of a (count, len_name) text variable, empty if the `count` dimension doesn't exist
+            result<std::vector<std::string>> _read_names(const std::string& variable, const std::string& count) const;
+
+            /// Write the connectivity of every block with integers of type `_Type`
+            template<typename _Type>
+            result<std::vector<promise<io::access::wo, _Type>>>
+            _write_connectivity(
+                MPI_Comm comm,
+                const std::vector<element_block>& blocks,
+                const std::vector<std::vector<typename _Type::integral_type>>& connectivity,
+                const std::vector<std::vector<typename _Type::integral_type>>& entity_counts);
+
+            /// A variable and the values of it that a history needs at each time step
+            struct history_probe
+            {
+                std::string variable;
+                std::vector<MPI_Offset> prefix; /// Indices between the time step and the entity (empty for most variables)
+                std::vector<std::pair<std::size_t, MPI_Offset>> entries; /// Position in the history and index in the variable
+            };
+
+            template<typename _Type>
+            result<exodus_history<_Type>>
+            _read_history(MPI_Comm comm, const std::vector<MPI_Offset>& entities, const std::vector<history_probe>& probes) const;
+
             file* _file;
         } exodus;
 
-        file(const std::string& filename);
+        /// Open (or create) a file \note staging and the format are only respected for writable access
+        file(const std::string& filename, const staging& stage = staging(), file_format fmt = file_format::cdf2);
+
+        /// Open (or create) a dataset on another storage backend, such as a \ref memory_backend
+        file(io::backend& storage, const std::string& filename, const staging& stage = staging(), file_format fmt = file_format::cdf2);
         
         file(const file&) = delete;
         file(file&&) = delete;
@@ -202,6 +521,10 @@ namespace pio::netcdf
         READ result<variable>
         get_variable_info(const std::string& name) const;
 
+        /// Get a text attribute of a variable \note an empty variable name gets a global attribute
+        READ result<std::string>
+        get_attribute_text(const std::string& variable, const std::string& name) const;
+
         /// Get the information about the data a variable describes
         READ result<value_info>
         get_variable_value_info(const std::string& name) const;
@@ -217,13 +540,22 @@ namespace pio::netcdf
             const std::vector<MPI_Offset>& count) const;
 
         /// Produces an asynchronous request to copy a section of data from the file into memory
+        /// \note `_Type` may differ from the stored type, PnetCDF converts the values as they are read
         template<typename _Type, READ_TEMP>
-        const promise<io::access::ro, _Type>
+        promise<io::access::ro, _Type>
         get_variable_values(
             const std::string& name, 
             const std::vector<MPI_Offset>& start,
             const std::vector<MPI_Offset>& count) const;
 
+        /// Produces an asynchronous request to read a section of a variable opened with \ref open_variable
+        template<typename _Type, READ_TEMP>
+        promise<io::access::ro, _Type>
+        get_variable_values(
+            const variable_handle& variable,
+            const std::vector<MPI_Offset>& start,
+            const std::vector<MPI_Offset>& count) const;
+
         /// Get a dimension by id
         READ result<dimension>
         get_dimension(int id) const;
@@ -235,18 +567,40 @@ namespace pio::netcdf
 
         /* WRITE / READ-WRITE */
 
+        /// Defines a new dimension in the file, a length of `NC_UNLIMITED` makes it the record dimension \note The file must be in define mode or else this will give an error
+        WRITE result<void>
+        define_dimension(const std::string& name, MPI_Offset length);
+
         /// Defines a new variable in the file \note The file must be in define mode or else this will give an error
         template<typename _Type, WRITE_TEMP>
         result<void>
         define_variable(const std::string& name, const std::vector<std::string>& dim_names);
 
+        /// Defines a text attribute, an empty variable name defines a global attribute \note The file must be in define mode or else this will give an error
+        WRITE result<void>
+        define_attribute_text(const std::string& variable, const std::string& name, const std::string& text);
+
+        /// Defines a numeric attribute, an empty variable name defines a global attribute \note The file must be in define mode or else this will give an error
+        template<typename _Type, WRITE_TEMP>
+        result<void>
+        define_attribute(const std::string& variable, const std::string& name, const std::vector<typename _Type::integral_type>& values);
+
         /// Execute a routine within define mode \note The file is put into and out of define mode in the scope of this method
         WRITE result<void>
         define(std::function<result<void>()> function);
 
+        /// \brief Drain any staged writes into the shared file
+        /// \note This is collective and blocking, once it returns every completed write is durable
+        WRITE result<void>
+        flush();
+
+        /// Whether writes to this file are being staged in a node-local log
+        bool staged() const { return _staged; }
+
         /// Produces an asynchronous request to write a section of data to a variable
+        /// \note `_Type` may differ from the stored type, PnetCDF converts the values as they are written
         template<typename _Type, WRITE_TEMP>
-        const promise<io::access::wo, _Type>
+        promise<io::access::wo, _Type>
         write_variable(
             const std::string& name,
             const typename _Type::integral_type* data,
@@ -254,10 +608,56 @@ namespace pio::netcdf
             const std::vector<MPI_Offset>& offset,
             const std::vector<MPI_Offset>& count);
 
+        /// Produces an asynchronous request to write a view, its global offset and shape select the section of the variable
+        template<typename _Type, WRITE_TEMP>
+        promise<io::access::wo, _Type>
+        write_variable(const std::string& name, const util::view<const typename _Type::integral_type>& data)
+        {
+            if (!data.contiguous()) return { error_code::NotContiguous };
+            return write_variable<_Type>(name, data.data(), data.size(), data.offset(), data.shape());
+        }
+
+        /// Produces an asynchronous request to write a section of a variable opened with \ref open_variable
+        template<typename _Type, WRITE_TEMP>
+        promise<io::access::wo, _Type>
+        write_variable(
+            const variable_handle& variable,
+            const typename _Type::integral_type* data,
+            const std::size_t& size,
+            const std::vector<MPI_Offset>& offset,
+            const std::vector<MPI_Offset>& count);
+
+        /// Produces an asynchronous request to write a view to a variable opened with \ref open_variable
+        template<typename _Type, WRITE_TEMP>
+        promise<io::access::wo, _Type>
+        write_variable(const variable_handle& variable, const util::view<const typename _Type::integral_type>& data)
+        {
+            if (!data.contiguous()) return { error_code::NotContiguous };
+            return write_variable<_Type>(variable, data.data(), data.size(), data.offset(), data.shape());
+        }
+
+        /// Look a variable up once, so reads and writes through the handle skip every metadata query \note works in any access mode
+        result<variable_handle>
+        open_variable(const std::string& name) const;
+
         int get_handle() const { return handle; }
+
+        /// The backend the file is stored on, calls on \ref get_handle must go through it
+        io::backend& storage() const { return *_backend; }
     private:
+        /// Post a read of a variable that has been looked up
+        template<typename _Type>
+        promise<io::access::ro, _Type>
+        _post_read(int id, const std::string& name, const std::vector<MPI_Offset>& start, const std::vector<MPI_Offset>& count) const;
+
+        /// Post a write to a variable that has been looked up
+        template<typename _Type>
+        promise<io::access::wo, _Type>
+        _post_write(int id, const std::string& name, const typename _Type::integral_type* data, std::size_t size, const std::vector<MPI_Offset>& offset, const std::vector<MPI_Offset>& count);
+
+        io::backend* _backend;
         int handle, err;
-        bool _good;
+        bool _good, _staged;
     };
 
     // TODO: Make this return a result so we can communicate more informative errors
@@ -268,7 +668,7 @@ namespace pio::netcdf
      * be the same.
      * 
      * @tparam _Type  The type of the data from @ref io::types
-     * @tparam _Read  Access of in file (should be @ref io::access::ro or @ref io::access::rw)
+     * @tparam _Input The input file type, a @ref file with @ref io::access::ro or @ref io::access::rw or a @ref mapped_file
      * @tparam _Write Access of out file (should be @ref io::access::wo or @ref io::access::rw)
      * @param name    The name of the variable to copy
      * @param offsets The starting indices for each dimension (must be same length as dimensions of this variable)
@@ -278,12 +678,12 @@ namespace pio::netcdf
      * @return true  The copy was successful
      * @return false The copy was not successful
      */
-    template<typename _Type, io::access _Read, io::access _Write>
+    template<typename _Type, typename _Input, io::access _Write>
     static bool copy_variable(
         const std::string& name,
         const std::vector<MPI_Offset>& offsets,
         const std::vector<MPI_Offset>& counts,
-        const file<_Read>& in,
+        const _Input& in,
         file<_Write>& out
         )
     {
@@ -0,0 +1,294 @@
+/**
+ * @file queue.hh
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief Thread-safe request submission into a NetCDF file.
+ *
+ * PnetCDF calls on a file handle must come from a single thread. The submission queue lets any thread
+ * push read and write requests into a lock-free ring buffer which one funnel thread drains into PnetCDF.
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#pragma once
+
+#include "net_file.hh"
+#include "../io/ring_buffer.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cstring>
+#include <numeric>
+
+namespace pio::netcdf
+{
+    /// The completion state of a request pushed through a \ref submission_queue
+    struct ticket
+    {
+        ticket() : _done(false) { }
+
+        /// Whether the request has completed (successfully or not)
+        bool done() const { return _done.load(std::memory_order_acquire); }
+
+        /// Block until the request has completed
+        void wait() const
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _completed.wait(lock, [this]() { return done(); });
+        }
+
+        /// Whether the request completed without errors \note only meaningful once \ref done() is true
+        bool good() const { return !_error.has_value(); }
+        operator bool() const { return good(); }
+
+        const error_code& error() const { assert(_error.has_value()); return _error.value(); }
+
+    private:
+        template<io::access>
+        friend struct submission_queue;
+
+        void _complete(std::optional<error_code> error)
+        {
+            _error = std::move(error);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _done.store(true, std::memory_order_release);
+            }
+            _completed.notify_all();
+        }
+
+        std::atomic<bool> _done;
+        std::optional<error_code> _error;
+        mutable std::mutex _mutex;
+        mutable std::condition_variable _completed;
+    };
+
+    /** \brief Multi-producer request funnel for a \ref file
+     *
+     * Worker threads (for example inside an OpenMP parallel region) call \ref write or \ref read, which only
+     * pack a request into a lock-free ring buffer and return a \ref ticket. A single funnel thread owned by the
+     * queue posts the requests into PnetCDF in batches and completes each batch with a single wait.
+     * \code {.cpp}
+     * netcdf::submission_queue<io::access::rw> queue(file);
+     * #pragma omp parallel for
+     * for (std::size_t i = 0; i < fields.size(); i++)
+     *     tickets[i] = queue.write<types::Double>(names[i], fields[i].data(), fields[i].size(), offsets[i], counts[i]);
+     * for (const auto& t : tickets) t->wait();
+     * \endcode
+     *
+     * \note Data passed to \ref write and the output buffer given to \ref read must stay alive until the ticket is done
+     * \note While the queue is running, the funnel thread is the only thread that should touch the file. It makes MPI
+     * calls while the other threads may make their own, so MPI must be initialized with `MPI_THREAD_MULTIPLE`. Without
+     * it the queue doesn't start and every request fails with `FailedTaskCreation`.
+     */
+    template<io::access _Access>
+    struct submission_queue
+    {
+        submission_queue(file<_Access>& f, std::size_t capacity = 1024) :
+            _file(f),
+            _queue(capacity),
+            _running(threaded())
+        {
+            if (_running) _funnel = std::thread([this]() { _drain(); });
+        }
+
+        submission_queue(const submission_queue&) = delete;
+
+        ~submission_queue() { stop(); }
+
+        /// Whether MPI was initialized with `MPI_THREAD_MULTIPLE`, which the funnel thread needs
+        static bool threaded()
+        {
+            int provided;
+            MPI_Query_thread(&provided);
+            return provided == MPI_THREAD_MULTIPLE;
+        }
+
+        /// Whether the funnel thread is running and accepting requests
+        bool good() const { return _funnel.joinable(); }
+        operator bool() const { return good(); }
+
+        /// Finish every queued request and join the funnel thread
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _running.store(false, std::memory_order_release);
+            }
+            _ready.notify_one();
+            if (_funnel.joinable()) _funnel.join();
+        }
+
+        /// Queue an asynchronous write, equivalent to \ref file::write_variable
+        template<typename _Type, WRITE_TEMP>
+        std::shared_ptr<const ticket>
+        write(
+            const std::string& name,
+            const typename _Type::integral_type* data,
+            const std::size_t& size,
+            const std::vector<MPI_Offset>& offset,
+            const std::vector<MPI_Offset>& count)
+        {
+            return _push([&f = _file, name, data, size, offset, count]() -> posted
+            {
+                auto p = f.template write_variable<_Type>(name, data, size, offset, count);
+                if (!p) return { p.error() };
+                return { p.requests()[0], p.request_id(), p.trace_name(), [p]() { } };
+            });
+        }
+
+        /// Queue an asynchronous read into `out`, equivalent to \ref file::get_variable_values
+        /// \param out Buffer that holds at least the product of `count` values
+        template<typename _Type, READ_TEMP>
+        std::shared_ptr<const ticket>
+        read(
+            const std::string& name,
+            const std::vector<MPI_Offset>& start,
+            const std::vector<MPI_Offset>& count,
+            typename _Type::integral_type* out)
+        {
+            if (!out) return _fail(error_code::NullData);
+
+            return _push([&f = _file, name, start, count, out]() -> posted
+            {
+                auto p = f.template get_variable_values<_Type>(name, start, count);
+                if (!p) return { p.error() };
+
+                const std::size_t size = std::accumulate(count.begin(), count.end(), std::size_t(1), std::multiplies<std::size_t>());
+                return { p.requests()[0], p.request_id(), p.trace_name(), [p, out, size]() mutable
+                {
+                    std::memcpy(out, p.template data<0>(), size * sizeof(typename _Type::integral_type));
+                } };
+            });
+        }
+
+    private:
+        /// A request that has been handed to PnetCDF, or the error that kept it from being posted
+        struct posted
+        {
+            posted(error_code e) : error(std::move(e)) { }
+            posted(int id, uint64_t traced, const char* name, std::function<void()> f) : request(id), trace_id(traced), trace_name(name), finish(std::move(f)) { }
+
+            std::optional<error_code> error;
+            int request = NC_REQ_NULL;
+            uint64_t trace_id = 0;        /// The promise's traced request span, ended once the batch wait returns
+            const char* trace_name = "";
+            std::function<void()> finish; /// Runs once the request has completed, it also keeps the promise alive until then
+        };
+
+        struct request
+        {
+            std::function<posted()> post;
+            std::shared_ptr<ticket> status;
+        };
+
+        std::shared_ptr<const ticket> _push(std::function<posted()> post)
+        {
+            if (!good()) return _fail(error_code::FailedTaskCreation);
+
+            auto status = std::make_shared<ticket>();
+            request r{ std::move(post), status };
+            if (!_queue.push(std::move(r)))
+            {
+                // Full, sleep until the funnel thread has taken a batch out
+                std::unique_lock<std::mutex> lock(_mutex);
+                _space.wait(lock, [&]() { return _queue.push(std::move(r)); });
+            }
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _pushed++;
+            }
+            _ready.notify_one();
+            return status;
+        }
+
+        std::shared_ptr<const ticket> _fail(error_code error)
+        {
+            auto status = std::make_shared<ticket>();
+            status->_complete(error);
+            return status;
+        }
+
+        void _drain()
+        {
+            std::vector<std::pair<std::shared_ptr<ticket>, posted>> batch;
+            std::vector<int> requests, statuses;
+            batch.reserve(_queue.capacity());
+            std::size_t popped = 0;
+
+            for (;;)
+            {
+                // Stopping is only observed once the queue is empty, so nothing that was pushed is dropped
+                const bool running = _running.load(std::memory_order_acquire);
+
+                // Post everything that is available before waiting so PnetCDF can overlap the requests
+                while (auto r = _queue.pop())
+                {
+                    batch.emplace_back(std::move(r->status), r->post());
+                    popped++;
+                }
+
+                if (batch.empty())
+                {
+                    if (!running) return;
+
+                    // Sleep until a producer has pushed something the last pass didn't see, or the queue is stopped
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _ready.wait(lock, [&]() { return _pushed != popped || !_running.load(std::memory_order_acquire); });
+                    continue;
+                }
+
+                // Wake producers that found the buffer full, taking the lock first so none can miss this between its
+                // failed push and going to sleep
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                }
+                _space.notify_all();
+
+                // Complete the whole batch with a single wait
+                requests.clear();
+                for (const auto& [status, p] : batch)
+                    if (!p.error) requests.push_back(p.request);
+                statuses.assign(requests.size(), NC_NOERR);
+
+                int err = NC_NOERR;
+                if (!requests.empty())
+                {
+                    PIO_STATS_TIME(wait);
+                    err = _file.storage().wait(_file.get_handle(), requests.size(), requests.data(), statuses.data());
+                }
+
+                std::size_t i = 0;
+                for (auto& [status, p] : batch)
+                {
+                    if (p.error) { status->_complete(std::move(p.error)); continue; }
+                    PIO_TRACE_REQUEST_END(p.trace_name, "", 0, p.trace_id);
+
+                    const auto code = (err != NC_NOERR ? err : statuses[i]);
+                    i++;
+                    if (code != NC_NOERR) { status->_complete(netcdf_error(code)); continue; }
+
+                    p.finish();
+                    status->_complete(std::nullopt);
+                }
+                batch.clear();
+            }
+        }
+
+        file<_Access>& _file;
+        io::ring_buffer<request> _queue;
+        std::atomic<bool> _running;
+
+        // Producers and the funnel thread only meet here to sleep and wake each other, the requests themselves go through the ring buffer
+        std::mutex _mutex;
+        std::condition_variable _ready, _space;
+        std::size_t _pushed = 0;
+
+        std::thread _funnel;
+    };
+}
@@ -6,4 +6,10 @@ namespace pio {}
 #include "io.hh"
 
 #include "exodus/ex_file.hh"
-#include "netcdf/net_file.hh"
\ No newline at end of file
+#include "exodus/mesh.hh"
+#include "exodus/record_buffer.hh"
+#include "netcdf/net_file.hh"
+#include "netcdf/queue.hh"
+#include "netcdf/mmap_file.hh"
+#include "netcdf/memory_backend.hh"
+#include "netcdf/checkpoint.hh"
\ No newline at end of file
@@ -0,0 +1,46 @@
+/**
+ * @file check.hh
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief Minimal assertions for the tests, which run under `mpiexec` and report through their exit code.
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#pragma once
+
+#include "pio/pio.hh"
+
+#include <iostream>
+
+namespace pio::test
+{
+    inline int failures = 0;
+
+    /// Record a failed check
+    inline void fail(const char* file, int line, const char* expression)
+    {
+        int rank;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        std::cerr << "[" << rank << "] " << file << ":" << line << ": CHECK(" << expression << ") failed\n";
+        failures++;
+    }
+
+    /// \brief Finish a test, the exit code is non-zero if any check failed on any process \note collective
+    inline int finish()
+    {
+        int total = 0;
+        MPI_Allreduce(&failures, &total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Finalize();
+        return total ? 1 : 0;
+    }
+}
+
+/// Check a condition and carry on if it doesn't hold
+#define CHECK(expression) do { if (!(expression)) pio::test::fail(__FILE__, __LINE__, #expression); } while (0)
+
+/// Check a condition and abort every process if it doesn't hold, for when the rest of the test depends on it
+#define REQUIRE(expression) do { if (!(expression)) { pio::test::fail(__FILE__, __LINE__, #expression); MPI_Abort(MPI_COMM_WORLD, 1); } } while (0)
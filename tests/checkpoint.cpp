@@ -0,0 +1,249 @@
+/**
+ * @file checkpoint.cpp
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief Checkpoints written on one number of processes and restarted on another.
+ *
+ * Run with `write` to write `checkpoint.nc` and three generations of an incremental checkpoint, then with `read`
+ * on a different number of processes to restart from them.
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#include "check.hh"
+
+#include <cstdio>
+
+using namespace pio;
+
+namespace
+{
+
+const MPI_Offset rows = 12, columns = 3;
+const long long big = 3000000000LL; /// Doesn't fit an `int`
+
+double density(MPI_Offset r, MPI_Offset c) { return r * columns + c + 0.5; }
+
+/// This process' rows when the array is split over `size` processes
+std::pair<MPI_Offset, MPI_Offset> share(int rank, int size)
+{
+    const auto first = rank * rows / size;
+    return { first, (rank + 1) * rows / size - first };
+}
+
+/// Value of `density` in generation `g` of the incremental checkpoint, only the first and last two rows change
+double density(MPI_Offset r, MPI_Offset c, std::size_t g)
+{
+    return density(r, c) + (r < 2 && g >= 1 ? 100 : 0) + (r >= rows - 2 && g >= 2 ? 1000 : 0);
+}
+
+/// Every process' piece of a 2D double field and a 1D 64-bit integer field
+struct pieces
+{
+    std::vector<double> density;
+    std::vector<long long> ids;
+    MPI_Offset first, count;
+
+    pieces(int rank, int size)
+    {
+        std::tie(first, count) = share(rank, size);
+        for (MPI_Offset r = first; r < first + count; r++)
+        {
+            ids.push_back(big + r);
+            for (MPI_Offset c = 0; c < columns; c++) density.push_back(::density(r, c));
+        }
+    }
+
+    /// Add the pieces to a \ref netcdf::checkpoint or \ref netcdf::incremental_checkpoint
+    template<typename _Checkpoint>
+    netcdf::result<void> add(_Checkpoint& checkpoint) const
+    {
+        const auto a = checkpoint.template add<types::Double>("density", { rows, columns }, util::view<const double>(density.data(), { count, columns }, { first, 0 }));
+        if (!a) return { a.error() };
+        const auto b = checkpoint.template add<types::Int64>("ids", { rows }, util::view<const long long>(ids.data(), { count }, { first }));
+        if (!b) return { b.error() };
+        return { };
+    }
+};
+
+/// 64-bit integer fields need a CDF-5 file, and the checkpoint reads back on the same processes
+void formats(netcdf::memory_backend& memory)
+{
+    const pieces local(0, 1);
+    netcdf::checkpoint checkpoint;
+    REQUIRE(local.add(checkpoint));
+
+    {
+        netcdf::file<io::access::wo> file(memory, "cdf2.nc");
+        REQUIRE(file);
+        CHECK(!checkpoint.write(file));
+    }
+    {
+        netcdf::file<io::access::wo> file(memory, "cdf5.nc", netcdf::staging(), netcdf::file_format::cdf5);
+        REQUIRE(file);
+        CHECK(checkpoint.write(file));
+    }
+
+    netcdf::file<io::access::ro> file(memory, "cdf5.nc");
+    REQUIRE(file);
+    const auto ids = netcdf::read_checkpoint<types::Int64>(MPI_COMM_SELF, file, { "ids" });
+    REQUIRE(ids);
+    std::vector<long long> all;
+    for (const auto& slice : *ids) all.insert(all.end(), slice.values.begin(), slice.values.end());
+    CHECK(all == local.ids);
+}
+
+/// Write `checkpoint.nc` from every process
+void write()
+{
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    const pieces local(rank, size);
+    netcdf::checkpoint checkpoint;
+    REQUIRE(local.add(checkpoint));
+    CHECK(checkpoint.write("checkpoint.nc"));
+
+    // Chunks of two rows, so each generation after the first rewrites a single chunk of `density`
+    netcdf::incremental_checkpoint incremental(MPI_COMM_WORLD, "incremental", 2 * columns * sizeof(double));
+    auto changing = local;
+    for (std::size_t g = 0; g < 3; g++)
+    {
+        for (MPI_Offset r = 0; r < local.count; r++)
+            for (MPI_Offset c = 0; c < columns; c++)
+                changing.density[r * columns + c] = density(local.first + r, c, g);
+
+        REQUIRE(changing.add(incremental));
+        const auto written = incremental.write();
+        REQUIRE(written);
+        CHECK(*written == g);
+
+        unsigned long long bytes[2] = { incremental.written_bytes(), incremental.skipped_bytes() };
+        MPI_Allreduce(MPI_IN_PLACE, bytes, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        const auto total = rows * columns * sizeof(double) + rows * sizeof(long long);
+        CHECK(bytes[0] + bytes[1] == total);
+        CHECK(bytes[0] == (g ? 2 * columns * sizeof(double) : total));
+    }
+}
+
+/// Restart from `checkpoint.nc`, every value read lands where it was written whatever the process count was
+void read()
+{
+    netcdf::file<io::access::ro> file("checkpoint.nc");
+    REQUIRE(file);
+
+    long long values = 0;
+
+    const auto density = netcdf::read_checkpoint<types::Double>(MPI_COMM_WORLD, file, { "density" });
+    REQUIRE(density);
+    for (const auto& slice : *density)
+    {
+        REQUIRE(slice.offsets.size() == 2);
+        for (MPI_Offset r = 0; r < slice.counts[0]; r++)
+            for (MPI_Offset c = 0; c < slice.counts[1]; c++)
+                CHECK(slice.values[r * slice.counts[1] + c] == ::density(slice.offsets[0] + r, slice.offsets[1] + c));
+        values += slice.values.size();
+    }
+
+    const auto ids = netcdf::read_checkpoint<types::Int64>(MPI_COMM_WORLD, file, { "ids" });
+    REQUIRE(ids);
+    for (const auto& slice : *ids)
+    {
+        REQUIRE(slice.offsets.size() == 1);
+        for (MPI_Offset r = 0; r < slice.counts[0]; r++)
+            CHECK(slice.values[r] == big + slice.offsets[0] + r);
+        values += slice.values.size();
+    }
+
+    // Between them, the processes read every value exactly once
+    MPI_Allreduce(MPI_IN_PLACE, &values, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    CHECK(values == rows * columns + rows);
+
+    // A slice naming a missing variable fails on its own process, the others still finish their reads
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<netcdf::checkpoint_slice<types::Double>> slices(1);
+    slices[0].name = (rank ? "density" : "missing");
+    slices[0].offsets = { 0, 0 };
+    slices[0].counts = { 1, columns };
+    const auto mixed = netcdf::read_checkpoint<types::Double>(file, std::move(slices));
+    CHECK(rank ? bool(mixed) : !mixed);
+}
+
+/// Restart from every generation of the incremental checkpoint, following each manifest back to the chunks that didn't change
+void read_incremental()
+{
+    for (std::size_t g = 0; g < 3; g++)
+    {
+        long long values = 0;
+
+        const auto density = netcdf::read_incremental_checkpoint<types::Double>(MPI_COMM_WORLD, "incremental", g, { "density" });
+        REQUIRE(density);
+        for (const auto& slice : *density)
+        {
+            for (MPI_Offset r = 0; r < slice.counts[0]; r++)
+                for (MPI_Offset c = 0; c < slice.counts[1]; c++)
+                    CHECK(slice.values[r * slice.counts[1] + c] == ::density(slice.offsets[0] + r, slice.offsets[1] + c, g));
+            values += slice.values.size();
+        }
+
+        // Every chunk of `ids` is only in the first generation
+        const auto ids = netcdf::read_incremental_checkpoint<types::Int64>(MPI_COMM_WORLD, "incremental", g, { "ids" });
+        REQUIRE(ids);
+        for (const auto& slice : *ids)
+        {
+            for (MPI_Offset r = 0; r < slice.counts[0]; r++)
+                CHECK(slice.values[r] == big + slice.offsets[0] + r);
+            values += slice.values.size();
+        }
+
+        MPI_Allreduce(MPI_IN_PLACE, &values, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        CHECK(values == rows * columns + rows);
+    }
+
+    // A slice out of bounds on one process fails the read on every process, none is left opening generations alone
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<netcdf::checkpoint_slice<types::Double>> slices(1);
+    slices[0].name = "density";
+    slices[0].offsets = { 0, 0 };
+    slices[0].counts = { (rank ? 1 : rows + 1), columns };
+    CHECK(!netcdf::read_incremental_checkpoint_slices<types::Double>(MPI_COMM_WORLD, "incremental", 2, std::move(slices)));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+
+    const std::string mode = (argc > 1 ? argv[1] : "");
+    if (mode == "write")
+    {
+        netcdf::memory_backend memory;
+        formats(memory);
+        write();
+    }
+    else if (mode == "read")
+    {
+        read();
+        read_incremental();
+
+        int rank;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Barrier(MPI_COMM_WORLD);
+        if (!rank)
+        {
+            std::remove("checkpoint.nc");
+            for (std::size_t g = 0; g < 3; g++) std::remove(netcdf::incremental_checkpoint::path("incremental", g).c_str());
+        }
+    }
+    else
+        CHECK(!"the mode should be write or read");
+
+    return test::finish();
+}
@@ -0,0 +1,191 @@
+/**
+ * @file exodus_float.cpp
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief Round trips through a 4-byte \ref pio::exodus::file, which carries reals as `float`, and the block type helpers.
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#include "check.hh"
+
+#include <cstdio>
+
+using namespace pio;
+
+namespace
+{
+
+/// A file with one block of `elements` elements over as many nodes, one element variable and `times` time steps
+template<typename _Word>
+void write_mesh(exodus::file<_Word, io::access::wo>& file, const exodus::coordinates<_Word>& coords, const std::vector<exodus::real<_Word>>& times, exodus::block<_Word>& block)
+{
+    exodus::info<_Word> info;
+    info.title = "float";
+    info.num_dim = 3;
+    info.num_nodes = coords.x.size();
+    info.num_elem = block.info.elements;
+    info.num_elem_blk = 1;
+    REQUIRE(file.set_init_params(info));
+    REQUIRE(file.create_block(block.info));
+    REQUIRE(file.set_node_coordinates(coords));
+
+    REQUIRE(file.set_variable_count(exodus::scope::element, 1));
+    REQUIRE(file.set_variable_names(exodus::scope::element, { "stress" }));
+
+    const auto first = file.write_time_steps(times.data(), times.size());
+    REQUIRE(first);
+    CHECK(*first == 1);
+    for (std::size_t i = 0; i < times.size(); i++)
+    {
+        for (auto& v : block.data->at("stress")) v += 1;
+        REQUIRE(file.set_block_data("stress", *first + i, block));
+    }
+}
+
+template<typename _Word>
+exodus::block<_Word> make_block(std::size_t elements)
+{
+    exodus::block<_Word> block;
+    block.info = { "SPHERE", "spheres", 1, exodus::integer<_Word>(elements), 1, 0, 0, 0 };
+    block.data.emplace();
+    auto& stress = (*block.data)["stress"];
+    for (std::size_t i = 0; i < elements; i++) stress.push_back(exodus::real<_Word>(i) / 8);
+    return block;
+}
+
+/// Coordinates, time values and element data written as floats read back unchanged
+void round_trip()
+{
+    const std::size_t n = 6;
+    exodus::coordinates<unsigned int> coords;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        coords.x.push_back(i + 0.125f);
+        coords.y.push_back(i + 0.25f);
+        coords.z.push_back(i + 0.1f); // not exact in binary, but the same float on the way in and out
+    }
+    const std::vector<float> times = { 0.0f, 0.1f, 0.2f };
+    auto block = make_block<unsigned int>(n);
+    {
+        exodus::file<unsigned int, io::access::wo> file("float.exo", true);
+        REQUIRE(file);
+        write_mesh(file, coords, times, block);
+    }
+
+    // A file that couldn't be created takes no time steps
+    {
+        exodus::file<unsigned int, io::access::wo> bad("missing/float.exo", true);
+        CHECK(!bad);
+        CHECK(!bad.write_time_steps(times.data(), times.size()));
+    }
+
+    exodus::file<unsigned int, io::access::ro> file("float.exo");
+    REQUIRE(file);
+
+    const auto read = file.get_node_coordinates();
+    REQUIRE(read);
+    CHECK(read->x == coords.x);
+    CHECK(read->y == coords.y);
+    CHECK(read->z == coords.z);
+
+    const auto steps = file.get_time_values();
+    REQUIRE(steps);
+    CHECK(*steps == times);
+
+    const auto header = file.get_block_header(1);
+    REQUIRE(header);
+    CHECK(header->elements == (int32_t)n);
+
+    // The last step holds what was written last, the first one what was written first
+    exodus::block<unsigned int> last;
+    last.info = *header;
+    REQUIRE(file.get_block_data("stress", times.size(), last));
+    CHECK(last.data->at("stress") == block.data->at("stress"));
+
+    exodus::block<unsigned int> first;
+    first.info = *header;
+    REQUIRE(file.get_block_data("stress", 1, first));
+    for (std::size_t i = 0; i < n; i++)
+        CHECK(first.data->at("stress")[i] == block.data->at("stress")[i] - (times.size() - 1));
+
+    CHECK(!file.get_block_data("missing", 1, first));
+    CHECK(!file.get_variable_index(exodus::scope::element, "missing"));
+    CHECK(*file.get_variable_index(exodus::scope::element, "stress") == 1);
+}
+
+/// A double precision file reads through a 4-byte instance, each value rounded to the nearest float
+void double_as_float()
+{
+    const std::size_t n = 4;
+    exodus::coordinates<unsigned long> coords;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        coords.x.push_back(i + 0.1);
+        coords.y.push_back(i + 1.0 / 3);
+        coords.z.push_back(-(i + 0.7));
+    }
+    const std::vector<double> times = { 0.1, 1e-3 };
+    auto block = make_block<unsigned long>(n);
+    {
+        exodus::file<unsigned long, io::access::wo> file("double.exo", true);
+        REQUIRE(file);
+        write_mesh(file, coords, times, block);
+    }
+
+    const auto narrow = [](const std::vector<double>& values)
+    {
+        return std::vector<float>(values.begin(), values.end());
+    };
+
+    exodus::file<unsigned int, io::access::ro> file("double.exo");
+    REQUIRE(file);
+
+    const auto info = file.get_info();
+    REQUIRE(info);
+    CHECK(info->num_nodes == (int32_t)n);
+
+    const auto read = file.get_node_coordinates();
+    REQUIRE(read);
+    CHECK(read->x == narrow(coords.x));
+    CHECK(read->y == narrow(coords.y));
+    CHECK(read->z == narrow(coords.z));
+
+    const auto steps = file.get_time_values();
+    REQUIRE(steps);
+    CHECK(*steps == narrow(times));
+
+    const auto header = file.get_block_header(1);
+    REQUIRE(header);
+    exodus::block<unsigned int> data;
+    data.info = *header;
+    REQUIRE(file.get_block_data("stress", times.size(), data));
+    CHECK(data.data->at("stress") == narrow(block.data->at("stress")));
+}
+
+/// Block types are matched ignoring case, as libexodus does
+void block_types()
+{
+    CHECK(exodus::nsided("nsided") && exodus::nsided("NSIDED") && exodus::nsided("NSided"));
+    CHECK(exodus::nfaced("nfaced") && exodus::nfaced("NFACED"));
+    CHECK(!exodus::nsided("nfaced") && !exodus::nsided("nside") && !exodus::nsided("HEX8"));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+
+    round_trip();
+    double_as_float();
+    block_types();
+
+    std::remove("float.exo");
+    std::remove("double.exo");
+
+    return test::finish();
+}
@@ -0,0 +1,357 @@
+/**
+ * @file memory_backend.cpp
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief Round trips through \ref pio::netcdf::file on a \ref pio::netcdf::memory_backend.
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#include "check.hh"
+
+using namespace pio;
+
+#define RES_CHECK(res) { const auto r = res; if (!r) return { r.error() }; }
+
+namespace
+{
+
+/// The status string of a request that succeeded
+std::string ok() { return ncmpi_strerror(NC_NOERR); }
+
+/// Define, write and read back variables, attributes and records through promises
+void round_trip(netcdf::memory_backend& memory)
+{
+    const std::vector<double> values = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0 };
+    const std::vector<int> steps = { 10, 20, 30 };
+    {
+        netcdf::file<io::access::wo> file(memory, "round_trip.nc");
+        REQUIRE(file);
+
+        const auto defined = file.define([&]() -> netcdf::result<void>
+        {
+            RES_CHECK(file.define_dimension("time_step", NC_UNLIMITED));
+            RES_CHECK(file.define_dimension("rows", 2));
+            RES_CHECK(file.define_dimension("columns", 3));
+            RES_CHECK(file.define_variable<types::Double>("values", { "rows", "columns" }));
+            RES_CHECK(file.define_variable<types::Int>("steps", { "time_step" }));
+            RES_CHECK(file.define_attribute_text("", "title", "memory"));
+            RES_CHECK(file.define_attribute<types::Float>("values", "scale", { 0.5f }));
+            return { };
+        });
+        REQUIRE(defined);
+
+        // Neither write is carried out until it is waited on, so the record dimension grows only then
+        const auto a = file.write_variable<types::Double>("values", values.data(), values.size(), { 0, 0 }, { 2, 3 });
+        const auto b = file.write_variable<types::Int>("steps", steps.data(), steps.size(), { 0 }, { 3 });
+        REQUIRE(a && b);
+        CHECK(file.get_dimension("time_step")->length == 0);
+        CHECK(a.wait()[0] == ok());
+        CHECK(b.wait()[0] == ok());
+        CHECK(file.get_dimension("time_step")->length == 3);
+
+        // A write outside a fixed dimension is turned down when it's posted and doesn't add records
+        const auto bad = file.write_variable<types::Int>("steps", steps.data(), 1, { 5 }, { 2 });
+        CHECK(!bad);
+        CHECK(file.get_dimension("time_step")->length == 3);
+
+        const auto outside = file.write_variable<types::Double>("values", values.data(), 3, { 2, 0 }, { 1, 3 });
+        CHECK(!outside);
+    }
+
+    CHECK(memory.exists("round_trip.nc"));
+
+    netcdf::file<io::access::ro> file(memory, "round_trip.nc");
+    REQUIRE(file);
+
+    const auto read = file.read_variable_sync<types::Double>("values", { 0, 0 }, { 2, 3 });
+    REQUIRE(read);
+    CHECK(*read == values);
+
+    // Values are converted to the type asked for, like PnetCDF does
+    auto column = file.get_variable_values<types::Float>("values", { 0, 1 }, { 2, 1 });
+    REQUIRE(column);
+    CHECK(column.wait()[0] == ok());
+    CHECK(column.get_data<0>() == std::vector<float>({ 2.0f, 5.0f }));
+
+    const auto records = file.read_variable_sync<types::Int>("steps", { 1 }, { 2 });
+    REQUIRE(records);
+    CHECK(*records == std::vector<int>({ 20, 30 }));
+
+    const auto title = file.get_attribute_text("", "title");
+    CHECK(title && *title == "memory");
+
+    // Reading past the last record is an error
+    CHECK(!file.read_variable_sync<types::Int>("steps", { 2 }, { 2 }));
+}
+
+/// PnetCDF's rules are enforced
+void rules(netcdf::memory_backend& memory)
+{
+    netcdf::file<io::access::wo> file(memory, "rules.nc");
+    REQUIRE(file);
+
+    const auto defined = file.define([&]() -> netcdf::result<void>
+    {
+        RES_CHECK(file.define_dimension("n", 4));
+
+        // A classic (CDF-2) file can't hold 64-bit integers, nor can it have two record dimensions
+        CHECK(!file.define_variable<types::Int64>("big", { "n" }));
+        RES_CHECK(file.define_dimension("time", NC_UNLIMITED));
+        CHECK(!file.define_dimension("other", NC_UNLIMITED));
+
+        RES_CHECK(file.define_variable<types::Int>("small", { "n" }));
+        return { };
+    });
+    REQUIRE(defined);
+
+    // Definitions are only allowed in define mode
+    CHECK(!file.define_dimension("late", 2));
+
+    // Text and numbers don't convert into each other
+    const char text[] = "abcd";
+    CHECK(!file.write_variable<types::Char>("small", text, 4, { 0 }, { 4 }));
+
+    // The data must match the section exactly
+    const std::vector<int> values = { 1, 2, 3 };
+    CHECK(!file.write_variable<types::Int>("small", values.data(), values.size(), { 0 }, { 4 }));
+}
+
+/// The ExodusII helpers run unchanged on memory
+void exodus_mesh(netcdf::memory_backend& memory)
+{
+    netcdf::exodus_schema schema;
+    schema.title = "two hexes";
+    schema.num_nodes = 12;
+    schema.coordinates = { "x", "y", "z" };
+    schema.element_variables = { "color" };
+
+    netcdf::element_block block;
+    block.id = 7;
+    block.type = "HEX8";
+    block.name = "block";
+    block.elements = 2;
+    block.nodes_per_elem = 8;
+    schema.blocks = { block };
+
+    std::unordered_map<std::string, std::vector<double>> coordinates;
+    for (const auto& name : schema.coordinates)
+        for (int i = 0; i < schema.num_nodes; i++)
+            coordinates[name].push_back(i + (name == "x" ? 0.0 : name == "y" ? 0.25 : 0.5));
+
+    const std::vector<std::vector<int>> connectivity = { { 1, 2, 5, 4, 7, 8, 11, 10, 2, 3, 6, 5, 8, 9, 12, 11 } };
+
+    // Every process has its own copy of the dataset, so each one writes all of it
+    {
+        netcdf::file<io::access::wo> file(memory, "mesh.exo");
+        REQUIRE(file);
+        REQUIRE(file.exodus.define(MPI_COMM_SELF, schema));
+
+        const auto conn = file.exodus.write_block_connectivity(MPI_COMM_SELF, schema.blocks, connectivity, { });
+        REQUIRE(conn);
+        for (const auto& p : *conn) p.wait();
+
+        const auto coords = file.exodus.write_node_coordinates(MPI_COMM_SELF, coordinates);
+        REQUIRE(coords);
+        for (const auto& p : *coords) p->wait();
+    }
+
+    netcdf::file<io::access::ro> file(memory, "mesh.exo");
+    REQUIRE(file);
+
+    const auto blocks = file.exodus.get_blocks();
+    REQUIRE(blocks && blocks->size() == 1);
+    CHECK(blocks->front().id == 7);
+    CHECK(blocks->front().type == "HEX8");
+    CHECK(blocks->front().elements == 2);
+
+    const auto variables = file.exodus.get_variables();
+    CHECK(variables && *variables == schema.element_variables);
+
+    const auto read = file.exodus.get_node_coordinates();
+    REQUIRE(read);
+    CHECK(*read == coordinates);
+
+    const auto conn = file.read_variable_sync<types::Int>("connect1", { 0, 0 }, { 2, 8 });
+    REQUIRE(conn);
+    CHECK(*conn == connectivity.front());
+
+    // A partition over one process owns every element and every node
+    const auto partition = file.exodus.get_partition<types::Double>(MPI_COMM_SELF, *blocks);
+    REQUIRE(partition);
+    CHECK(partition->nodes.size() == (std::size_t)schema.num_nodes);
+    CHECK(partition->coordinate_names == schema.coordinates);
+    for (std::size_t d = 0; d < schema.coordinates.size(); d++)
+        CHECK(partition->coordinates[d] == coordinates[schema.coordinates[d]]);
+
+    // A mesh without coordinates leaves `num_dim` out rather than making it a second record dimension
+    netcdf::exodus_schema bare;
+    bare.title = "no nodes";
+    bare.blocks = { block };
+    netcdf::file<io::access::wo> out(memory, "bare.exo");
+    REQUIRE(out);
+    CHECK(out.exodus.define(MPI_COMM_SELF, bare));
+    CHECK(!out.get_dimension("num_dim"));
+}
+
+/// Time steps, global and nodal variables written over time read back through snapshots and histories
+void exodus_steps(netcdf::memory_backend& memory)
+{
+    netcdf::element_block block;
+    block.id = 1;
+    block.type = "BAR2";
+    block.elements = 3;
+    block.nodes_per_elem = 2;
+
+    netcdf::exodus_schema schema;
+    schema.title = "steps";
+    schema.num_nodes = 4;
+    schema.coordinates = { "x" };
+    schema.blocks = { block };
+    schema.nodal_variables = { "temperature" };
+    schema.global_variables = { "energy" };
+
+    const std::vector<double> times = { 0.0, 0.5 };
+    const std::vector<std::vector<double>> temperature = { { 1, 2, 3, 4 }, { 5, 6, 7, 8 } };
+    const std::vector<std::vector<double>> energy = { { 10 }, { 20 } };
+    {
+        netcdf::file<io::access::wo> file(memory, "steps.exo");
+        REQUIRE(file);
+        REQUIRE(file.exodus.define(MPI_COMM_SELF, schema));
+
+        for (std::size_t t = 0; t < times.size(); t++)
+        {
+            const auto time = file.exodus.write_time_value<types::Double>(MPI_COMM_SELF, t, times[t]);
+            const auto global = file.exodus.write_global_variable_values<types::Double>(MPI_COMM_SELF, t, energy[t]);
+            const auto nodal = file.exodus.write_nodal_variable_values<types::Double>(MPI_COMM_SELF, 1, t, temperature[t]);
+            REQUIRE(time && global && nodal);
+            for (const auto& p : *time) CHECK(p.wait()[0] == ok());
+            for (const auto& p : *global) CHECK(p.wait()[0] == ok());
+            for (const auto& p : *nodal) CHECK(p.wait()[0] == ok());
+        }
+    }
+
+    netcdf::file<io::access::ro> file(memory, "steps.exo");
+    REQUIRE(file);
+
+    const auto snapshot = file.exodus.get_snapshot<types::Double>(1, true);
+    REQUIRE(snapshot);
+    CHECK(snapshot->nodal_variables == schema.nodal_variables);
+    const auto nodal = snapshot->nodal(0);
+    CHECK(std::vector<double>(nodal.begin(), nodal.end()) == temperature[1]);
+
+    const auto history = file.exodus.get_nodal_history<types::Double>(MPI_COMM_SELF, 1, { 3, 0 });
+    REQUIRE(history);
+    CHECK(history->times == times);
+    CHECK(history->values == std::vector<double>({ 4, 1, 8, 5 }));
+}
+
+/// 64-bit connectivity needs a 64-bit schema in a CDF-5 file, and values that don't fit an `int` are never truncated
+void exodus_int64(netcdf::memory_backend& memory)
+{
+    netcdf::element_block block;
+    block.id = 1;
+    block.type = "BAR2";
+    block.elements = 1;
+    block.nodes_per_elem = 2;
+
+    netcdf::exodus_schema schema;
+    schema.title = "large";
+    schema.blocks = { block };
+    schema.int64 = true;
+
+    const std::vector<std::vector<long long>> connectivity = { { 1, 3000000000LL } };
+
+    // A CDF-2 file can't hold the 64-bit variables
+    {
+        netcdf::file<io::access::wo> file(memory, "int64-cdf2.exo");
+        REQUIRE(file);
+        CHECK(!file.exodus.define(MPI_COMM_SELF, schema));
+    }
+
+    {
+        netcdf::file<io::access::wo> file(memory, "int64.exo", netcdf::staging(), netcdf::file_format::cdf5);
+        REQUIRE(file);
+        REQUIRE(file.exodus.define(MPI_COMM_SELF, schema));
+
+        const auto conn = file.exodus.write_block_connectivity(MPI_COMM_SELF, schema.blocks, connectivity);
+        REQUIRE(conn);
+        for (const auto& p : *conn) CHECK(p.wait()[0] == ok());
+    }
+    {
+        netcdf::file<io::access::ro> file(memory, "int64.exo");
+        REQUIRE(file);
+        const auto read = file.read_variable_sync<types::Int64>("connect1", { 0, 0 }, { 1, 2 });
+        REQUIRE(read);
+        CHECK(*read == connectivity.front());
+    }
+
+    // Without a 64-bit schema the connectivity is stored as `int`, so the request fails instead of wrapping
+    schema.int64 = false;
+    netcdf::file<io::access::wo> file(memory, "int32.exo");
+    REQUIRE(file);
+    REQUIRE(file.exodus.define(MPI_COMM_SELF, schema));
+    const auto conn = file.exodus.write_block_connectivity(MPI_COMM_SELF, schema.blocks, connectivity);
+    REQUIRE(conn);
+    for (const auto& p : *conn) CHECK(p.wait()[0] != ok());
+}
+
+/// A dataset flushed into a real file reads back through PnetCDF
+void flush(netcdf::memory_backend& memory)
+{
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // Each process writes its own row, so the flushed file is assembled from every process
+    std::vector<double> row(4, rank);
+    {
+        netcdf::file<io::access::wo> file(memory, "flushed.nc");
+        REQUIRE(file);
+        const auto defined = file.define([&]() -> netcdf::result<void>
+        {
+            RES_CHECK(file.define_dimension("ranks", size));
+            RES_CHECK(file.define_dimension("n", 4));
+            RES_CHECK(file.define_variable<types::Double>("rows", { "ranks", "n" }));
+            return { };
+        });
+        REQUIRE(defined);
+        const auto p = file.write_variable<types::Double>("rows", row.data(), row.size(), { rank, 0 }, { 1, 4 });
+        REQUIRE(p);
+        p.wait();
+    }
+
+    CHECK(memory.flush("flushed.nc", "memory_backend.nc"));
+    CHECK(!memory.flush("missing.nc", "missing.nc"));
+
+    netcdf::file<io::access::ro> file("memory_backend.nc");
+    REQUIRE(file);
+    const auto all = file.read_variable_sync<types::Double>("rows", { 0, 0 }, { size, 4 });
+    REQUIRE(all);
+    for (int r = 0; r < size; r++)
+        for (int i = 0; i < 4; i++)
+            CHECK((*all)[r * 4 + i] == r);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+
+    netcdf::memory_backend memory;
+    round_trip(memory);
+    rules(memory);
+    exodus_mesh(memory);
+    exodus_steps(memory);
+    exodus_int64(memory);
+    flush(memory);
+
+    memory.remove("round_trip.nc");
+    CHECK(!memory.exists("round_trip.nc"));
+
+    return test::finish();
+}
@@ -0,0 +1,109 @@
+/**
+ * @file trace.cpp
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief Every traced request span ends, however its request is completed.
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#include "check.hh"
+
+#include <set>
+
+#ifndef PIO_INSTRUMENT
+#error "the trace test needs pio built with PIO_ENABLE_INSTRUMENTATION"
+#endif
+
+using namespace pio;
+
+namespace
+{
+
+/// The request spans that have begun but not ended
+struct open_spans
+{
+    std::set<uint64_t> open;
+    std::size_t begun = 0;
+
+    io::trace::hooks hooks()
+    {
+        return {
+            [this](const io::trace::event& e) { if (e.type == io::trace::kind::request) { open.insert(e.request); begun++; } },
+            [this](const io::trace::event& e) { if (e.type == io::trace::kind::request) open.erase(e.request); }
+        };
+    }
+};
+
+}
+
+int main(int argc, char** argv)
+{
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    open_spans spans;
+    io::trace::install(spans.hooks());
+
+    netcdf::memory_backend memory;
+    std::vector<double> piece(4, rank);
+    {
+        netcdf::file<io::access::wo> file(memory, "trace.nc");
+        REQUIRE(file);
+        const auto defined = file.define([&]() -> netcdf::result<void>
+        {
+            const auto dim = file.define_dimension("n", 4);
+            if (!dim) return { dim.error() };
+            return file.define_variable<types::Double>("values", { "n" });
+        });
+        REQUIRE(defined);
+
+        // One promise waited on by itself, two completed by a single collective wait
+        const auto single = file.write_variable<types::Double>("values", piece.data(), 2, { 0 }, { 2 });
+        REQUIRE(single);
+        single.wait();
+
+        std::vector<netcdf::promise<io::access::wo, types::Double>> promises;
+        promises.push_back(file.write_variable<types::Double>("values", piece.data(), 1, { 2 }, { 1 }));
+        promises.push_back(file.write_variable<types::Double>("values", piece.data(), 1, { 3 }, { 1 }));
+        std::vector<int> requests;
+        for (auto& p : promises) { REQUIRE(p); requests.push_back(*p.requests()); }
+        std::vector<int> statuses(requests.size());
+        CHECK(file.storage().end_indep_data(file.get_handle()) == NC_NOERR);
+        CHECK(file.storage().wait_all(file.get_handle(), requests.size(), requests.data(), statuses.data()) == NC_NOERR);
+        for (const auto& p : promises) p.completed();
+    }
+    CHECK(spans.begun == 3);
+    CHECK(spans.open.empty());
+
+    // Raw requests completed by one collective wait
+    {
+        netcdf::checkpoint checkpoint;
+        REQUIRE(checkpoint.add<types::Double>("field", { size * 4 }, util::view<const double>(piece.data(), { 4 }, { rank * 4 })));
+        netcdf::file<io::access::wo> file(memory, "checkpoint.nc");
+        REQUIRE(file);
+        CHECK(checkpoint.write(file));
+    }
+    {
+        netcdf::file<io::access::ro> file(memory, "checkpoint.nc");
+        REQUIRE(file);
+        netcdf::checkpoint_slice<types::Double> slice;
+        slice.name = "field";
+        slice.offsets = { rank * 4 };
+        slice.counts = { 4 };
+        const auto read = netcdf::read_checkpoint<types::Double>(file, { slice });
+        REQUIRE(read);
+        CHECK(read->front().values == piece);
+    }
+    CHECK(spans.begun == 5);
+    CHECK(spans.open.empty());
+
+    io::trace::uninstall();
+    return test::finish();
+}
@@ -0,0 +1,160 @@
+/**
+ * @file distsim.cpp
+ * @author Max Ortner (mortner@lanl.gov)
+ * @brief Offline simulation of \ref pio::io::distributor decompositions.
+ *
+ * Evaluates how a set of volumes would be split over hypothetical process counts without launching MPI
+ * and prints a JSON report per process count.
+ *
+ * \verbatim
+ * pio-distsim --processes 1024,100000 --volume double:1000x1000x100 --volume int:5000000 [--per-rank]
+ * \endverbatim
+ *
+ * @version 0.1
+ * @date 2023-10-05
+ *
+ * @copyright Copyright (c) 2023, Triad National Security, LLC
+ *
+ */
+
+#include "pio/pio.hh"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace pio;
+
+namespace
+{
+
+std::optional<nc_type> parse_type(const std::string& name)
+{
+    if (name == "double") return NC_DOUBLE;
+    if (name == "float")  return NC_FLOAT;
+    if (name == "int")    return NC_INT;
+    if (name == "char")   return NC_CHAR;
+    return std::nullopt;
+}
+
+/// Parses all of `text` as an integer in [min, max] \throws std::invalid_argument or std::out_of_range holding `text`
+long long parse_integer(const std::string& text, long long min, long long max)
+{
+    std::size_t end = 0;
+    long long value;
+    try { value = std::stoll(text, &end); }
+    catch (const std::out_of_range&) { throw std::out_of_range(text); }
+    catch (const std::invalid_argument&) { throw std::invalid_argument(text); }
+
+    if (end != text.size()) throw std::invalid_argument(text);
+    if (value < min || value > max) throw std::out_of_range(text);
+    return value;
+}
+
+/// Parses `type:AxBxC`
+std::optional<io::distributor::volume> parse_volume(const std::string& spec, uint32_t index)
+{
+    const auto colon = spec.find(':');
+    if (colon == std::string::npos) return std::nullopt;
+
+    const auto type = parse_type(spec.substr(0, colon));
+    if (!type) return std::nullopt;
+
+    io::distributor::volume vol;
+    vol.data_index = index;
+    vol.data_type = *type;
+
+    std::stringstream ss(spec.substr(colon + 1));
+    std::string dim;
+    while (std::getline(ss, dim, 'x'))
+        vol.dimensions.push_back(parse_integer(dim, 0, LLONG_MAX));
+    if (vol.dimensions.empty()) return std::nullopt;
+
+    return vol;
+}
+
+void usage(const char* program)
+{
+    std::cerr << "usage: " << program << " --processes N[,M...] --volume type:AxBxC [--volume ...] [--per-rank]\n";
+}
+
+template<typename T>
+void print_array(std::ostream& out, const std::vector<T>& values)
+{
+    out << "[";
+    for (std::size_t i = 0; i < values.size(); i++) out << (i ? ", " : "") << values[i];
+    out << "]";
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<int> processes;
+    std::vector<io::distributor::volume> volumes;
+    bool per_rank = false;
+
+    // A malformed or out of range number anywhere in the arguments is reported like missing arguments
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string key = argv[i];
+            if (key == "--per-rank") { per_rank = true; continue; }
+            if (i + 1 >= argc) break;
+
+            const std::string value = argv[++i];
+            if (key == "--processes")
+            {
+                std::stringstream ss(value);
+                std::string p;
+                while (std::getline(ss, p, ',')) processes.push_back(parse_integer(p, INT_MIN, INT_MAX));
+            }
+            else if (key == "--volume")
+            {
+                const auto vol = parse_volume(value, volumes.size());
+                if (!vol) { std::cerr << "invalid volume \"" << value << "\", expected type:AxBxC\n"; return 1; }
+                volumes.push_back(*vol);
+            }
+        }
+    }
+    catch (const std::logic_error& e)
+    {
+        std::cerr << "invalid number \"" << e.what() << "\"\n";
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Counts below one can't be simulated, dropping them before printing keeps the separators right
+    processes.erase(std::remove_if(processes.begin(), processes.end(), [](int p) { return p < 1; }), processes.end());
+
+    if (processes.empty() || volumes.empty())
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::cout << "[\n";
+    for (std::size_t i = 0; i < processes.size(); i++)
+    {
+        const auto r = io::distributor::simulate(volumes, processes[i]);
+
+        std::cout << "  {\"processes\": " << r.processes
+                  << ", \"planning_seconds\": " << r.planning_seconds
+                  << ", \"max_bytes\": " << r.max_bytes
+                  << ", \"mean_bytes\": " << r.mean_bytes
+                  << ", \"imbalance\": " << r.imbalance
+                  << ", \"max_extents\": " << r.max_extents;
+        if (per_rank)
+        {
+            std::cout << ", \"bytes\": ";   print_array(std::cout, r.bytes);
+            std::cout << ", \"extents\": "; print_array(std::cout, r.extents);
+        }
+        std::cout << "}" << (i + 1 < processes.size() ? ",\n" : "\n");
+    }
+    std::cout << "]\n";
+
+    return 0;
+}